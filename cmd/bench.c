@@ -0,0 +1,468 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Storage benchmark command
+ *
+ * Runs sequential or random read/write patterns against a block device,
+ * SPI flash or MTD device and reports throughput, IOPS and latency.
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <command.h>
+#include <console.h>
+#include <div64.h>
+#include <malloc.h>
+#include <spi.h>
+#include <spi_flash.h>
+#include <linux/math64.h>
+#include <linux/mtd/mtd.h>
+
+/**
+ * struct bench_dev - A device to benchmark
+ *
+ * @size:	Size of the device in bytes
+ * @align:	Transfers must be a multiple of this many bytes
+ * @erase_size:	Erase-block size in bytes, or 0 if writes need no erase
+ * @read:	Read @len bytes from @offset into @buf
+ * @write:	Write @len bytes from @buf to @offset
+ * @erase:	Erase @len bytes from @offset (NULL if @erase_size is 0)
+ */
+struct bench_dev {
+	u64 size;
+	ulong align;
+	ulong erase_size;
+	int (*read)(struct bench_dev *bdev, u64 offset, ulong len, void *buf);
+	int (*write)(struct bench_dev *bdev, u64 offset, ulong len,
+		     const void *buf);
+	int (*erase)(struct bench_dev *bdev, u64 offset, ulong len);
+	union {
+		struct blk_desc *desc;
+		struct spi_flash *flash;
+		struct mtd_info *mtd;
+	};
+};
+
+enum bench_test {
+	BENCH_READ,
+	BENCH_WRITE,
+	BENCH_RANDREAD,
+	BENCH_RANDWRITE,
+};
+
+static const char *const bench_test_name[] = {
+	"read", "write", "randread", "randwrite",
+};
+
+static int bench_blk_read(struct bench_dev *bdev, u64 offset, ulong len,
+			  void *buf)
+{
+	struct blk_desc *desc = bdev->desc;
+	lbaint_t blkcnt = len / desc->blksz;
+
+	/* Make sure that each read reaches the device */
+	blkcache_invalidate(desc->if_type, desc->devnum);
+	if (blk_dread(desc, lldiv(offset, desc->blksz), blkcnt, buf) != blkcnt)
+		return -EIO;
+
+	return 0;
+}
+
+static int bench_blk_write(struct bench_dev *bdev, u64 offset, ulong len,
+			   const void *buf)
+{
+	struct blk_desc *desc = bdev->desc;
+	lbaint_t blkcnt = len / desc->blksz;
+
+	if (blk_dwrite(desc, lldiv(offset, desc->blksz), blkcnt, buf) != blkcnt)
+		return -EIO;
+
+	return 0;
+}
+
+static int bench_blk_setup(struct bench_dev *bdev, const char *ifname,
+			   const char *devstr)
+{
+	struct blk_desc *desc;
+
+	if (blk_get_device_by_str(ifname, devstr, &desc) < 0)
+		return -ENODEV;
+	bdev->desc = desc;
+	bdev->size = (u64)desc->lba * desc->blksz;
+	bdev->align = desc->blksz;
+	bdev->read = bench_blk_read;
+	bdev->write = bench_blk_write;
+
+	return 0;
+}
+
+#ifdef CONFIG_SPI_FLASH
+static int bench_sf_read(struct bench_dev *bdev, u64 offset, ulong len,
+			 void *buf)
+{
+	return spi_flash_read(bdev->flash, offset, len, buf);
+}
+
+static int bench_sf_write(struct bench_dev *bdev, u64 offset, ulong len,
+			  const void *buf)
+{
+	return spi_flash_write(bdev->flash, offset, len, buf);
+}
+
+static int bench_sf_erase(struct bench_dev *bdev, u64 offset, ulong len)
+{
+	return spi_flash_erase(bdev->flash, offset, len);
+}
+
+static int bench_sf_setup(struct bench_dev *bdev, const char *devstr)
+{
+	unsigned int bus = CONFIG_SF_DEFAULT_BUS;
+	unsigned int cs;
+	char *endp;
+
+	cs = simple_strtoul(devstr, &endp, 0);
+	if (*endp == ':') {
+		bus = cs;
+		cs = simple_strtoul(endp + 1, &endp, 0);
+	}
+	if (*devstr == 0 || *endp != 0)
+		return -EINVAL;
+
+	bdev->flash = spi_flash_probe(bus, cs, CONFIG_SF_DEFAULT_SPEED,
+				      CONFIG_SF_DEFAULT_MODE);
+	if (!bdev->flash)
+		return -ENODEV;
+	bdev->size = bdev->flash->size;
+	bdev->align = 1;
+	bdev->erase_size = bdev->flash->erase_size;
+	bdev->read = bench_sf_read;
+	bdev->write = bench_sf_write;
+	bdev->erase = bench_sf_erase;
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_MTD_DEVICE
+static int bench_mtd_read(struct bench_dev *bdev, u64 offset, ulong len,
+			  void *buf)
+{
+	size_t retlen;
+	int ret;
+
+	ret = mtd_read(bdev->mtd, offset, len, &retlen, buf);
+	if (ret == -EUCLEAN)
+		ret = 0;
+
+	return ret ? ret : retlen == len ? 0 : -EIO;
+}
+
+static int bench_mtd_write(struct bench_dev *bdev, u64 offset, ulong len,
+			   const void *buf)
+{
+	size_t retlen;
+	int ret;
+
+	ret = mtd_write(bdev->mtd, offset, len, &retlen, buf);
+
+	return ret ? ret : retlen == len ? 0 : -EIO;
+}
+
+static int bench_mtd_erase(struct bench_dev *bdev, u64 offset, ulong len)
+{
+	struct erase_info instr = {
+		.mtd = bdev->mtd,
+		.addr = offset,
+		.len = len,
+	};
+
+	return mtd_erase(bdev->mtd, &instr);
+}
+
+static int bench_mtd_setup(struct bench_dev *bdev, const char *name)
+{
+	struct mtd_info *mtd;
+
+	mtd = get_mtd_device_nm(name);
+	if (IS_ERR_OR_NULL(mtd))
+		return -ENODEV;
+	bdev->mtd = mtd;
+	bdev->size = mtd->size;
+	bdev->align = mtd->writesize;
+	bdev->erase_size = mtd->erasesize;
+	bdev->read = bench_mtd_read;
+	bdev->write = bench_mtd_write;
+	bdev->erase = bench_mtd_erase;
+
+	return 0;
+}
+#endif
+
+/* Simple LCG so that random runs are repeatable from one boot to the next */
+static u32 bench_rand(u32 *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+
+	return *seed >> 8;
+}
+
+static bool bench_aligned(u64 val, ulong align)
+{
+	return !do_div(val, align);
+}
+
+static ulong bench_gcd(ulong a, ulong b)
+{
+	while (b) {
+		ulong t = a % b;
+
+		a = b;
+		b = t;
+	}
+
+	return a;
+}
+
+/*
+ * Stepping through the blocks by a stride which is coprime to their number
+ * visits each block exactly once. Start from about 0.618 of the range so
+ * that consecutive blocks are far apart.
+ */
+static ulong bench_stride(ulong nblocks)
+{
+	ulong stride = lldiv((u64)nblocks * 618, 1000) + 1;
+
+	while (bench_gcd(stride, nblocks) != 1)
+		stride++;
+
+	return stride;
+}
+
+/*
+ * Latencies are counted in a histogram with power-of-two buckets: bucket 0
+ * holds 0us and bucket n holds 2^(n-1) to 2^n - 1us. This needs no memory
+ * per operation, at the cost of percentiles which are only known to within
+ * a factor of two.
+ */
+#define BENCH_HIST_SIZE		32
+
+struct bench_stats {
+	ulong min_us;
+	ulong max_us;
+	u64 total_us;
+	ulong hist[BENCH_HIST_SIZE];
+};
+
+static void bench_add(struct bench_stats *stats, ulong us)
+{
+	stats->total_us += us;
+	stats->min_us = min(stats->min_us, us);
+	stats->max_us = max(stats->max_us, us);
+	stats->hist[min(fls(us), BENCH_HIST_SIZE - 1)]++;
+}
+
+/* Get an upper bound for the latency of @pct percent of @ops operations */
+static ulong bench_percentile(struct bench_stats *stats, ulong ops, uint pct)
+{
+	ulong want = DIV_ROUND_UP((u64)ops * pct, 100), seen = 0;
+	int i;
+
+	for (i = 0; i < BENCH_HIST_SIZE - 1; i++) {
+		seen += stats->hist[i];
+		if (seen >= want)
+			break;
+	}
+
+	return min((1UL << i) - 1, stats->max_us);
+}
+
+static void bench_report(const char *name, ulong ops, u64 bytes,
+			 struct bench_stats *stats)
+{
+	u64 total_us = stats->total_us;
+	u64 rate;
+	uint frac;
+
+	if (!total_us)
+		total_us = 1;
+
+	/* One byte per microsecond is one MB/s */
+	rate = div64_u64(bytes * 100, total_us);
+	frac = do_div(rate, 100);
+	printf("%s: %llu bytes in %llu us, %llu.%02u MB/s, %llu IOPS\n",
+	       name, bytes, total_us, rate, frac,
+	       div64_u64((u64)ops * 1000000, total_us));
+	printf("latency us: min %lu avg %llu max %lu p50 %lu p90 %lu p99 %lu\n",
+	       stats->min_us, div64_u64(total_us, ops), stats->max_us,
+	       bench_percentile(stats, ops, 50),
+	       bench_percentile(stats, ops, 90),
+	       bench_percentile(stats, ops, 99));
+}
+
+static int bench_run(struct bench_dev *bdev, enum bench_test test,
+		     u64 offset, u64 len, ulong bs)
+{
+	bool is_write = test == BENCH_WRITE || test == BENCH_RANDWRITE;
+	bool is_rand = test == BENCH_RANDREAD || test == BENCH_RANDWRITE;
+	ulong ops, nblocks, stride, next = 0, i;
+	struct bench_stats stats;
+	u32 seed = 1;
+	void *buf;
+	int ret = 0;
+
+	if (!bs || bs % bdev->align || !bench_aligned(offset, bdev->align)) {
+		printf("Size and offset must be a multiple of %#lx\n",
+		       bdev->align);
+		return -EINVAL;
+	}
+	if (offset + len > bdev->size || len < bs) {
+		printf("Range %#llx+%#llx is outside the device (size %#llx)\n",
+		       offset, len, bdev->size);
+		return -EINVAL;
+	}
+	nblocks = lldiv(len, bs);
+	ops = nblocks;
+	stride = bench_stride(nblocks);
+
+	buf = memalign(ARCH_DMA_MINALIGN, bs);
+	if (!buf)
+		return -ENOMEM;
+	for (i = 0; i < bs; i++)
+		((u8 *)buf)[i] = i;
+	memset(&stats, '\0', sizeof(stats));
+	stats.min_us = ~0UL;
+
+	if (is_write && bdev->erase_size) {
+		u64 erase_len = (u64)nblocks * bs;
+		ulong start;
+
+		if (!bench_aligned(offset, bdev->erase_size) ||
+		    !bench_aligned(erase_len, bdev->erase_size)) {
+			printf("Write range must be a multiple of erase size %#lx\n",
+			       bdev->erase_size);
+			ret = -EINVAL;
+			goto out;
+		}
+		start = timer_get_us();
+		ret = bdev->erase(bdev, offset, erase_len);
+		if (ret)
+			goto out;
+		printf("erase: %llu bytes in %lu us\n", erase_len,
+		       timer_get_us() - start);
+	}
+
+	for (i = 0; i < ops; i++) {
+		u64 pos = offset;
+		ulong start, us;
+
+		if (is_rand) {
+			/*
+			 * Flash cannot be rewritten without an erase, so
+			 * visit each block once, in a scattered order
+			 */
+			if (is_write && bdev->erase_size) {
+				pos += (u64)next * bs;
+				next = (next + stride) % nblocks;
+			} else {
+				pos += (u64)(bench_rand(&seed) % nblocks) * bs;
+			}
+		} else {
+			pos += (u64)i * bs;
+		}
+		start = timer_get_us();
+		if (is_write)
+			ret = bdev->write(bdev, pos, bs, buf);
+		else
+			ret = bdev->read(bdev, pos, bs, buf);
+		us = timer_get_us() - start;
+		if (ret) {
+			printf("%s failed at %#llx (err=%d)\n",
+			       is_write ? "Write" : "Read", pos, ret);
+			goto out;
+		}
+		bench_add(&stats, us);
+		if (ctrlc()) {
+			ret = -EINTR;
+			goto out;
+		}
+	}
+	bench_report(bench_test_name[test], ops, (u64)ops * bs, &stats);
+
+out:
+	free(buf);
+
+	return ret;
+}
+
+static int do_bench(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct bench_dev bdev;
+	u64 offset, len;
+	ulong bs;
+	int test;
+	int ret;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+
+	memset(&bdev, '\0', sizeof(bdev));
+	if (!strcmp(argv[1], "blk")) {
+		if (argc < 4)
+			return CMD_RET_USAGE;
+		ret = bench_blk_setup(&bdev, argv[2], argv[3]);
+		argc -= 4;
+		argv += 4;
+#ifdef CONFIG_SPI_FLASH
+	} else if (!strcmp(argv[1], "sf")) {
+		ret = bench_sf_setup(&bdev, argv[2]);
+		argc -= 3;
+		argv += 3;
+#endif
+#ifdef CONFIG_MTD_DEVICE
+	} else if (!strcmp(argv[1], "mtd")) {
+		ret = bench_mtd_setup(&bdev, argv[2]);
+		argc -= 3;
+		argv += 3;
+#endif
+	} else {
+		return CMD_RET_USAGE;
+	}
+	if (ret) {
+		printf("Cannot find device (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+	if (argc != 4)
+		return CMD_RET_USAGE;
+
+	for (test = 0; test < ARRAY_SIZE(bench_test_name); test++) {
+		if (!strcmp(argv[0], bench_test_name[test]))
+			break;
+	}
+	if (test == ARRAY_SIZE(bench_test_name))
+		return CMD_RET_USAGE;
+	offset = simple_strtoull(argv[1], NULL, 16);
+	len = simple_strtoull(argv[2], NULL, 16);
+	bs = simple_strtoul(argv[3], NULL, 16);
+
+	ret = bench_run(&bdev, test, offset, len, bs);
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	bench, 8, 0, do_bench,
+	"storage benchmark",
+	"blk <interface> <dev> <test> <offset> <len> <bs>\n"
+#ifdef CONFIG_SPI_FLASH
+	"bench sf [<bus>:]<cs> <test> <offset> <len> <bs>\n"
+#endif
+#ifdef CONFIG_MTD_DEVICE
+	"bench mtd <name> <test> <offset> <len> <bs>\n"
+#endif
+	"    - run <test> over <len> bytes from <offset> in transfers of\n"
+	"      <bs> bytes and show MB/s, IOPS and the min/avg/max and\n"
+	"      50th/90th/99th percentile latency\n"
+	"      (all values in hex)\n"
+	"    <test> is one of read, write, randread, randwrite\n"
+	"    Write tests destroy the data in the range; on flash devices the\n"
+	"    range is erased first and random writes visit each block once"
+);
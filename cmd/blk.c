@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Block-device I/O statistics
+ */
+#include <common.h>
+#include <blk.h>
+#include <command.h>
+#include <dm.h>
+#include <div64.h>
+#include <dm/uclass-internal.h>
+
+static const char *const blk_stats_op_name[BLK_STATS_OP_COUNT] = {
+	"read", "write", "erase",
+};
+
+static void blk_show_op_stats(const char *name, struct blk_op_stats *st,
+			      ulong blksz)
+{
+	ulong avg_us = lldiv(st->total_us, st->ops);
+	u32 total_ms = lldiv(st->total_us, 1000);
+	int i;
+
+	printf("  %-6s %8lu ops %10llu blocks %8lu errors\n", name, st->ops,
+	       st->blocks, st->errors);
+	printf("         %10llu us total, min %lu / avg %lu / max %lu us",
+	       st->total_us, st->min_us, avg_us, st->max_us);
+	if (total_ms)
+		printf(", %llu KiB/s",
+		       lldiv((st->blocks * blksz >> 10) * 1000, total_ms));
+	printf("\n         size histogram (blocks):");
+	for (i = 0; i < BLK_STATS_HIST_COUNT; i++) {
+		if (!st->hist[i])
+			continue;
+		printf(" %lu%s:%lu", 1UL << i,
+		       i == BLK_STATS_HIST_COUNT - 1 ? "+" : "", st->hist[i]);
+	}
+	printf("\n");
+}
+
+static int do_blk_stats(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	bool reset = argc > 1 && !strcmp(argv[1], "reset");
+	struct udevice *dev;
+	int op;
+
+	if (argc > 2 || (argc == 2 && !reset))
+		return CMD_RET_USAGE;
+
+	for (uclass_find_first_device(UCLASS_BLK, &dev);
+	     dev;
+	     uclass_find_next_device(&dev)) {
+		struct blk_desc *desc = dev_get_uclass_platdata(dev);
+		bool header = false;
+
+		if (reset) {
+			blk_reset_stats(dev);
+			continue;
+		}
+		for (op = 0; op < BLK_STATS_OP_COUNT; op++) {
+			struct blk_op_stats *st = &desc->stats.op[op];
+
+			if (!st->ops)
+				continue;
+			if (!header) {
+				printf("%s (%s %d, %lu-byte blocks):\n",
+				       dev->name, blk_get_if_type_name(
+				       desc->if_type), desc->devnum,
+				       desc->blksz);
+				header = true;
+			}
+			blk_show_op_stats(blk_stats_op_name[op], st,
+					  desc->blksz);
+		}
+	}
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_blk_sub[] = {
+	U_BOOT_CMD_MKENT(stats, 2, 0, do_blk_stats, "", ""),
+};
+
+static int do_blk(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* Strip off leading argument */
+	argc--;
+	argv++;
+
+	c = find_cmd_tbl(argv[0], cmd_blk_sub, ARRAY_SIZE(cmd_blk_sub));
+	if (!c)
+		return CMD_RET_USAGE;
+
+	return c->cmd(cmdtp, flag, argc, argv);
+}
+
+U_BOOT_CMD(
+	blk, 3, 0, do_blk,
+	"block-device diagnostics",
+	"stats - show I/O statistics for each block device\n"
+	"blk stats reset - clear I/O statistics"
+);
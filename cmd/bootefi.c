@@ -327,10 +327,12 @@ static efi_status_t do_bootefi_exec(void *efi,
 #endif
 
 	ret = efi_do_enter(loaded_image_info_obj.handle, &systab, entry);
+	/* Persist the variables the image may have changed */
+	efi_variables_commit();
 
 exit:
 	/* image has returned, loaded-image obj goes *poof*: */
-	list_del(&loaded_image_info_obj.link);
+	efi_remove_handle(&loaded_image_info_obj);
 
 	return ret;
 }
@@ -436,7 +438,7 @@ static int do_bootefi(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		r = efi_selftest(loaded_image_info_obj.handle, &systab);
 		efi_restore_gd();
 		free(loaded_image_info.load_options);
-		list_del(&loaded_image_info_obj.link);
+		efi_remove_handle(&loaded_image_info_obj);
 		return r != EFI_SUCCESS;
 	} else
 #endif
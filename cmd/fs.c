@@ -40,7 +40,10 @@ U_BOOT_CMD(
 	"      'bytes' gives the size to load in bytes.\n"
 	"      If 'bytes' is 0 or omitted, the file is read until the end.\n"
 	"      'pos' gives the file byte position to start reading from.\n"
-	"      If 'pos' is 0 or omitted, the file is read from the start."
+	"      If 'pos' is 0 or omitted, the file is read from the start.\n"
+	"      If 'addr' is '-', 'filename' must be a FIT with external data.\n"
+	"      It is loaded so that the kernel of its default configuration\n"
+	"      lies at the kernel load address and needs no copy."
 )
 
 static int do_save_wrapper(cmd_tbl_t *cmdtp, int flag, int argc,
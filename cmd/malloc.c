@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Show usage information for the malloc() pool
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+
+static int do_malloc_stats(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	struct malloc_info info;
+	ulong frag = 0;
+	int i;
+
+	malloc_get_info(&info);
+	if (info.free >= 100)
+		frag = (info.free - info.largest) / (info.free / 100);
+
+	printf("pool:    %#lx bytes\n", info.pool);
+	printf("in use:  %#lx bytes\n", info.in_use);
+	printf("peak:    %#lx bytes\n", info.peak);
+	printf("free:    %#lx bytes in %lu blocks, largest %#lx (%lu%% fragmented)\n",
+	       info.free, info.free_blocks, info.largest, frag);
+	printf("cached:  %#lx bytes\n", info.cached);
+
+	puts("\nsize          count\n");
+	for (i = 0; i < MALLOC_STATS_CLASSES - 1; i++)
+		printf("<= %-8lu  %lu\n", 16UL << i, info.count[i]);
+	printf(">  %-8lu  %lu\n", 16UL << (i - 1), info.count[i]);
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_malloc_sub[] = {
+	U_BOOT_CMD_MKENT(stats, 1, 1, do_malloc_stats, "", ""),
+};
+
+static int do_malloc(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* Strip off leading 'malloc' command argument */
+	argc--;
+	argv++;
+
+	c = find_cmd_tbl(argv[0], cmd_malloc_sub, ARRAY_SIZE(cmd_malloc_sub));
+	if (c)
+		return c->cmd(cmdtp, flag, argc, argv);
+	else
+		return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(malloc, 2, 1, do_malloc,
+	"malloc() pool information",
+	"stats - show usage, fragmentation and allocations by size"
+);
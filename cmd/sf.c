@@ -14,6 +14,7 @@
 #include <spi_flash.h>
 #include <jffs2/jffs2.h>
 #include <linux/mtd/mtd.h>
+#include <u-boot/crc.h>
 
 #include <asm/io.h>
 #include <dm/device-internal.h>
@@ -198,18 +199,86 @@ static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
 	return NULL;
 }
 
+/**
+ * Erase and write a run of complete sectors which are known to differ from
+ * what is in the flash, using a single erase and a single write operation.
+ *
+ * @param flash		flash context pointer
+ * @param offset	flash offset to write (sector-aligned)
+ * @param len		number of bytes to write (multiple of the sector size)
+ * @param buf		buffer to write from
+ * @return NULL if OK, else a string containing the stage which failed
+ */
+static const char *spi_flash_update_run(struct spi_flash *flash, u32 offset,
+					size_t len, const char *buf)
+{
+	if (!len)
+		return NULL;
+
+	debug("Update run %x size %zx\n", offset, len);
+	if (spi_flash_erase(flash, offset, len))
+		return "erase";
+	if (spi_flash_write(flash, offset, len, buf))
+		return "write";
+
+	return NULL;
+}
+
+/**
+ * Check whether a complete sector needs to be rewritten
+ *
+ * If @hashes is provided, the CRC32 of the new data is compared with the
+ * stored value for the sector, so the flash is not read at all. Otherwise
+ * the sector is read back into @cmp_buf and compared with the new data.
+ *
+ * @param flash		flash context pointer
+ * @param offset	flash offset of the sector
+ * @param buf		new data for the sector
+ * @param cmp_buf	read buffer to use to compare data
+ * @param hashp		pointer to the stored big-endian CRC32 of the sector
+ *			contents, or NULL to compare against the flash
+ * @param changedp	set to true if the sector differs, false if not
+ * @return NULL if OK, else a string containing the stage which failed
+ */
+static const char *spi_flash_sector_changed(struct spi_flash *flash,
+		u32 offset, const char *buf, char *cmp_buf, const u32 *hashp,
+		bool *changedp)
+{
+	if (hashp) {
+		*changedp = crc32(0, (const uchar *)buf, flash->sector_size) !=
+			be32_to_cpu(*hashp);
+		return NULL;
+	}
+	if (spi_flash_read(flash, offset, flash->sector_size, cmp_buf))
+		return "read";
+	*changedp = memcmp(cmp_buf, buf, flash->sector_size) != 0;
+
+	return NULL;
+}
+
 /**
  * Update an area of SPI flash by erasing and writing any blocks which need
  * to change. Existing blocks with the correct data are left unchanged.
  *
+ * Contiguous sectors which need to change are collected and erased/written
+ * together, which is much faster than handling them one sector at a time.
+ *
+ * If a hash manifest is provided it must hold one big-endian CRC32 value
+ * per sector of the area, covering the current flash contents (for a
+ * partial final sector, only the bytes being written). Sectors are then
+ * compared by hash instead of being read back. On success the manifest is
+ * updated in place to describe the new contents, so it can be saved for
+ * the next update.
+ *
  * @param flash		flash context pointer
  * @param offset	flash offset to write
  * @param len		number of bytes to write
  * @param buf		buffer to write from
+ * @param hashes	hash manifest, or NULL to compare against the flash
  * @return 0 if ok, 1 on error
  */
 static int spi_flash_update(struct spi_flash *flash, u32 offset,
-		size_t len, const char *buf)
+		size_t len, const char *buf, u32 *hashes)
 {
 	const char *err_oper = NULL;
 	char *cmp_buf;
@@ -219,6 +288,10 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 	const ulong start_time = get_timer(0);
 	size_t scale = 1;
 	const char *start_buf = buf;
+	const char *run_buf = buf;	/* start of pending run of sectors */
+	u32 run_offset = offset;
+	size_t run_len = 0;
+	u32 *hashp = hashes;
 	ulong delta;
 
 	if (end - buf >= 200)
@@ -228,6 +301,8 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 		ulong last_update = get_timer(0);
 
 		for (; buf < end && !err_oper; buf += todo, offset += todo) {
+			bool changed;
+
 			todo = min_t(size_t, end - buf, flash->sector_size);
 			if (get_timer(last_update) > 100) {
 				printf("   \rUpdating, %zu%% %lu B/s",
@@ -236,9 +311,45 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 							 start_time));
 				last_update = get_timer(0);
 			}
-			err_oper = spi_flash_update_block(flash, offset, todo,
-					buf, cmp_buf, &skipped);
+			if (todo != flash->sector_size) {
+				err_oper = spi_flash_update_run(flash,
+						run_offset, run_len, run_buf);
+				run_len = 0;
+				if (err_oper)
+					break;
+				if (hashp && crc32(0, (const uchar *)buf,
+						   todo) == be32_to_cpu(*hashp)) {
+					skipped += todo;
+					continue;
+				}
+				err_oper = spi_flash_update_block(flash, offset,
+						todo, buf, cmp_buf, &skipped);
+				continue;
+			}
+			err_oper = spi_flash_sector_changed(flash, offset, buf,
+					cmp_buf, hashp, &changed);
+			if (hashp)
+				hashp++;
+			if (err_oper)
+				break;
+			if (changed) {
+				if (!run_len) {
+					run_buf = buf;
+					run_offset = offset;
+				}
+				run_len += todo;
+				continue;
+			}
+			debug("Skip region %x size %zx: no change\n",
+			      offset, todo);
+			skipped += todo;
+			err_oper = spi_flash_update_run(flash, run_offset,
+							run_len, run_buf);
+			run_len = 0;
 		}
+		if (!err_oper)
+			err_oper = spi_flash_update_run(flash, run_offset,
+							run_len, run_buf);
 	} else {
 		err_oper = "malloc";
 	}
@@ -249,6 +360,13 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 		return 1;
 	}
 
+	/* Record the new contents so the manifest can be saved */
+	for (hashp = hashes, buf = start_buf; hashes && buf < end;
+	     buf += todo, hashp++) {
+		todo = min_t(size_t, end - buf, flash->sector_size);
+		*hashp = cpu_to_be32(crc32(0, (const uchar *)buf, todo));
+	}
+
 	delta = get_timer(start_time);
 	printf("%zu bytes written, %zu bytes skipped", len - skipped,
 	       skipped);
@@ -260,7 +378,8 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 
 static int do_spi_flash_read_write(int argc, char * const argv[])
 {
-	unsigned long addr;
+	unsigned long addr, hash_addr = 0;
+	bool use_hashes = false;
 	void *buf;
 	char *endp;
 	int ret = 1;
@@ -274,6 +393,17 @@ static int do_spi_flash_read_write(int argc, char * const argv[])
 	if (*argv[1] == 0 || *endp != 0)
 		return -1;
 
+	/* update may be given a hash manifest after the length */
+	if (argc == 5) {
+		if (strcmp(argv[0], "update"))
+			return -1;
+		hash_addr = simple_strtoul(argv[4], &endp, 16);
+		if (*argv[4] == 0 || *endp != 0)
+			return -1;
+		use_hashes = true;
+		argc--;
+	}
+
 	if (mtd_arg_off_size(argc - 2, &argv[2], &dev, &offset, &len,
 			     &maxsize, MTD_DEV_TYPE_NOR, flash->size))
 		return -1;
@@ -292,7 +422,17 @@ static int do_spi_flash_read_write(int argc, char * const argv[])
 	}
 
 	if (strcmp(argv[0], "update") == 0) {
-		ret = spi_flash_update(flash, offset, len, buf);
+		u32 *hashes = NULL;
+		ulong hash_len = 0;
+
+		if (use_hashes && flash->sector_size) {
+			hash_len = DIV_ROUND_UP(len, flash->sector_size) *
+				sizeof(u32);
+			hashes = map_sysmem(hash_addr, hash_len);
+		}
+		ret = spi_flash_update(flash, offset, len, buf, hashes);
+		if (hashes)
+			unmap_sysmem(hashes);
 	} else if (strncmp(argv[0], "read", 4) == 0 ||
 			strncmp(argv[0], "write", 5) == 0) {
 		int read;
@@ -596,7 +736,7 @@ usage:
 #endif
 
 U_BOOT_CMD(
-	sf,	5,	1,	do_spi_flash,
+	sf,	6,	1,	do_spi_flash,
 	"SPI flash sub-system",
 	"probe [[bus:]cs] [hz] [mode]	- init flash device on given SPI bus\n"
 	"				  and chip select\n"
@@ -612,6 +752,12 @@ U_BOOT_CMD(
 	"sf update addr offset|partition len	- erase and write `len' bytes from memory\n"
 	"					  at `addr' to flash at `offset'\n"
 	"					  or to start of mtd `partition'\n"
+	"sf update addr offset|partition len hashaddr\n"
+	"					- as above, but compare sectors\n"
+	"					  using the CRC32 manifest at\n"
+	"					  `hashaddr' instead of reading\n"
+	"					  the flash; the manifest is\n"
+	"					  updated to match\n"
 	"sf protect lock/unlock sector len	- protect/unprotect 'len' bytes starting\n"
 	"					  at address 'sector'\n"
 	SF_TEST_HELP
@@ -15,6 +15,7 @@
 #include <dm.h>
 #include <fdtdec.h>
 #include <fs.h>
+#include <handoff.h>
 #include <i2c.h>
 #include <initcall.h>
 #include <malloc.h>
@@ -184,6 +185,43 @@ __weak int dram_init_banksize(void)
 	return 0;
 }
 
+/* Use the DRAM size from SPL if available, else work it out */
+static int initf_dram(void)
+{
+	struct handoff_dram *dram;
+	int ret = 0;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DRAM, "dram_init");
+	dram = handoff_find(HANDOFF_TAG_DRAM, sizeof(*dram));
+	if (dram)
+		gd->ram_size = dram->ram_size;
+	else
+		ret = dram_init();
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DRAM);
+
+	return ret;
+}
+
+/* Use the DRAM banks from SPL if available, else work them out */
+static int initf_dram_banksize(void)
+{
+#ifdef CONFIG_NR_DRAM_BANKS
+	struct handoff_dram *dram;
+	int i;
+
+	dram = handoff_find(HANDOFF_TAG_DRAM, sizeof(*dram));
+	if (dram) {
+		for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
+			gd->bd->bi_dram[i].start = dram->bank[i].start;
+			gd->bd->bi_dram[i].size = dram->bank[i].size;
+		}
+		return 0;
+	}
+#endif
+
+	return dram_init_banksize();
+}
+
 #if defined(CONFIG_SYS_I2C)
 static int init_func_i2c(void)
 {
@@ -707,6 +745,34 @@ static int initf_bootstage(void)
 	return 0;
 }
 
+/* Pick up the state passed on by SPL, if any */
+static int initf_handoff(void)
+{
+#if CONFIG_IS_ENABLED(HANDOFF)
+	struct handoff_clocks *clk;
+	int ret;
+
+	ret = handoff_check(CONFIG_HANDOFF_ADDR, CONFIG_HANDOFF_SIZE);
+	if (ret) {
+		debug("No SPL handoff: err=%d\n", ret);
+		return 0;
+	}
+	/*
+	 * The records stay usable until relocation, but the area must not be
+	 * taken up again after a reset which does not pass through SPL
+	 */
+	handoff_invalidate(CONFIG_HANDOFF_ADDR);
+	clk = handoff_find(HANDOFF_TAG_CLOCKS, sizeof(*clk));
+	if (clk) {
+		gd->cpu_clk = clk->cpu_clk;
+		gd->bus_clk = clk->bus_clk;
+		gd->mem_clk = clk->mem_clk;
+	}
+#endif
+
+	return 0;
+}
+
 static int initf_console_record(void)
 {
 #if defined(CONFIG_CONSOLE_RECORD) && CONFIG_VAL(SYS_MALLOC_F_LEN)
@@ -758,6 +824,7 @@ static const init_fnc_t init_sequence_f[] = {
 	initf_malloc,
 	log_init,
 	initf_bootstage,	/* uses its own timer, so does not need DM */
+	initf_handoff,
 	initf_console_record,
 #if defined(CONFIG_HAVE_FSP)
 	arch_fsp_init,
@@ -812,7 +879,7 @@ static const init_fnc_t init_sequence_f[] = {
 	init_func_spi,
 #endif
 	announce_dram_init,
-	dram_init,		/* configure available RAM banks */
+	initf_dram,		/* configure available RAM banks */
 #ifdef CONFIG_POST
 	post_init_f,
 #endif
@@ -857,7 +924,7 @@ static const init_fnc_t init_sequence_f[] = {
 	reserve_bootstage,
 	reserve_arch,
 	reserve_stacks,
-	dram_init_banksize,
+	initf_dram_banksize,
 	show_dram_config,
 #if defined(CONFIG_M68K) || defined(CONFIG_MIPS) || defined(CONFIG_PPC) || \
 	defined(CONFIG_SH)
@@ -237,6 +237,7 @@ static int initr_malloc(void)
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
 	debug("Pre-reloc malloc() used %#lx bytes (%ld KB)\n", gd->malloc_ptr,
 	      gd->malloc_ptr / 1024);
+	bootstage_value(BOOTSTAGE_ID_MALLOC_F, "malloc_f", gd->malloc_ptr);
 #endif
 	/* The malloc area is immediately below the monitor copy in DRAM */
 	malloc_start = gd->relocaddr - TOTAL_MALLOC_LEN;
@@ -268,7 +269,14 @@ static int initr_of_live(void)
 	int ret;
 
 	bootstage_start(BOOTSTAGE_ID_ACCUM_OF_LIVE, "of_live");
-	ret = of_live_build(gd->fdt_blob, (struct device_node **)&gd->of_root);
+#ifdef CONFIG_OF_LIVE_PACK
+	/* Use the tree packed at build time if it is for our flat tree */
+	ret = of_live_adopt(__of_live_pack_begin, gd->fdt_blob,
+			    (struct device_node **)&gd->of_root);
+	if (ret)
+#endif
+		ret = of_live_build(gd->fdt_blob,
+				    (struct device_node **)&gd->of_root);
 	bootstage_accum(BOOTSTAGE_ID_ACCUM_OF_LIVE);
 	if (ret)
 		return ret;
@@ -285,6 +293,8 @@ static int initr_dm(void)
 	/* Save the pre-reloc driver model and start a new one */
 	gd->dm_root_f = gd->dm_root;
 	gd->dm_root = NULL;
+	/* Deferred nodes from before relocation were not in this heap */
+	gd->dm_lazy_list = NULL;
 #ifdef CONFIG_TIMER
 	gd->timer = NULL;
 #endif
@@ -303,6 +313,24 @@ static int initr_dm(void)
 }
 #endif
 
+#ifdef CONFIG_DM_ASYNC_PROBE
+static int initr_dm_probe_start(void)
+{
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "dm_probe_start");
+	dm_probe_start_all();
+
+	return 0;
+}
+
+static int initr_dm_probe_complete(void)
+{
+	dm_probe_complete_all();
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "dm_probe_done");
+
+	return 0;
+}
+#endif
+
 static int initr_bootstage(void)
 {
 	bootstage_mark_name(BOOTSTAGE_ID_START_UBOOT_R, "board_init_r");
@@ -691,6 +719,9 @@ static init_fnc_t init_sequence_r[] = {
 #endif
 #if defined(CONFIG_ARM) || defined(CONFIG_NDS32) || defined(CONFIG_RISCV)
 	board_init,	/* Setup chipselects */
+#endif
+#ifdef CONFIG_DM_ASYNC_PROBE
+	initr_dm_probe_start,	/* Kick off slow devices */
 #endif
 	/*
 	 * TODO: printing of the clock inforamtion of the board is now
@@ -844,6 +875,9 @@ static init_fnc_t init_sequence_r[] = {
 #endif
 #if defined(CONFIG_PRAM)
 	initr_mem,
+#endif
+#ifdef CONFIG_DM_ASYNC_PROBE
+	initr_dm_probe_complete,
 #endif
 	run_main_loop,
 };
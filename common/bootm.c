@@ -14,6 +14,7 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 #include <linux/lzo.h>
 #include <lzma/LzmaTypes.h>
 #include <lzma/LzmaDec.h>
@@ -70,6 +71,10 @@ static inline void boot_start_lmb(bootm_headers_t *images) { }
 static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc,
 		       char * const argv[])
 {
+#ifdef CONFIG_LMB
+	/* Free the region arrays left over from the last bootm */
+	lmb_release(&images.lmb);
+#endif
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = env_get_yesno("verify");
 
@@ -424,6 +429,55 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 }
 
 #ifndef USE_HOSTCC
+/**
+ * bootm_unc_len() - Get the space needed for decompressing an image
+ *
+ * gzip and LZMA record the size of the uncompressed data, so the exact size
+ * is known for these formats. For other formats the maximum size is used.
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @image_buf:	Compressed image data
+ * @image_len:	Size of the compressed data
+ * @return number of bytes the decompressed image may occupy
+ */
+static ulong bootm_unc_len(int comp, const u8 *image_buf, ulong image_len)
+{
+	switch (comp) {
+	case IH_COMP_GZIP:
+		/* ISIZE in the trailer, modulo 4 GiB */
+		if (image_len >= 18)
+			return get_unaligned_le32(image_buf + image_len - 4);
+		break;
+	case IH_COMP_LZMA:
+		/* Size in the header, all ones if unknown */
+		if (image_len >= 13 &&
+		    get_unaligned_le32(image_buf + 9) == 0 &&
+		    get_unaligned_le32(image_buf + 5) != 0xffffffff)
+			return get_unaligned_le32(image_buf + 5);
+		break;
+	}
+
+	return CONFIG_SYS_BOOTM_LEN;
+}
+
+/*
+ * Check whether the FDT or ramdisk found by bootm lie in a range that the
+ * kernel is about to be written to
+ */
+static bool bootm_others_overlap(bootm_headers_t *images, ulong start,
+				 ulong end)
+{
+	ulong fdt = map_to_sysmem(images->ft_addr);
+
+	if (images->ft_len && fdt < end && fdt + images->ft_len > start)
+		return true;
+	if (images->rd_start < images->rd_end && images->rd_start < end &&
+	    images->rd_end > start)
+		return true;
+
+	return false;
+}
+
 static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 {
 	image_info_t os = images->os;
@@ -435,15 +489,46 @@ static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 	ulong image_len = os.image_len;
 	ulong flush_start = ALIGN_DOWN(load, ARCH_DMA_MINALIGN);
 	ulong flush_len;
-	bool no_overlap;
-	void *load_buf, *image_buf;
+	bool no_overlap, in_place = false;
+	void *load_buf, *image_buf, *moved = NULL;
 	int err;
 
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
+
+	/*
+	 * A compressed image may have been loaded right where it is to be
+	 * decompressed to. Decompress it in place by moving the compressed
+	 * data out of the way first, which costs a copy of the compressed
+	 * data only. The rest of the image is overwritten, so the FDT and
+	 * ramdisk must have been placed elsewhere already.
+	 */
+	if (os.comp != IH_COMP_NONE) {
+		ulong unc_end = load + bootm_unc_len(os.comp, image_buf,
+						     image_len);
+
+		if (image_start < unc_end && load < image_start + image_len) {
+			if (bootm_others_overlap(images, load, unc_end)) {
+				puts("ERROR: kernel would overwrite the FDT or ramdisk\n");
+				puts("Must RESET board to recover\n");
+				bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
+				return BOOTM_ERR_RESET;
+			}
+			moved = malloc(image_len);
+			if (moved) {
+				debug("   moving compressed image to %p\n",
+				      moved);
+				memcpy(moved, image_buf, image_len);
+				image_buf = moved;
+				in_place = true;
+			}
+		}
+	}
+
 	err = bootm_decomp_image(os.comp, load, os.image_start, os.type,
 				 load_buf, image_buf, image_len,
 				 CONFIG_SYS_BOOTM_LEN, &load_end);
+	free(moved);
 	if (err) {
 		bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
 		return err;
@@ -458,7 +543,9 @@ static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 	debug("   kernel loaded at 0x%08lx, end = 0x%08lx\n", load, load_end);
 	bootstage_mark(BOOTSTAGE_ID_KERNEL_LOADED);
 
-	no_overlap = (os.comp == IH_COMP_NONE && load == image_start);
+	/* Overwriting the image is expected if it was moved out of the way */
+	no_overlap = in_place ||
+		     (os.comp == IH_COMP_NONE && load == image_start);
 
 	if (!no_overlap && load < blob_end && load_end > blob_start) {
 		debug("images.os.start = 0x%lX, images.os.end = 0x%lx\n",
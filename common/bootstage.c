@@ -10,6 +10,7 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <linux/libfdt.h>
 #include <malloc.h>
 #include <linux/compiler.h>
@@ -113,7 +114,8 @@ ulong bootstage_add_record(enum bootstage_id id, const char *name,
 	}
 
 	/* Tell the board about this progress */
-	show_boot_progress(flags & BOOTSTAGEF_ERROR ? -id : id);
+	if (!(flags & BOOTSTAGEF_VALUE))
+		show_boot_progress(flags & BOOTSTAGEF_ERROR ? -id : id);
 
 	return mark;
 }
@@ -140,6 +142,11 @@ ulong bootstage_mark_name(enum bootstage_id id, const char *name)
 	return bootstage_add_record(id, name, flags, timer_get_boot_us());
 }
 
+ulong bootstage_value(enum bootstage_id id, const char *name, ulong value)
+{
+	return bootstage_add_record(id, name, BOOTSTAGEF_VALUE, value);
+}
+
 ulong bootstage_mark_code(const char *file, const char *func, int linenum)
 {
 	char *str, *p;
@@ -232,6 +239,15 @@ static uint32_t print_time_record(struct bootstage_record *rec, uint32_t prev)
 	return rec->time_us;
 }
 
+static void print_value_record(struct bootstage_record *rec)
+{
+	char buf[20];
+
+	/* Value records hold a number such as a size, not a time */
+	printf("%11s%#11lx  %s\n", "", rec->time_us,
+	       get_record_name(buf, sizeof(buf), rec));
+}
+
 static int h_compare_record(const void *r1, const void *r2)
 {
 	const struct bootstage_record *rec1 = r1, *rec2 = r2;
@@ -285,13 +301,21 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 				       get_record_name(buf, sizeof(buf), rec)))
 			return -EINVAL;
 
-		/* Check if this is a 'mark' or 'accum' record */
+		/* Check if this is a 'mark', 'accum' or 'value' record */
 		if (fdt_setprop_cell(blob, node,
+				rec->flags & BOOTSTAGEF_VALUE ? "value" :
 				rec->start_us ? "accum" : "mark",
 				rec->time_us))
 			return -EINVAL;
 	}
 
+	if (CONFIG_IS_ENABLED(BLK_STATS)) {
+		int node = fdt_add_subnode(blob, bootstage, "blk");
+
+		if (node < 0 || blk_stats_fdt_add(blob, node))
+			return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -321,7 +345,8 @@ void bootstage_report(void)
 	qsort(data->record, data->rec_count, sizeof(*rec), h_compare_record);
 
 	for (i = 1, rec++; i < data->rec_count; i++, rec++) {
-		if (rec->id && !rec->start_us)
+		if (rec->id && !rec->start_us &&
+		    !(rec->flags & BOOTSTAGEF_VALUE))
 			prev = print_time_record(rec, prev);
 	}
 	if (data->rec_count > RECORD_COUNT)
@@ -334,6 +359,12 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(rec, -1);
 	}
+
+	puts("\nValues:\n");
+	for (i = 0, rec = data->record; i < data->rec_count; i++, rec++) {
+		if (rec->flags & BOOTSTAGEF_VALUE)
+			print_value_record(rec);
+	}
 }
 
 /**
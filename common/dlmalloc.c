@@ -708,6 +708,96 @@ static unsigned int max_n_mmaps = 0;
 static unsigned long max_mmapped_mem = 0;
 #endif
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_CACHE)
+/*
+  Small-block cache
+
+    Freed chunks of up to MALLOC_CACHE_MAX bytes are kept on a list per
+    size, still marked as in use, and handed out again by the next
+    malloc() of that size. This saves coalescing and binning the many
+    small blocks which driver model and the device-tree code allocate
+    and free again. The cache is flushed into the bins only when top
+    cannot serve a request, so that the chunks can then be coalesced.
+*/
+
+#define MALLOC_CACHE_MAX	128
+#define cache_index(sz)		((unsigned long)(sz) / MALLOC_ALIGNMENT)
+
+static mchunkptr malloc_cache[cache_index(MALLOC_CACHE_MAX) + 1];
+static unsigned long malloc_cached_mem;
+static int malloc_cache_flushing;
+
+static int malloc_cache_put(mchunkptr p)
+{
+	INTERNAL_SIZE_T sz = chunksize(p);
+
+	if (malloc_cache_flushing || sz > MALLOC_CACHE_MAX ||
+	    chunk_is_mmapped(p))
+		return 0;
+	p->fd = malloc_cache[cache_index(sz)];
+	malloc_cache[cache_index(sz)] = p;
+	malloc_cached_mem += sz;
+
+	return 1;
+}
+
+static mchunkptr malloc_cache_get(INTERNAL_SIZE_T nb)
+{
+	mchunkptr p;
+
+	if (nb > MALLOC_CACHE_MAX)
+		return NULL;
+	p = malloc_cache[cache_index(nb)];
+	if (p) {
+		malloc_cache[cache_index(nb)] = p->fd;
+		malloc_cached_mem -= nb;
+	}
+
+	return p;
+}
+
+/* Free all cached chunks, returns 1 if there were any */
+static int malloc_cache_flush(void)
+{
+	mchunkptr p;
+	int i;
+
+	if (!malloc_cached_mem)
+		return 0;
+	malloc_cache_flushing = 1;
+	for (i = 0; i < ARRAY_SIZE(malloc_cache); i++) {
+		while ((p = malloc_cache[i])) {
+			malloc_cache[i] = p->fd;
+			fREe(chunk2mem(p));
+		}
+	}
+	malloc_cached_mem = 0;
+	malloc_cache_flushing = 0;
+
+	return 1;
+}
+#else
+#define malloc_cached_mem	0
+
+static inline int malloc_cache_put(mchunkptr p) { return 0; }
+static inline mchunkptr malloc_cache_get(INTERNAL_SIZE_T nb) { return NULL; }
+static inline int malloc_cache_flush(void) { return 0; }
+#endif
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
+/* Number of malloc() calls by size class, see struct malloc_info */
+static unsigned long malloc_class_count[MALLOC_STATS_CLASSES];
+
+static void malloc_count(size_t bytes)
+{
+	int class = bytes <= 16 ? 0 : fls(bytes - 1) - 4;
+
+	malloc_class_count[min(class, MALLOC_STATS_CLASSES - 1)]++;
+}
+#else
+static inline void malloc_count(size_t bytes) {}
+#endif
+
 
 
 /*
@@ -1269,6 +1359,12 @@ Void_t* mALLOc(bytes) size_t bytes;
 
   nb = request2size(bytes);  /* padded request size; */
 
+	malloc_count(bytes);
+retry:
+	victim = malloc_cache_get(nb);
+	if (victim)
+		return chunk2mem(victim);
+
   /* Check for exact match in a bin */
 
   if (is_small_request(nb))  /* Faster version for small requests */
@@ -1467,6 +1563,9 @@ Void_t* mALLOc(bytes) size_t bytes;
 
     /* Try to extend */
     malloc_extend_top(nb);
+	/* Coalesce the cached chunks and try again */
+	if (chunksize(top) < nb + MINSIZE && malloc_cache_flush())
+		goto retry;
     if ( (remainder_size = chunksize(top) - nb) < (long)MINSIZE)
       return NULL; /* propagate failure */
   }
@@ -1523,9 +1622,11 @@ void fREe(mem) Void_t* mem;
   int       islr;      /* track whether merging with last_remainder */
 
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
-	/* free() is a no-op - all the memory will be freed on relocation */
-	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+	/* all the memory will be freed on relocation anyway */
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		free_simple(mem);
 		return;
+	}
 #endif
 
   if (mem == NULL)                              /* free(0) has no effect */
@@ -1544,6 +1645,9 @@ void fREe(mem) Void_t* mem;
 
   check_inuse_chunk(p);
 
+	if (malloc_cache_put(p))
+		return;
+
   sz = hd & ~PREV_INUSE;
   next = chunk_at_offset(p, sz);
   nextsz = chunksize(next);
@@ -1684,7 +1788,9 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
 	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
-		/* This is harder to support and should not be needed */
+		if (CONFIG_IS_ENABLED(SYS_MALLOC_F_FREE))
+			return realloc_simple(oldmem, bytes);
+		/* This needs the size of each block, see SYS_MALLOC_F_FREE */
 		panic("pre-reloc realloc() is not supported");
 	}
 #endif
@@ -1891,6 +1997,11 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
 
   if ((long)bytes < 0) return NULL;
 
+#if CONFIG_VAL(SYS_MALLOC_F_LEN)
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return memalign_simple(alignment, bytes);
+#endif
+
   /* If need less alignment than we give anyway, just relay to malloc */
 
   if (alignment <= MALLOC_ALIGNMENT) return mALLOc(bytes);
@@ -2247,6 +2358,41 @@ size_t malloc_usable_size(mem) Void_t* mem;
 
 
 
+void malloc_get_info(struct malloc_info *info)
+{
+	mbinptr b;
+	mchunkptr p;
+	unsigned long avail, size;
+	int i;
+
+	memset(info, '\0', sizeof(*info));
+#if CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
+	memcpy(info->count, malloc_class_count, sizeof(info->count));
+#endif
+	info->pool = mem_malloc_end - mem_malloc_start;
+	info->peak = max_sbrked_mem;
+
+	/* The top chunk and the rest of the pool form one free block */
+	avail = mem_malloc_end - mem_malloc_brk;
+	if (top != initial_top)
+		avail += chunksize(top);
+	info->largest = avail;
+	info->free_blocks = 1;
+	for (i = 1; i < NAV; ++i) {
+		b = bin_at(i);
+		for (p = last(b); p != b; p = p->bk) {
+			size = chunksize(p);
+			avail += size;
+			info->free_blocks++;
+			if (size > info->largest)
+				info->largest = size;
+		}
+	}
+	info->cached = malloc_cached_mem;
+	info->free = avail + info->cached;
+	info->in_use = info->pool - info->free;
+}
+
 /* Utility to update current_mallinfo for malloc_stats and mallinfo() */
 
 #ifdef DEBUG
@@ -2330,6 +2476,8 @@ void malloc_stats()
 #ifdef DEBUG
 struct mallinfo mALLINFo()
 {
+	/* Cached chunks are free, count them as such */
+	malloc_cache_flush();
   malloc_update_mallinfo();
   return current_mallinfo;
 }
@@ -0,0 +1,540 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Batched device tree fixups
+ *
+ * Each fixup applied to the flat tree before booting an OS normally inserts
+ * data in the middle of the structure block, moving everything after it.
+ * With a batch, the property writes are collected in memory and the
+ * structure block is rewritten once, when the batch is committed.
+ */
+
+#include <common.h>
+#include <fdt_support.h>
+#include <malloc.h>
+#include <linux/libfdt.h>
+
+/* Longest node path that can be written by a batch */
+#define FDT_BATCH_PATH_MAX	256
+
+/**
+ * struct fdt_batch_prop - A property write waiting to be applied
+ *
+ * @sibling: List node in struct fdt_batch
+ * @path: Full path of the node to write to
+ * @name: Property name, or NULL to just make sure that the node exists
+ * @nameoff: Offset of @name in the strings block once committed
+ * @done: true once the write has been emitted
+ * @len: Length of the property value
+ * @val: Property value
+ */
+struct fdt_batch_prop {
+	struct list_head sibling;
+	char *path;
+	char *name;
+	int nameoff;
+	bool done;
+	int len;
+	char val[];
+};
+
+/**
+ * struct fdt_batch_state - State while rewriting the structure block
+ *
+ * @batch: Batch being committed
+ * @base: Start of the existing structure block
+ * @out: Buffer for the new structure block
+ * @out_len: Number of bytes written to @out so far
+ * @copy_from: Offset in the existing structure block of the first byte not
+ *	yet copied to @out
+ * @path: Path of the current node
+ */
+struct fdt_batch_state {
+	struct fdt_batch *batch;
+	const char *base;
+	char *out;
+	int out_len;
+	int copy_from;
+	char path[FDT_BATCH_PATH_MAX];
+};
+
+/* Deferred batch being collected, which other fixups to its FDT join */
+static struct fdt_batch *fdt_batch_open;
+
+void fdt_batch_init(struct fdt_batch *batch, void *blob, bool defer)
+{
+	batch->blob = blob;
+	INIT_LIST_HEAD(&batch->props);
+	batch->count = 0;
+	batch->extra = 0;
+	batch->defer = IS_ENABLED(CONFIG_FDT_FIXUP_BATCH) && defer;
+	if (batch->defer)
+		fdt_batch_open = batch;
+}
+
+struct fdt_batch *fdt_batch_current(const void *blob)
+{
+	if (fdt_batch_open && fdt_batch_open->blob == blob)
+		return fdt_batch_open;
+
+	return NULL;
+}
+
+/* Return the length of the parent part of @path, with "/" for the root */
+static int fdt_batch_parent_len(const char *path)
+{
+	const char *base = strrchr(path, '/');
+
+	return base == path ? 1 : base - path;
+}
+
+/* Find the parent of the node at @path, which need not exist */
+static int fdt_batch_parent(const void *blob, const char *path)
+{
+	int len = fdt_batch_parent_len(path);
+
+	/* fdt_path_offset_namelen() does not stop at the end of "/" */
+	if (len == 1)
+		return 0;
+
+	return fdt_path_offset_namelen(blob, path, len);
+}
+
+static struct fdt_batch_prop *fdt_batch_find(struct fdt_batch *batch,
+					     const char *path, int path_len,
+					     const char *name)
+{
+	struct fdt_batch_prop *prop;
+
+	list_for_each_entry(prop, &batch->props, sibling) {
+		if (strncmp(prop->path, path, path_len) ||
+		    prop->path[path_len])
+			continue;
+		if (!name || (prop->name && !strcmp(prop->name, name)))
+			return prop;
+	}
+
+	return NULL;
+}
+
+/* Write a property straight into the tree, adding the node if needed */
+static int fdt_batch_write(void *blob, const char *path, const char *name,
+			   const void *val, int len)
+{
+	int node, parent;
+
+	node = fdt_path_offset(blob, path);
+	if (node == -FDT_ERR_NOTFOUND && *path == '/') {
+		parent = fdt_batch_parent(blob, path);
+		if (parent < 0)
+			return parent;
+		node = fdt_add_subnode(blob, parent, strrchr(path, '/') + 1);
+	}
+	if (node < 0)
+		return node;
+	if (!name)
+		return 0;
+
+	return fdt_setprop(blob, node, name, val, len);
+}
+
+int fdt_batch_setprop(struct fdt_batch *batch, const char *path,
+		      const char *name, const void *val, int len)
+{
+	struct fdt_batch_prop *prop, *old;
+	char buf[FDT_BATCH_PATH_MAX];
+	const char *base;
+	int node, parent_len, path_len, name_len;
+	int ret;
+
+	if (!batch->defer)
+		return fdt_batch_write(batch->blob, path, name, val, len);
+
+	/* Work out the full path of the node, which may not exist yet */
+	node = fdt_path_offset(batch->blob, path);
+	if (node >= 0) {
+		if (!name)
+			return 0;
+		ret = fdt_get_path(batch->blob, node, buf, sizeof(buf));
+		if (ret)
+			return ret;
+	} else if (node == -FDT_ERR_NOTFOUND && *path == '/') {
+		base = strrchr(path, '/') + 1;
+		parent_len = fdt_batch_parent_len(path);
+		node = fdt_batch_parent(batch->blob, path);
+		if (node >= 0) {
+			ret = fdt_get_path(batch->blob, node, buf, sizeof(buf));
+			if (ret)
+				return ret;
+		} else if (node == -FDT_ERR_NOTFOUND &&
+			   fdt_batch_find(batch, path, parent_len, NULL)) {
+			/* The parent is a new node too */
+			memcpy(buf, path, parent_len);
+			buf[parent_len] = '\0';
+		} else {
+			return node;
+		}
+		path_len = strlen(buf);
+		if (path_len + (path_len > 1) + strlen(base) >= sizeof(buf))
+			return -FDT_ERR_NOSPACE;
+		if (path_len > 1)
+			buf[path_len++] = '/';
+		strcpy(buf + path_len, base);
+		if (!fdt_batch_find(batch, buf, strlen(buf), NULL)) {
+			batch->extra += 2 * FDT_TAGSIZE +
+					ALIGN(strlen(base) + 1, FDT_TAGSIZE);
+		} else if (!name) {
+			return 0;
+		}
+	} else {
+		return node;
+	}
+
+	path_len = strlen(buf) + 1;
+	name_len = name ? strlen(name) + 1 : 0;
+	prop = malloc(sizeof(*prop) + len + path_len + name_len);
+	if (!prop)
+		return -FDT_ERR_NOSPACE;
+	prop->path = prop->val + len;
+	memcpy(prop->path, buf, path_len);
+	prop->name = NULL;
+	if (name) {
+		prop->name = prop->path + path_len;
+		memcpy(prop->name, name, name_len);
+	}
+	prop->done = false;
+	prop->len = len;
+	memcpy(prop->val, val, len);
+
+	/* A later write to the same property replaces the earlier one */
+	old = name ? fdt_batch_find(batch, prop->path, path_len - 1, name) :
+		NULL;
+	if (old) {
+		list_del(&old->sibling);
+		free(old);
+		batch->count--;
+	}
+	list_add_tail(&prop->sibling, &batch->props);
+	batch->count++;
+	/* This also leaves room for the name in the strings block */
+	batch->extra += sizeof(struct fdt_property) + ALIGN(len, FDT_TAGSIZE) +
+			name_len;
+
+	return 0;
+}
+
+void fdt_batch_abort(struct fdt_batch *batch)
+{
+	struct fdt_batch_prop *prop, *next;
+
+	list_for_each_entry_safe(prop, next, &batch->props, sibling) {
+		list_del(&prop->sibling);
+		free(prop);
+	}
+	batch->count = 0;
+	batch->extra = 0;
+	if (fdt_batch_open == batch)
+		fdt_batch_open = NULL;
+}
+
+/* Find @str in a strings block, returning its offset or -1 */
+static int fdt_batch_find_string(const char *strtab, int size, const char *str)
+{
+	int len = strlen(str) + 1;
+	const char *p;
+
+	for (p = strtab; p <= strtab + size - len; p++) {
+		if (!memcmp(p, str, len))
+			return p - strtab;
+	}
+
+	return -1;
+}
+
+static void fdt_batch_emit(struct fdt_batch_state *st, const void *data,
+			   int len)
+{
+	memcpy(st->out + st->out_len, data, len);
+	st->out_len += len;
+}
+
+static void fdt_batch_emit_tag(struct fdt_batch_state *st, uint32_t tag)
+{
+	fdt32_t val = cpu_to_fdt32(tag);
+
+	fdt_batch_emit(st, &val, sizeof(val));
+}
+
+static void fdt_batch_emit_pad(struct fdt_batch_state *st)
+{
+	int pad = ALIGN(st->out_len, FDT_TAGSIZE) - st->out_len;
+
+	memset(st->out + st->out_len, '\0', pad);
+	st->out_len += pad;
+}
+
+/* Copy the existing structure block up to @offset */
+static void fdt_batch_copy(struct fdt_batch_state *st, int offset)
+{
+	fdt_batch_emit(st, st->base + st->copy_from, offset - st->copy_from);
+	st->copy_from = offset;
+}
+
+static void fdt_batch_emit_prop(struct fdt_batch_state *st,
+				struct fdt_batch_prop *prop)
+{
+	fdt_batch_emit_tag(st, FDT_PROP);
+	fdt_batch_emit_tag(st, prop->len);
+	fdt_batch_emit_tag(st, prop->nameoff);
+	fdt_batch_emit(st, prop->val, prop->len);
+	fdt_batch_emit_pad(st);
+	prop->done = true;
+}
+
+/* Emit all properties still to be written to the node at @path */
+static void fdt_batch_emit_props(struct fdt_batch_state *st,
+				 const char *path)
+{
+	struct fdt_batch_prop *prop;
+
+	list_for_each_entry(prop, &st->batch->props, sibling) {
+		if (prop->done || strcmp(prop->path, path))
+			continue;
+		if (prop->name)
+			fdt_batch_emit_prop(st, prop);
+		prop->done = true;
+	}
+}
+
+/* Emit all new subnodes of the node at @path, with their properties */
+static void fdt_batch_emit_nodes(struct fdt_batch_state *st,
+				 const char *path)
+{
+	struct fdt_batch_prop *prop;
+	int len = strlen(path);
+	const char *name;
+
+	list_for_each_entry(prop, &st->batch->props, sibling) {
+		if (prop->done || strncmp(prop->path, path, len) ||
+		    fdt_batch_parent_len(prop->path) != len ||
+		    !prop->path[1])
+			continue;
+		name = strrchr(prop->path, '/') + 1;
+		fdt_batch_emit_tag(st, FDT_BEGIN_NODE);
+		fdt_batch_emit(st, name, strlen(name) + 1);
+		fdt_batch_emit_pad(st);
+		fdt_batch_emit_props(st, prop->path);
+		fdt_batch_emit_nodes(st, prop->path);
+		fdt_batch_emit_tag(st, FDT_END_NODE);
+	}
+}
+
+/* Check whether anything is to be written in or below the node at @path */
+static bool fdt_batch_wanted(struct fdt_batch *batch, const char *path,
+			     int len)
+{
+	struct fdt_batch_prop *prop;
+
+	if (len == 1)
+		return true;
+	list_for_each_entry(prop, &batch->props, sibling) {
+		if (!prop->done && !strncmp(prop->path, path, len) &&
+		    (!prop->path[len] || prop->path[len] == '/'))
+			return true;
+	}
+
+	return false;
+}
+
+/* Copy the structure block to @st->out, applying the batch as we go */
+static int fdt_batch_rewrite(struct fdt_batch_state *st)
+{
+	const void *blob = st->batch->blob;
+	int path_len[FDT_MAX_DEPTH];
+	bool props_done[FDT_MAX_DEPTH];
+	const struct fdt_property *fprop;
+	struct fdt_batch_prop *prop;
+	int offset, nextoffset = 0;
+	int depth = -1, skip = -1;
+	const char *name;
+	uint32_t tag;
+	int len;
+
+	do {
+		offset = nextoffset;
+		tag = fdt_next_tag(blob, offset, &nextoffset);
+		if (nextoffset < 0)
+			return nextoffset;
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			depth++;
+			if (skip != -1)
+				break;
+			if (depth && !props_done[depth - 1]) {
+				fdt_batch_copy(st, offset);
+				fdt_batch_emit_props(st, st->path);
+				props_done[depth - 1] = true;
+			}
+			if (depth == FDT_MAX_DEPTH) {
+				skip = depth;
+				break;
+			}
+			name = fdt_get_name(blob, offset, &len);
+			if (!depth) {
+				strcpy(st->path, "/");
+				path_len[depth] = 1;
+			} else {
+				int start = path_len[depth - 1];
+
+				if (start + 1 + len >= FDT_BATCH_PATH_MAX) {
+					skip = depth;
+					break;
+				}
+				if (depth > 1)
+					st->path[start++] = '/';
+				memcpy(st->path + start, name, len);
+				path_len[depth] = start + len;
+				st->path[path_len[depth]] = '\0';
+			}
+			props_done[depth] = false;
+			if (!fdt_batch_wanted(st->batch, st->path,
+					      path_len[depth]))
+				skip = depth;
+			break;
+		case FDT_PROP:
+			if (skip != -1 || depth < 0)
+				break;
+			fprop = fdt_get_property_by_offset(blob, offset, NULL);
+			name = fdt_string(blob, fdt32_to_cpu(fprop->nameoff));
+			prop = fdt_batch_find(st->batch, st->path,
+					      path_len[depth], name);
+			if (prop && !prop->done) {
+				fdt_batch_copy(st, offset);
+				fdt_batch_emit_prop(st, prop);
+				st->copy_from = nextoffset;
+			}
+			break;
+		case FDT_END_NODE:
+			if (skip == -1) {
+				fdt_batch_copy(st, offset);
+				if (!props_done[depth])
+					fdt_batch_emit_props(st, st->path);
+				fdt_batch_emit_nodes(st, st->path);
+				if (depth > 0)
+					st->path[path_len[depth - 1]] = '\0';
+			} else if (skip == depth) {
+				skip = -1;
+				if (depth > 0)
+					st->path[path_len[depth - 1]] = '\0';
+			}
+			depth--;
+			break;
+		}
+	} while (tag != FDT_END);
+	fdt_batch_copy(st, nextoffset);
+
+	list_for_each_entry(prop, &st->batch->props, sibling) {
+		if (!prop->done)
+			return -FDT_ERR_INTERNAL;
+	}
+
+	return 0;
+}
+
+/* Set the name offset of each property, returning any strings to add */
+static int fdt_batch_strings(struct fdt_batch *batch, char *new_strings)
+{
+	const void *blob = batch->blob;
+	const char *strtab = blob + fdt_off_dt_strings(blob);
+	int size = fdt_size_dt_strings(blob);
+	struct fdt_batch_prop *prop;
+	int new_len = 0;
+	int off;
+
+	list_for_each_entry(prop, &batch->props, sibling) {
+		if (!prop->name)
+			continue;
+		off = fdt_batch_find_string(strtab, size, prop->name);
+		if (off == -1) {
+			off = fdt_batch_find_string(new_strings, new_len,
+						    prop->name);
+			if (off == -1) {
+				off = new_len;
+				strcpy(new_strings + new_len, prop->name);
+				new_len += strlen(prop->name) + 1;
+			}
+			off += size;
+		}
+		prop->nameoff = off;
+	}
+
+	return new_len;
+}
+
+int fdt_batch_commit(struct fdt_batch *batch)
+{
+	void *blob = batch->blob;
+	struct fdt_batch_state st;
+	struct fdt_batch_prop *prop;
+	int struct_off, strings_size, new_len;
+	char *new_strings;
+	int ret;
+
+	if (list_empty(&batch->props))
+		return 0;
+
+	/* Make sure that the strings block directly follows the structure */
+	if (fdt_version(blob) < 17 ||
+	    fdt_off_mem_rsvmap(blob) > fdt_off_dt_struct(blob) ||
+	    fdt_off_dt_strings(blob) !=
+			fdt_off_dt_struct(blob) + fdt_size_dt_struct(blob)) {
+		ret = fdt_open_into(blob, blob, fdt_totalsize(blob));
+		if (ret)
+			goto done;
+	}
+	struct_off = fdt_off_dt_struct(blob);
+	strings_size = fdt_size_dt_strings(blob);
+
+	memset(&st, '\0', sizeof(st));
+	st.batch = batch;
+	st.base = blob + struct_off;
+	st.out = malloc(fdt_size_dt_struct(blob) + batch->extra);
+	new_strings = malloc(batch->extra);
+	if (!st.out || !new_strings) {
+		/* Without a buffer, fall back to writing one at a time */
+		free(st.out);
+		free(new_strings);
+		ret = 0;
+		list_for_each_entry(prop, &batch->props, sibling) {
+			ret = fdt_batch_write(blob, prop->path, prop->name,
+					      prop->val, prop->len);
+			if (ret)
+				break;
+		}
+		goto done;
+	}
+
+	new_len = fdt_batch_strings(batch, new_strings);
+	ret = fdt_batch_rewrite(&st);
+	if (!ret && struct_off + st.out_len + strings_size + new_len >
+			fdt_totalsize(blob))
+		ret = -FDT_ERR_NOSPACE;
+	if (!ret) {
+		memmove(blob + struct_off + st.out_len,
+			blob + fdt_off_dt_strings(blob), strings_size);
+		memcpy(blob + struct_off + st.out_len + strings_size,
+		       new_strings, new_len);
+		memcpy(blob + struct_off, st.out, st.out_len);
+		fdt_set_size_dt_struct(blob, st.out_len);
+		fdt_set_off_dt_strings(blob, struct_off + st.out_len);
+		fdt_set_size_dt_strings(blob, strings_size + new_len);
+	}
+	free(new_strings);
+	free(st.out);
+
+done:
+	debug("%s: %d properties, %d bytes: %s\n", __func__, batch->count,
+	      batch->extra, ret ? fdt_strerror(ret) : "ok");
+	fdt_batch_abort(batch);
+
+	return ret;
+}
@@ -124,14 +124,15 @@ int fdt_find_or_add_subnode(void *fdt, int parentoffset, const char *name)
 
 /* rename to CONFIG_OF_STDOUT_PATH ? */
 #if defined(OF_STDOUT_PATH)
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_batch *batch)
 {
-	return fdt_setprop(fdt, chosenoff, "linux,stdout-path",
-			      OF_STDOUT_PATH, strlen(OF_STDOUT_PATH) + 1);
+	return fdt_batch_setprop(batch, "/chosen", "linux,stdout-path",
+				 OF_STDOUT_PATH, strlen(OF_STDOUT_PATH) + 1);
 }
 #elif defined(CONFIG_OF_STDOUT_VIA_ALIAS) && defined(CONFIG_CONS_INDEX)
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_batch *batch)
 {
+	void *fdt = batch->blob;
 	int err;
 	int aliasoff;
 	char sername[9] = { 0 };
@@ -156,7 +157,8 @@ static int fdt_fixup_stdout(void *fdt, int chosenoff)
 	/* fdt_setprop may break "path" so we copy it to tmp buffer */
 	memcpy(tmp, path, len);
 
-	err = fdt_setprop(fdt, chosenoff, "linux,stdout-path", tmp, len);
+	err = fdt_batch_setprop(batch, "/chosen", "linux,stdout-path", tmp,
+				len);
 	if (err < 0)
 		printf("WARNING: could not set linux,stdout-path %s.\n",
 		       fdt_strerror(err));
@@ -170,27 +172,56 @@ noalias:
 	return 0;
 }
 #else
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_batch *batch)
 {
 	return 0;
 }
 #endif
 
-static inline int fdt_setprop_uxx(void *fdt, int nodeoffset, const char *name,
-				  uint64_t val, int is_u64)
+static int fdt_batch_setprop_uxx(struct fdt_batch *batch, const char *path,
+				 const char *name, uint64_t val, int is_u64)
 {
+	fdt64_t val64 = cpu_to_fdt64(val);
+	fdt32_t val32 = cpu_to_fdt32((uint32_t)val);
+
 	if (is_u64)
-		return fdt_setprop_u64(fdt, nodeoffset, name, val);
+		return fdt_batch_setprop(batch, path, name, &val64,
+					 sizeof(val64));
 	else
-		return fdt_setprop_u32(fdt, nodeoffset, name, (uint32_t)val);
+		return fdt_batch_setprop(batch, path, name, &val32,
+					 sizeof(val32));
+}
+
+/*
+ * Get the batch to use for a fixup to @fdt: the one being collected by
+ * image_setup_libfdt() if there is one, else @local, set up to write
+ * directly
+ */
+static struct fdt_batch *fdt_batch_or_direct(void *fdt,
+					     struct fdt_batch *local)
+{
+	struct fdt_batch *batch = fdt_batch_current(fdt);
+
+	if (batch)
+		return batch;
+	fdt_batch_init(local, fdt, false);
+
+	return local;
 }
 
 int fdt_root(void *fdt)
+{
+	struct fdt_batch batch;
+
+	return fdt_batch_root(fdt_batch_or_direct(fdt, &batch));
+}
+
+int fdt_batch_root(struct fdt_batch *batch)
 {
 	char *serial;
 	int err;
 
-	err = fdt_check_header(fdt);
+	err = fdt_check_header(batch->blob);
 	if (err < 0) {
 		printf("fdt_root: %s\n", fdt_strerror(err));
 		return err;
@@ -198,8 +229,8 @@ int fdt_root(void *fdt)
 
 	serial = env_get("serial#");
 	if (serial) {
-		err = fdt_setprop(fdt, 0, "serial-number", serial,
-				  strlen(serial) + 1);
+		err = fdt_batch_setprop(batch, "/", "serial-number", serial,
+					strlen(serial) + 1);
 
 		if (err < 0) {
 			printf("WARNING: could not set serial-number %s.\n",
@@ -213,7 +244,16 @@ int fdt_root(void *fdt)
 
 int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 {
-	int   nodeoffset;
+	struct fdt_batch batch;
+
+	return fdt_batch_initrd(fdt_batch_or_direct(fdt, &batch), initrd_start,
+				initrd_end);
+}
+
+int fdt_batch_initrd(struct fdt_batch *batch, ulong initrd_start,
+		     ulong initrd_end)
+{
+	void *fdt = batch->blob;
 	int   err, j, total;
 	int is_u64;
 	uint64_t addr, size;
@@ -223,9 +263,9 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 		return 0;
 
 	/* find or create "/chosen" node. */
-	nodeoffset = fdt_find_or_add_subnode(fdt, 0, "chosen");
-	if (nodeoffset < 0)
-		return nodeoffset;
+	err = fdt_batch_setprop(batch, "/chosen", NULL, NULL, 0);
+	if (err < 0)
+		return err;
 
 	total = fdt_num_mem_rsv(fdt);
 
@@ -249,8 +289,8 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 
 	is_u64 = (fdt_address_cells(fdt, 0) == 2);
 
-	err = fdt_setprop_uxx(fdt, nodeoffset, "linux,initrd-start",
-			      (uint64_t)initrd_start, is_u64);
+	err = fdt_batch_setprop_uxx(batch, "/chosen", "linux,initrd-start",
+				    (uint64_t)initrd_start, is_u64);
 
 	if (err < 0) {
 		printf("WARNING: could not set linux,initrd-start %s.\n",
@@ -258,8 +298,8 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 		return err;
 	}
 
-	err = fdt_setprop_uxx(fdt, nodeoffset, "linux,initrd-end",
-			      (uint64_t)initrd_end, is_u64);
+	err = fdt_batch_setprop_uxx(batch, "/chosen", "linux,initrd-end",
+				    (uint64_t)initrd_end, is_u64);
 
 	if (err < 0) {
 		printf("WARNING: could not set linux,initrd-end %s.\n",
@@ -273,25 +313,33 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 
 int fdt_chosen(void *fdt)
 {
-	int   nodeoffset;
+	struct fdt_batch batch;
+
+	return fdt_batch_chosen(fdt_batch_or_direct(fdt, &batch));
+}
+
+int fdt_batch_chosen(struct fdt_batch *batch)
+{
 	int   err;
 	char  *str;		/* used to set string properties */
 
-	err = fdt_check_header(fdt);
+	err = fdt_check_header(batch->blob);
 	if (err < 0) {
 		printf("fdt_chosen: %s\n", fdt_strerror(err));
 		return err;
 	}
 
 	/* find or create "/chosen" node. */
-	nodeoffset = fdt_find_or_add_subnode(fdt, 0, "chosen");
-	if (nodeoffset < 0)
-		return nodeoffset;
+	err = fdt_batch_setprop(batch, "/chosen", NULL, NULL, 0);
+	if (err < 0) {
+		printf("%s: chosen: %s\n", __func__, fdt_strerror(err));
+		return err;
+	}
 
 	str = env_get("bootargs");
 	if (str) {
-		err = fdt_setprop(fdt, nodeoffset, "bootargs", str,
-				  strlen(str) + 1);
+		err = fdt_batch_setprop(batch, "/chosen", "bootargs", str,
+					strlen(str) + 1);
 		if (err < 0) {
 			printf("WARNING: could not set bootargs %s.\n",
 			       fdt_strerror(err));
@@ -299,7 +347,7 @@ int fdt_chosen(void *fdt)
 		}
 	}
 
-	return fdt_fixup_stdout(fdt, nodeoffset);
+	return fdt_fixup_stdout(batch);
 }
 
 void do_fixup_by_path(void *fdt, const char *path, const char *prop,
@@ -416,7 +464,17 @@ static int fdt_pack_reg(const void *fdt, void *buf, u64 *address, u64 *size,
 #endif
 int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 {
-	int err, nodeoffset;
+	struct fdt_batch batch;
+
+	return fdt_batch_memory_banks(fdt_batch_or_direct(blob, &batch), start,
+				      size, banks);
+}
+
+int fdt_batch_memory_banks(struct fdt_batch *batch, u64 start[], u64 size[],
+			   int banks)
+{
+	void *blob = batch->blob;
+	int err;
 	int len, i;
 	u8 tmp[MEMORY_BANKS_MAX * 16]; /* Up to 64-bit address + 64-bit size */
 
@@ -434,12 +492,8 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 	}
 
 	/* find or create "/memory" node. */
-	nodeoffset = fdt_find_or_add_subnode(blob, 0, "memory");
-	if (nodeoffset < 0)
-			return nodeoffset;
-
-	err = fdt_setprop(blob, nodeoffset, "device_type", "memory",
-			sizeof("memory"));
+	err = fdt_batch_setprop(batch, "/memory", "device_type", "memory",
+				sizeof("memory"));
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n", "device_type",
 				fdt_strerror(err));
@@ -464,7 +518,7 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 
 	len = fdt_pack_reg(blob, tmp, start, size, banks);
 
-	err = fdt_setprop(blob, nodeoffset, "reg", tmp, len);
+	err = fdt_batch_setprop(batch, "/memory", "reg", tmp, len);
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n",
 				"reg", fdt_strerror(err));
@@ -479,8 +533,34 @@ int fdt_fixup_memory(void *blob, u64 start, u64 size)
 	return fdt_fixup_memory_banks(blob, &start, &size, 1);
 }
 
+/* As do_fixup_by_path(), but adding the write to a batch */
+static void do_batch_fixup_by_path(struct fdt_batch *batch, const char *path,
+				   const char *prop, const void *val, int len,
+				   int create)
+{
+	int rc;
+
+	rc = fdt_path_offset(batch->blob, path);
+	if (rc >= 0) {
+		if (!create && !fdt_get_property(batch->blob, rc, prop, NULL))
+			return;
+		rc = fdt_batch_setprop(batch, path, prop, val, len);
+	}
+	if (rc)
+		printf("Unable to update property %s:%s, err=%s\n",
+		       path, prop, fdt_strerror(rc));
+}
+
 void fdt_fixup_ethernet(void *fdt)
 {
+	struct fdt_batch batch;
+
+	fdt_batch_ethernet(fdt_batch_or_direct(fdt, &batch));
+}
+
+void fdt_batch_ethernet(struct fdt_batch *batch)
+{
+	void *fdt = batch->blob;
 	int i = 0, j, prop;
 	char *tmp, *end;
 	char mac[16];
@@ -549,10 +629,11 @@ void fdt_fixup_ethernet(void *fdt)
 					tmp = (*end) ? end + 1 : end;
 			}
 
-			do_fixup_by_path(fdt, path, "mac-address",
-					 &mac_addr, 6, 0);
-			do_fixup_by_path(fdt, path, "local-mac-address",
-					 &mac_addr, 6, 1);
+			do_batch_fixup_by_path(batch, path, "mac-address",
+					       &mac_addr, 6, 0);
+			do_batch_fixup_by_path(batch, path,
+					       "local-mac-address",
+					       &mac_addr, 6, 1);
 		}
 	}
 }
@@ -1735,6 +1816,22 @@ int fdt_fixup_display(void *blob, const char *path, const char *display)
  * in the case of an error
  */
 int fdt_overlay_apply_verbose(void *fdt, void *fdto)
+{
+	return fdt_overlay_apply_index_verbose(fdt, fdto, NULL);
+}
+
+/**
+ * fdt_overlay_apply_index_verbose - Apply an overlay using an index
+ *
+ * @fdt: ptr to device tree
+ * @fdto: ptr to device tree overlay
+ * @idx: index of lookups in @fdt to use and update, or NULL
+ *
+ * As fdt_overlay_apply_verbose(), but allows the index to be reused when
+ * applying several overlays to the same tree.
+ */
+int fdt_overlay_apply_index_verbose(void *fdt, void *fdto,
+				    struct fdt_overlay_index *idx)
 {
 	int err;
 	bool has_symbols;
@@ -1742,7 +1839,7 @@ int fdt_overlay_apply_verbose(void *fdt, void *fdto)
 	err = fdt_path_offset(fdt, "/__symbols__");
 	has_symbols = err >= 0;
 
-	err = fdt_overlay_apply(fdt, fdto);
+	err = fdt_overlay_apply_index(fdt, fdto, idx);
 	if (err < 0) {
 		printf("failed on fdt_overlay_apply(): %s\n",
 				fdt_strerror(err));
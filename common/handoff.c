@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Passing state from SPL to U-Boot proper
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <handoff.h>
+#include <mapmem.h>
+#include <u-boot/crc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static struct handoff_rec *handoff_first(struct handoff_hdr *hdr)
+{
+	return (void *)hdr + sizeof(*hdr);
+}
+
+static struct handoff_rec *handoff_next(struct handoff_rec *rec)
+{
+	return (void *)rec + sizeof(*rec) + ALIGN(rec->size, HANDOFF_ALIGN);
+}
+
+static struct handoff_rec *handoff_end(struct handoff_hdr *hdr)
+{
+	return (void *)hdr + hdr->size;
+}
+
+static u32 handoff_crc(struct handoff_hdr *hdr)
+{
+	return crc32(0, (u8 *)handoff_first(hdr), hdr->size - sizeof(*hdr));
+}
+
+int handoff_new(ulong addr, int size)
+{
+	struct handoff_hdr *hdr;
+
+	if (size < sizeof(*hdr))
+		return -ENOSPC;
+	hdr = map_sysmem(addr, size);
+	memset(hdr, '\0', sizeof(*hdr));
+	hdr->magic = HANDOFF_MAGIC;
+	hdr->version = HANDOFF_VERSION;
+	hdr->size = sizeof(*hdr);
+	hdr->max_size = size;
+	gd->handoff = hdr;
+
+	return 0;
+}
+
+static struct handoff_rec *handoff_find_rec(uint tag)
+{
+	struct handoff_hdr *hdr = gd->handoff;
+	struct handoff_rec *rec;
+
+	if (!hdr)
+		return NULL;
+	for (rec = handoff_first(hdr); rec < handoff_end(hdr);
+	     rec = handoff_next(rec)) {
+		if (rec->tag == tag)
+			return rec;
+	}
+
+	return NULL;
+}
+
+void *handoff_add(uint tag, int size)
+{
+	struct handoff_hdr *hdr;
+	struct handoff_rec *rec;
+	int len;
+
+#ifdef CONFIG_SPL_BUILD
+	if (!gd->handoff &&
+	    handoff_new(CONFIG_HANDOFF_ADDR, CONFIG_HANDOFF_SIZE))
+		return NULL;
+#endif
+	hdr = gd->handoff;
+	if (!hdr)
+		return NULL;
+	rec = handoff_find_rec(tag);
+	if (rec)
+		return rec->size == size ? rec + 1 : NULL;
+
+	len = sizeof(*rec) + ALIGN(size, HANDOFF_ALIGN);
+	if (hdr->size + len > hdr->max_size) {
+		debug("%s: No room for tag %u, size %#x\n", __func__, tag,
+		      size);
+		return NULL;
+	}
+	rec = handoff_end(hdr);
+	memset(rec, '\0', len);
+	rec->tag = tag;
+	rec->size = size;
+	hdr->size += len;
+
+	return rec + 1;
+}
+
+void *handoff_find(uint tag, int size)
+{
+	struct handoff_rec *rec = handoff_find_rec(tag);
+
+	if (!rec || rec->size != size)
+		return NULL;
+
+	return rec + 1;
+}
+
+int handoff_finish(void)
+{
+	struct handoff_hdr *hdr = gd->handoff;
+
+	if (!hdr)
+		return -ENOENT;
+	hdr->crc32 = handoff_crc(hdr);
+
+	return 0;
+}
+
+int handoff_check(ulong addr, int size)
+{
+	struct handoff_hdr *hdr;
+
+	if (size < sizeof(*hdr))
+		return -ENOENT;
+	hdr = map_sysmem(addr, size);
+	if (hdr->magic != HANDOFF_MAGIC)
+		return -ENOENT;
+	if (hdr->version != HANDOFF_VERSION)
+		return -EPROTO;
+	if (hdr->size < sizeof(*hdr) || hdr->size > hdr->max_size ||
+	    hdr->max_size > size || hdr->crc32 != handoff_crc(hdr))
+		return -EIO;
+	gd->handoff = hdr;
+
+	return 0;
+}
@@ -67,19 +67,30 @@ static const image_header_t *image_get_fdt(ulong fdt_addr)
 }
 #endif
 
+static void boot_fdt_reserve_region(struct lmb *lmb, uint64_t addr,
+				    uint64_t size)
+{
+	printf("   reserving fdt memory region: addr=%llx size=%llx\n",
+	       (unsigned long long)addr, (unsigned long long)size);
+	if (lmb_reserve(lmb, addr, size) < 0)
+		printf("ERROR: could not reserve fdt memory region\n");
+}
+
 /**
  * boot_fdt_add_mem_rsv_regions - Mark the memreserve sections as unusable
  * @lmb: pointer to lmb handle, will be used for memory mgmt
  * @fdt_blob: pointer to fdt blob base address
  *
- * Adds the memreserve regions in the dtb to the lmb block.  Adding the
- * memreserve regions prevents u-boot from using them to store the initrd
- * or the fdt blob.
+ * Adds the memreserve regions and the statically placed nodes below
+ * /reserved-memory in the dtb to the lmb block.  Adding the reserved
+ * regions prevents u-boot from using them to store the initrd or the fdt
+ * blob.
  */
 void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
 {
 	uint64_t addr, size;
-	int i, total;
+	int i, total, parent, node, na, ns, len;
+	const fdt32_t *reg;
 
 	if (fdt_check_header(fdt_blob) != 0)
 		return;
@@ -88,9 +99,33 @@ void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
 	for (i = 0; i < total; i++) {
 		if (fdt_get_mem_rsv(fdt_blob, i, &addr, &size) != 0)
 			continue;
-		printf("   reserving fdt memory region: addr=%llx size=%llx\n",
-		       (unsigned long long)addr, (unsigned long long)size);
-		lmb_reserve(lmb, addr, size);
+		boot_fdt_reserve_region(lmb, addr, size);
+	}
+
+	parent = fdt_path_offset(fdt_blob, "/reserved-memory");
+	if (parent < 0)
+		return;
+	na = fdt_address_cells(fdt_blob, parent);
+	ns = fdt_size_cells(fdt_blob, parent);
+	if (na < 1 || ns < 1)
+		return;
+	fdt_for_each_subnode(node, fdt_blob, parent) {
+		const char *status = fdt_getprop(fdt_blob, node, "status",
+						 NULL);
+
+		if (status && strcmp(status, "okay") && strcmp(status, "ok"))
+			continue;
+		/* Nodes without reg are allocated dynamically by the OS */
+		reg = fdt_getprop(fdt_blob, node, "reg", &len);
+		if (!reg)
+			continue;
+		for (; len >= (na + ns) * (int)sizeof(*reg);
+		     len -= (na + ns) * sizeof(*reg), reg += na + ns) {
+			addr = fdt_read_number(reg, na);
+			size = fdt_read_number(reg + na, ns);
+			if (size)
+				boot_fdt_reserve_region(lmb, addr, size);
+		}
 	}
 }
 
@@ -466,14 +501,17 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 {
 	ulong *initrd_start = &images->initrd_start;
 	ulong *initrd_end = &images->initrd_end;
+	struct fdt_batch batch;
 	int ret = -EPERM;
 	int fdt_ret;
 
-	if (fdt_root(blob) < 0) {
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FDT_FIXUP, "fdt_fixup");
+	fdt_batch_init(&batch, blob, true);
+	if (fdt_batch_root(&batch) < 0) {
 		printf("ERROR: root node setup failed\n");
 		goto err;
 	}
-	if (fdt_chosen(blob) < 0) {
+	if (fdt_batch_chosen(&batch) < 0) {
 		printf("ERROR: /chosen node create failed\n");
 		goto err;
 	}
@@ -482,7 +520,14 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		goto err;
 	}
 	/* Update ethernet nodes */
-	fdt_fixup_ethernet(blob);
+	fdt_batch_ethernet(&batch);
+	fdt_batch_initrd(&batch, *initrd_start, *initrd_end);
+	/* Write out the above before board code looks at the tree */
+	fdt_ret = fdt_batch_commit(&batch);
+	if (fdt_ret) {
+		printf("ERROR: fdt fixup failed: %s\n", fdt_strerror(fdt_ret));
+		goto err;
+	}
 	if (IMAGE_OF_BOARD_SETUP) {
 		fdt_ret = ft_board_setup(blob, gd->bd);
 		if (fdt_ret) {
@@ -509,16 +554,10 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	if (ret < 0)
 		goto err;
 	of_size = ret;
-
-	if (*initrd_start && *initrd_end) {
-		of_size += FDT_RAMDISK_OVERHEAD;
-		fdt_set_totalsize(blob, of_size);
-	}
 	/* Create a new LMB reservation */
 	if (lmb)
 		lmb_reserve(lmb, (ulong)blob, of_size);
 
-	fdt_initrd(blob, *initrd_start, *initrd_end);
 	if (!ft_verify_fdt(blob))
 		goto err;
 
@@ -526,9 +565,12 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	if (IMAGE_OF_BOARD_SETUP)
 		ft_board_setup_ex(blob, gd->bd);
 #endif
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FDT_FIXUP);
 
 	return 0;
 err:
+	fdt_batch_abort(&batch);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FDT_FIXUP);
 	printf(" - must RESET the board to recover.\n\n");
 
 	return ret;
@@ -847,6 +847,11 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
  * If the property is found its data start address and size are returned to
  * the caller.
  *
+ * Images with external data are supported as well: the data is then found
+ * at 'data-offset' behind the FIT structure, or at 'data-position' from the
+ * start of the FIT. Such data is used where it is, so a FIT whose kernel data
+ * already sits at the kernel load address needs no copy.
+ *
  * returns:
  *     0, on success
  *     -1, on failure
@@ -854,16 +859,70 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
 int fit_image_get_data(const void *fit, int noffset,
 		const void **data, size_t *size)
 {
-	int len;
+	int len, offset;
 
 	*data = fdt_getprop(fit, noffset, FIT_DATA_PROP, &len);
-	if (*data == NULL) {
-		fit_get_debug(fit, noffset, FIT_DATA_PROP, len);
-		*size = 0;
-		return -1;
+	if (*data) {
+		*size = len;
+		return 0;
+	}
+
+	if (!fit_image_get_data_size(fit, noffset, &len)) {
+		if (!fit_image_get_data_offset(fit, noffset, &offset)) {
+			*data = fit + ((fdt_totalsize(fit) + 3) & ~3) + offset;
+			*size = len;
+			return 0;
+		}
+		if (!fit_image_get_data_position(fit, noffset, &offset)) {
+			*data = fit + offset;
+			*size = len;
+			return 0;
+		}
+	}
+
+	fit_get_debug(fit, noffset, FIT_DATA_PROP, -FDT_ERR_NOTFOUND);
+	*size = 0;
+	return -1;
+}
+
+/**
+ * fit_get_kernel_placement() - Find where to load a FIT for a copy-free boot
+ *
+ * The kernel of the default configuration is used where its data lies in
+ * memory. If the FIT is loaded at the address returned here, that is the
+ * kernel load address, so the kernel is neither copied nor, if it is
+ * compressed, moved further than its compressed data.
+ *
+ * Only the FIT structure is needed, not the data that follows it. The
+ * kernel must have external data (mkimage -E) and a load address.
+ *
+ * @fit: pointer to the FIT structure
+ * @addrp: returns the address at which to load the whole FIT
+ * @return 0 if OK, -ENOENT if there is no kernel with a load address,
+ *	-EINVAL if its data is not external, -ERANGE if the FIT would have
+ *	to be loaded below address 0
+ */
+int fit_get_kernel_placement(const void *fit, ulong *addrp)
+{
+	int noffset, offset;
+	ulong load;
+
+	noffset = fit_conf_get_node(fit, NULL);
+	if (noffset < 0)
+		return -ENOENT;
+	noffset = fit_conf_get_prop_node(fit, noffset, FIT_KERNEL_PROP);
+	if (noffset < 0 || fit_image_get_load(fit, noffset, &load))
+		return -ENOENT;
+
+	if (fit_image_get_data_position(fit, noffset, &offset)) {
+		if (fit_image_get_data_offset(fit, noffset, &offset))
+			return -EINVAL;
+		offset += (fdt_totalsize(fit) + 3) & ~3;
 	}
+	if (load < offset)
+		return -ERANGE;
+	*addrp = load - offset;
 
-	*size = len;
 	return 0;
 }
 
@@ -1917,7 +1976,8 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 			bootstage_error(bootstage_id + BOOTSTAGE_SUB_LOAD);
 			return -EBADF;
 		}
-	} else if (load_op != FIT_LOAD_OPTIONAL_NON_ZERO || load) {
+	} else if ((load_op != FIT_LOAD_OPTIONAL_NON_ZERO || load) &&
+		   load != data) {
 		ulong image_start, image_end;
 		ulong load_end;
 		void *dst;
@@ -1977,6 +2037,9 @@ int boot_get_setup_fit(bootm_headers_t *images, uint8_t arch,
 }
 
 #ifndef USE_HOSTCC
+/* Space for lookups kept while applying a stack of overlays */
+#define FIT_OVERLAY_INDEX_SIZE	4096
+
 int boot_get_fdt_fit(bootm_headers_t *images, ulong addr,
 		   const char **fit_unamep, const char **fit_uname_configp,
 		   int arch, ulong *datap, ulong *lenp)
@@ -1995,6 +2058,8 @@ int boot_get_fdt_fit(bootm_headers_t *images, ulong addr,
 	const char *uname;
 	void *base, *ov;
 	int i, err, noffset, ov_noffset;
+	struct fdt_overlay_index ov_index, *idx = NULL;
+	void *ov_index_buf = NULL;
 #endif
 
 	fit_uname = fit_unamep ? *fit_unamep : NULL;
@@ -2048,6 +2113,14 @@ int boot_get_fdt_fit(bootm_headers_t *images, ulong addr,
 
 	base = map_sysmem(load, len);
 
+	/* share symbol and phandle lookups in the base between overlays */
+	ov_index_buf = malloc(FIT_OVERLAY_INDEX_SIZE);
+	if (ov_index_buf) {
+		fdt_overlay_index_init(&ov_index, ov_index_buf,
+				       FIT_OVERLAY_INDEX_SIZE);
+		idx = &ov_index;
+	}
+
 	/* apply extra configs in FIT first, followed by args */
 	for (i = 1; ; i++) {
 		if (i < count) {
@@ -2088,7 +2161,7 @@ int boot_get_fdt_fit(bootm_headers_t *images, ulong addr,
 			goto out;
 		}
 		/* the verbose method prints out messages on error */
-		err = fdt_overlay_apply_verbose(base, ov);
+		err = fdt_overlay_apply_index_verbose(base, ov, idx);
 		if (err < 0) {
 			fdt_noffset = err;
 			goto out;
@@ -2113,6 +2186,9 @@ out:
 
 	if (fit_uname_config_copy)
 		free(fit_uname_config_copy);
+#ifdef CONFIG_OF_LIBFDT_OVERLAY
+	free(ov_index_buf);
+#endif
 	return fdt_noffset;
 }
 #endif
@@ -12,32 +12,117 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
-void *malloc_simple(size_t bytes)
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_FREE)
+/*
+ * Memory is still handed out from the bottom of the pool, but each block is
+ * preceded by a word holding its size. Small blocks are rounded up to one of
+ * the size classes below and go back to a free list for their class when
+ * freed. Larger blocks go to a separate list and are reused by first fit.
+ *
+ * The list heads are kept at the start of the pool, so that they are set up
+ * again whenever the pool is (re)initialised by setting gd->malloc_ptr to
+ * zero. The lists hold offsets from gd->malloc_base, 0 meaning end of list.
+ *
+ * gd->malloc_ptr is never lowered, so it gives the high-water mark of the
+ * pool.
+ */
+static const ushort malloc_f_class[] = {
+	8, 16, 24, 32, 48, 64, 96, 128, 192, 256,
+};
+
+enum {
+	MALLOC_F_CLASSES	= ARRAY_SIZE(malloc_f_class),
+	MALLOC_F_LARGE		= MALLOC_F_CLASSES,	/* large blocks */
+	MALLOC_F_HDR		= sizeof(ulong),
+	MALLOC_F_LISTS_SIZE	= (MALLOC_F_LARGE + 1) * sizeof(ulong),
+};
+
+static void *malloc_f_map(ulong offset)
+{
+	return map_sysmem(gd->malloc_base + offset, 0);
+}
+
+static ulong malloc_f_offset(const void *ptr)
+{
+	return map_to_sysmem(ptr) - gd->malloc_base;
+}
+
+static ulong *malloc_f_lists(void)
+{
+	ulong *lists = malloc_f_map(0);
+
+	if (!gd->malloc_ptr) {
+		memset(lists, '\0', MALLOC_F_LISTS_SIZE);
+		gd->malloc_ptr = MALLOC_F_LISTS_SIZE;
+	}
+
+	return lists;
+}
+
+static int malloc_f_class_of(size_t bytes)
+{
+	int i;
+
+	for (i = 0; i < MALLOC_F_CLASSES; i++) {
+		if (bytes <= malloc_f_class[i])
+			return i;
+	}
+
+	return MALLOC_F_LARGE;
+}
+
+static ulong *malloc_f_size(void *ptr)
+{
+	return ptr - MALLOC_F_HDR;
+}
+
+/* Take a suitable block off a free list, or return NULL if there is none */
+static void *malloc_f_reuse(int class, size_t bytes, size_t align)
 {
-	ulong new_ptr;
+	ulong *lists = malloc_f_lists();
+	ulong *link;
 	void *ptr;
 
-	new_ptr = gd->malloc_ptr + bytes;
-	debug("%s: size=%zx, ptr=%lx, limit=%lx: ", __func__, bytes, new_ptr,
-	      gd->malloc_limit);
-	if (new_ptr > gd->malloc_limit) {
-		debug("space exhausted\n");
-		return NULL;
+	for (link = &lists[class]; *link; link = ptr) {
+		ptr = malloc_f_map(*link);
+		if (*malloc_f_size(ptr) >= bytes &&
+		    !(map_to_sysmem(ptr) & (align - 1))) {
+			*link = *(ulong *)ptr;
+			return ptr;
+		}
 	}
-	ptr = map_sysmem(gd->malloc_base + gd->malloc_ptr, bytes);
-	gd->malloc_ptr = ALIGN(new_ptr, sizeof(new_ptr));
-	debug("%lx\n", (ulong)ptr);
 
-	return ptr;
+	return NULL;
 }
+#else
+enum {
+	MALLOC_F_HDR		= 0,
+};
+#endif
 
-void *memalign_simple(size_t align, size_t bytes)
+static void *alloc_simple(size_t bytes, size_t align)
 {
 	ulong addr, new_ptr;
 	void *ptr;
 
-	addr = ALIGN(gd->malloc_base + gd->malloc_ptr, align);
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_FREE)
+	int class = malloc_f_class_of(bytes);
+
+	if (class == MALLOC_F_LARGE)
+		bytes = ALIGN(bytes, sizeof(ulong));
+	else
+		bytes = malloc_f_class[class];
+	ptr = malloc_f_reuse(class, bytes, align);
+	if (ptr) {
+		debug("%s: size=%zx, reused %lx\n", __func__, bytes,
+		      (ulong)ptr);
+		return ptr;
+	}
+#endif
+	addr = ALIGN(gd->malloc_base + gd->malloc_ptr + MALLOC_F_HDR, align);
 	new_ptr = addr + bytes - gd->malloc_base;
+	debug("%s: size=%zx, ptr=%lx, limit=%lx: ", __func__, bytes, new_ptr,
+	      gd->malloc_limit);
 	if (new_ptr > gd->malloc_limit) {
 		debug("space exhausted\n");
 		return NULL;
@@ -45,11 +130,64 @@ void *memalign_simple(size_t align, size_t bytes)
 
 	ptr = map_sysmem(addr, bytes);
 	gd->malloc_ptr = ALIGN(new_ptr, sizeof(new_ptr));
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_FREE)
+	*malloc_f_size(ptr) = bytes;
+#endif
 	debug("%lx\n", (ulong)ptr);
 
 	return ptr;
 }
 
+void *malloc_simple(size_t bytes)
+{
+	return alloc_simple(bytes, 1);
+}
+
+void *memalign_simple(size_t align, size_t bytes)
+{
+	return alloc_simple(bytes, align);
+}
+
+void free_simple(void *ptr)
+{
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_FREE)
+	ulong *lists = malloc_f_lists();
+	ulong offset;
+	int class;
+
+	if (!ptr)
+		return;
+	offset = malloc_f_offset(ptr);
+	if (offset < MALLOC_F_LISTS_SIZE + MALLOC_F_HDR ||
+	    offset >= gd->malloc_ptr)
+		return;
+	class = malloc_f_class_of(*malloc_f_size(ptr));
+	*(ulong *)ptr = lists[class];
+	lists[class] = offset;
+#endif
+}
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_FREE)
+void *realloc_simple(void *ptr, size_t bytes)
+{
+	size_t size;
+	void *new;
+
+	if (!ptr)
+		return malloc_simple(bytes);
+	size = *malloc_f_size(ptr);
+	if (bytes <= size)
+		return ptr;
+	new = malloc_simple(bytes);
+	if (!new)
+		return NULL;
+	memcpy(new, ptr, size);
+	free_simple(ptr);
+
+	return new;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(SYS_MALLOC_SIMPLE)
 void *calloc(size_t nmemb, size_t elem_size)
 {
@@ -57,7 +195,8 @@ void *calloc(size_t nmemb, size_t elem_size)
 	void *ptr;
 
 	ptr = malloc(size);
-	memset(ptr, '\0', size);
+	if (ptr)
+		memset(ptr, '\0', size);
 
 	return ptr;
 }
@@ -19,6 +19,7 @@
 #include <dm/root.h>
 #include <linux/compiler.h>
 #include <fdt_support.h>
+#include <handoff.h>
 #include <bootcount.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -452,6 +453,45 @@ static int boot_from_devices(struct spl_image_info *spl_image,
 	return -ENODEV;
 }
 
+#if CONFIG_IS_ENABLED(HANDOFF)
+/* Record what SPL has set up, so that U-Boot need not do it again */
+static void spl_save_handoff(void)
+{
+	struct handoff_clocks *clk;
+	int ret;
+
+#ifdef CONFIG_NR_DRAM_BANKS
+	/* The banks are only known if the board has set them up in SPL */
+	if (gd->ram_size && gd->bd->bi_dram[0].size) {
+		struct handoff_dram *dram;
+		int i;
+
+		dram = handoff_add(HANDOFF_TAG_DRAM, sizeof(*dram));
+		if (dram) {
+			dram->ram_size = gd->ram_size;
+			for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
+				dram->bank[i].start = gd->bd->bi_dram[i].start;
+				dram->bank[i].size = gd->bd->bi_dram[i].size;
+			}
+		}
+	}
+#endif
+	if (gd->cpu_clk) {
+		clk = handoff_add(HANDOFF_TAG_CLOCKS, sizeof(*clk));
+		if (clk) {
+			clk->cpu_clk = gd->cpu_clk;
+			clk->bus_clk = gd->bus_clk;
+			clk->mem_clk = gd->mem_clk;
+		}
+	}
+	ret = handoff_finish();
+	if (ret) {
+		debug("Failed to write SPL handoff: err=%d\n", ret);
+		handoff_invalidate(CONFIG_HANDOFF_ADDR);
+	}
+}
+#endif
+
 void board_init_r(gd_t *dummy1, ulong dummy2)
 {
 	u32 spl_boot_list[] = {
@@ -532,6 +572,17 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 #if CONFIG_VAL(SYS_MALLOC_F_LEN) && !defined(CONFIG_SYS_SPL_MALLOC_SIZE)
 	debug("SPL malloc() used %#lx bytes (%ld KB)\n", gd->malloc_ptr,
 	      gd->malloc_ptr / 1024);
+	bootstage_value(BOOTSTAGE_ID_MALLOC_F_SPL, "malloc_f_spl",
+			gd->malloc_ptr);
+#endif
+	/* Do not leave an area from an earlier boot for U-Boot to find */
+#if CONFIG_IS_ENABLED(HANDOFF)
+	if (spl_image.os == IH_OS_U_BOOT)
+		spl_save_handoff();
+	else
+		handoff_invalidate(CONFIG_HANDOFF_ADDR);
+#elif defined(CONFIG_HANDOFF)
+	handoff_invalidate(CONFIG_HANDOFF_ADDR);
 #endif
 #ifdef CONFIG_BOOTSTAGE_STASH
 	int ret;
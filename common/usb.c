@@ -281,6 +281,57 @@ int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 		return -EIO;
 }
 
+/*
+ * submits a bulk message without waiting for it to complete, so that
+ * further messages can be queued behind it. Returns -ENOSYS if the host
+ * controller cannot do this, in which case usb_bulk_msg() must be used.
+ */
+int usb_bulk_msg_queue(struct usb_device *dev, unsigned int pipe,
+			void *data, int len)
+{
+#ifdef CONFIG_DM_USB
+	if (len < 0)
+		return -EINVAL;
+	dev->status = USB_ST_NOT_PROC; /*not yet processed */
+	return queue_bulk_msg(dev, pipe, data, len);
+#else
+	return -ENOSYS;
+#endif
+}
+
+/*
+ * waits for the oldest message queued by usb_bulk_msg_queue() on a pipe.
+ * Returns 0 if Ok, and the actual transferred length in actual_length.
+ */
+int usb_bulk_msg_complete(struct usb_device *dev, unsigned int pipe,
+			int *actual_length)
+{
+#ifdef CONFIG_DM_USB
+	int ret;
+
+	ret = complete_bulk_msg(dev, pipe);
+	*actual_length = dev->act_len;
+	if (ret < 0 || dev->status != 0)
+		return -EIO;
+
+	return 0;
+#else
+	return -ENOSYS;
+#endif
+}
+
+/*
+ * cancels all messages queued by usb_bulk_msg_queue() on a pipe, without
+ * waiting for them. Returns 0 if Ok.
+ */
+int usb_bulk_msg_cancel(struct usb_device *dev, unsigned int pipe)
+{
+#ifdef CONFIG_DM_USB
+	return cancel_bulk_msg(dev, pipe);
+#else
+	return -ENOSYS;
+#endif
+}
 
 /*-------------------------------------------------------------------
  * Max Packet stuff
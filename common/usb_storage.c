@@ -57,7 +57,7 @@
 static const unsigned char us_direction[256/8] = {
 	0x28, 0x81, 0x14, 0x14, 0x20, 0x01, 0x90, 0x77,
 	0x0C, 0x20, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01,
+	0x00, 0x01, 0x00, 0x40, 0x00, 0x01, 0x00, 0x01,
 	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 #define US_DIRECTION(x) ((us_direction[x>>3] >> (x & 7)) & 1)
@@ -80,6 +80,7 @@ struct us_data {
 
 	unsigned int	flags;			/* from filter initially */
 #	define USB_READY	(1 << 0)
+#	define USB_CMD16	(1 << 1)	/* use 16-byte READ/WRITE */
 	unsigned char	ifnum;			/* interface number */
 	unsigned char	ep_in;			/* in endpoint */
 	unsigned char	ep_out;			/* out ....... */
@@ -97,7 +98,7 @@ struct us_data {
 	struct scsi_cmd	*srb;			/* current srb */
 	trans_reset	transport_reset;	/* reset routine */
 	trans_cmnd	transport;		/* transport routine */
-	unsigned short	max_xfer_blk;		/* maximum transfer blocks */
+	unsigned int	max_xfer_blk;		/* maximum transfer blocks */
 };
 
 #ifndef CONFIG_BLK
@@ -527,18 +528,23 @@ static int usb_stor_CB_reset(struct us_data *us)
 }
 
 /*
- * Set up the command for a BBB device. Note that the actual SCSI
- * command is copied into cbw.CBWCDB.
+ * Set up the command for a BBB device and send the CBW. Note that the actual
+ * SCSI command is copied into cbw.CBWCDB. For commands which read data, the
+ * data stage is queued behind the CBW if the host controller supports it, so
+ * that it starts as soon as the CBW has gone. In that case *data_queuedp is
+ * set and the data must be collected with usb_bulk_msg_complete().
  */
-static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
+static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us,
+			       bool *data_queuedp)
 {
 	int result;
 	int actlen;
 	int dir_in;
-	unsigned int pipe;
+	unsigned int pipe, pipein;
 	ALLOC_CACHE_ALIGN_BUFFER(struct umass_bbb_cbw, cbw, 1);
 
 	dir_in = US_DIRECTION(srb->cmd[0]);
+	*data_queuedp = false;
 
 #ifdef BBB_COMDAT_TRACE
 	printf("dir %d lun %d cmdlen %d cmd %p datalen %lu pdata %p\n",
@@ -569,8 +575,22 @@ static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
 	/* DST SRC LEN!!! */
 
 	memcpy(cbw->CBWCDB, srb->cmd, srb->cmdlen);
-	result = usb_bulk_msg(us->pusb_dev, pipe, cbw, UMASS_BBB_CBW_SIZE,
-			      &actlen, USB_CNTL_TIMEOUT * 5);
+	if (dir_in && srb->datalen &&
+	    !usb_bulk_msg_queue(us->pusb_dev, pipe, cbw, UMASS_BBB_CBW_SIZE)) {
+		pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
+		*data_queuedp = !usb_bulk_msg_queue(us->pusb_dev, pipein,
+						    srb->pdata, srb->datalen);
+		result = usb_bulk_msg_complete(us->pusb_dev, pipe, &actlen);
+		if (result < 0 && *data_queuedp) {
+			/* The data will never come, so cancel the transfer */
+			usb_bulk_msg_cancel(us->pusb_dev, pipein);
+			*data_queuedp = false;
+		}
+	} else {
+		result = usb_bulk_msg(us->pusb_dev, pipe, cbw,
+				      UMASS_BBB_CBW_SIZE, &actlen,
+				      USB_CNTL_TIMEOUT * 5);
+	}
 	if (result < 0)
 		debug("usb_stor_BBB_comdat:usb_bulk_msg error\n");
 	return result;
@@ -709,6 +729,7 @@ static int usb_stor_BBB_transport(struct scsi_cmd *srb, struct us_data *us)
 	int dir_in;
 	int actlen, data_actlen;
 	unsigned int pipe, pipein, pipeout;
+	bool data_queued;
 	ALLOC_CACHE_ALIGN_BUFFER(struct umass_bbb_csw, csw, 1);
 #ifdef BBB_XPORT_TRACE
 	unsigned char *ptr;
@@ -719,7 +740,7 @@ static int usb_stor_BBB_transport(struct scsi_cmd *srb, struct us_data *us)
 
 	/* COMMAND phase */
 	debug("COMMAND phase\n");
-	result = usb_stor_BBB_comdat(srb, us);
+	result = usb_stor_BBB_comdat(srb, us, &data_queued);
 	if (result < 0) {
 		debug("failed to send CBW status %ld\n",
 		      us->pusb_dev->status);
@@ -741,8 +762,13 @@ static int usb_stor_BBB_transport(struct scsi_cmd *srb, struct us_data *us)
 	else
 		pipe = pipeout;
 
-	result = usb_bulk_msg(us->pusb_dev, pipe, srb->pdata, srb->datalen,
-			      &data_actlen, USB_CNTL_TIMEOUT * 5);
+	if (data_queued)
+		result = usb_bulk_msg_complete(us->pusb_dev, pipe,
+					       &data_actlen);
+	else
+		result = usb_bulk_msg(us->pusb_dev, pipe, srb->pdata,
+				      srb->datalen, &data_actlen,
+				      USB_CNTL_TIMEOUT * 5);
 	/* special handling of STALL in DATA phase */
 	if ((result < 0) && (us->pusb_dev->status & USB_ST_STALLED)) {
 		debug("DATA:stall\n");
@@ -941,7 +967,7 @@ do_retry:
 static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 				      struct us_data *us)
 {
-	unsigned short blk;
+	unsigned int blk;
 	size_t __maybe_unused size;
 	int __maybe_unused ret;
 
@@ -962,8 +988,9 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 		/* unimplemented, let's use default 20 */
 		blk = 20;
 	} else {
-		if (size > USHRT_MAX * 512)
-			size = USHRT_MAX * 512;
+		/* READ(16) and WRITE(16) are limited to a 32-bit count */
+		if (size / 512 > UINT_MAX)
+			size = (size_t)UINT_MAX * 512;
 		blk = size / 512;
 	}
 #endif
@@ -971,6 +998,18 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	us->max_xfer_blk = blk;
 }
 
+/*
+ * Get the number of blocks which can be transferred by a single READ/WRITE
+ * command, taking into account the 16-bit count of the 10-byte commands.
+ */
+static unsigned int usb_stor_cmd_max_blk(struct us_data *us)
+{
+	if (us->flags & USB_CMD16)
+		return us->max_xfer_blk;
+
+	return min_t(unsigned int, us->max_xfer_blk, USHRT_MAX);
+}
+
 static int usb_inquiry(struct scsi_cmd *srb, struct us_data *ss)
 {
 	int retry, i;
@@ -1064,6 +1103,25 @@ static int usb_read_capacity(struct scsi_cmd *srb, struct us_data *ss)
 	return -1;
 }
 
+static int usb_read_capacity16(struct scsi_cmd *srb, struct us_data *ss)
+{
+	int retry;
+
+	retry = 3;
+	do {
+		memset(&srb->cmd[0], 0, 16);
+		srb->cmd[0] = SCSI_RD_CAPAC16;
+		srb->cmd[1] = 0x10;	/* service action: READ CAPACITY(16) */
+		srb->cmd[13] = 32;	/* allocation length */
+		srb->datalen = 32;
+		srb->cmdlen = 16;
+		if (ss->transport(srb, ss) == USB_STOR_TRANSPORT_GOOD)
+			return 0;
+	} while (retry--);
+
+	return -1;
+}
+
 static int usb_read_10(struct scsi_cmd *srb, struct us_data *ss,
 		       unsigned long start, unsigned short blocks)
 {
@@ -1098,6 +1156,42 @@ static int usb_write_10(struct scsi_cmd *srb, struct us_data *ss,
 	return ss->transport(srb, ss);
 }
 
+static void usb_setup_rw_16(struct scsi_cmd *srb, u8 opcode, u64 start,
+			    unsigned int blocks)
+{
+	memset(&srb->cmd[0], 0, 16);
+	srb->cmd[0] = opcode;
+	srb->cmd[2] = ((unsigned char) (start >> 56)) & 0xff;
+	srb->cmd[3] = ((unsigned char) (start >> 48)) & 0xff;
+	srb->cmd[4] = ((unsigned char) (start >> 40)) & 0xff;
+	srb->cmd[5] = ((unsigned char) (start >> 32)) & 0xff;
+	srb->cmd[6] = ((unsigned char) (start >> 24)) & 0xff;
+	srb->cmd[7] = ((unsigned char) (start >> 16)) & 0xff;
+	srb->cmd[8] = ((unsigned char) (start >> 8)) & 0xff;
+	srb->cmd[9] = ((unsigned char) (start)) & 0xff;
+	srb->cmd[10] = ((unsigned char) (blocks >> 24)) & 0xff;
+	srb->cmd[11] = ((unsigned char) (blocks >> 16)) & 0xff;
+	srb->cmd[12] = ((unsigned char) (blocks >> 8)) & 0xff;
+	srb->cmd[13] = (unsigned char) blocks & 0xff;
+	srb->cmdlen = 16;
+}
+
+static int usb_read_16(struct scsi_cmd *srb, struct us_data *ss,
+		       u64 start, unsigned int blocks)
+{
+	usb_setup_rw_16(srb, SCSI_READ16, start, blocks);
+	debug("read16: start %llx blocks %x\n", start, blocks);
+	return ss->transport(srb, ss);
+}
+
+static int usb_write_16(struct scsi_cmd *srb, struct us_data *ss,
+			u64 start, unsigned int blocks)
+{
+	usb_setup_rw_16(srb, SCSI_WRITE16, start, blocks);
+	debug("write16: start %llx blocks %x\n", start, blocks);
+	return ss->transport(srb, ss);
+}
+
 
 #ifdef CONFIG_USB_BIN_FIXUP
 /*
@@ -1132,7 +1226,7 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 {
 	lbaint_t start, blks;
 	uintptr_t buf_addr;
-	unsigned short smallblks;
+	unsigned int smallblks, max_blk;
 	struct usb_device *udev;
 	struct us_data *ss;
 	int retry;
@@ -1157,6 +1251,7 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 	}
 #endif
 	ss = (struct us_data *)udev->privptr;
+	max_blk = usb_stor_cmd_max_blk(ss);
 
 	usb_disable_asynch(1); /* asynch transfer not allowed */
 	srb->lun = block_dev->lun;
@@ -1171,16 +1266,18 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 		/* XXX need some comment here */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (blks > ss->max_xfer_blk)
-			smallblks = ss->max_xfer_blk;
+		if (blks > max_blk)
+			smallblks = max_blk;
 		else
-			smallblks = (unsigned short) blks;
+			smallblks = (unsigned int) blks;
 retry_it:
-		if (smallblks == ss->max_xfer_blk)
+		if (smallblks == max_blk)
 			usb_show_progress();
 		srb->datalen = block_dev->blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_read_10(srb, ss, start, smallblks)) {
+		if (ss->flags & USB_CMD16 ?
+		    usb_read_16(srb, ss, start, smallblks) :
+		    usb_read_10(srb, ss, start, smallblks)) {
 			debug("Read ERROR\n");
 			usb_request_sense(srb, ss);
 			if (retry--)
@@ -1199,7 +1296,7 @@ retry_it:
 	      start, smallblks, buf_addr);
 
 	usb_disable_asynch(0); /* asynch transfer allowed */
-	if (blkcnt >= ss->max_xfer_blk)
+	if (blkcnt >= max_blk)
 		debug("\n");
 	return blkcnt;
 }
@@ -1214,7 +1311,7 @@ static unsigned long usb_stor_write(struct blk_desc *block_dev, lbaint_t blknr,
 {
 	lbaint_t start, blks;
 	uintptr_t buf_addr;
-	unsigned short smallblks;
+	unsigned int smallblks, max_blk;
 	struct usb_device *udev;
 	struct us_data *ss;
 	int retry;
@@ -1240,6 +1337,7 @@ static unsigned long usb_stor_write(struct blk_desc *block_dev, lbaint_t blknr,
 	}
 #endif
 	ss = (struct us_data *)udev->privptr;
+	max_blk = usb_stor_cmd_max_blk(ss);
 
 	usb_disable_asynch(1); /* asynch transfer not allowed */
 
@@ -1257,16 +1355,18 @@ static unsigned long usb_stor_write(struct blk_desc *block_dev, lbaint_t blknr,
 		 */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (blks > ss->max_xfer_blk)
-			smallblks = ss->max_xfer_blk;
+		if (blks > max_blk)
+			smallblks = max_blk;
 		else
-			smallblks = (unsigned short) blks;
+			smallblks = (unsigned int) blks;
 retry_it:
-		if (smallblks == ss->max_xfer_blk)
+		if (smallblks == max_blk)
 			usb_show_progress();
 		srb->datalen = block_dev->blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_write_10(srb, ss, start, smallblks)) {
+		if (ss->flags & USB_CMD16 ?
+		    usb_write_16(srb, ss, start, smallblks) :
+		    usb_write_10(srb, ss, start, smallblks)) {
 			debug("Write ERROR\n");
 			usb_request_sense(srb, ss);
 			if (retry--)
@@ -1284,7 +1384,7 @@ retry_it:
 	      PRIxPTR "\n", start, smallblks, buf_addr);
 
 	usb_disable_asynch(0); /* asynch transfer allowed */
-	if (blkcnt >= ss->max_xfer_blk)
+	if (blkcnt >= max_blk)
 		debug("\n");
 	return blkcnt;
 
@@ -1417,9 +1517,10 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 		      struct blk_desc *dev_desc)
 {
 	unsigned char perq, modi;
-	ALLOC_CACHE_ALIGN_BUFFER(u32, cap, 2);
+	ALLOC_CACHE_ALIGN_BUFFER(u32, cap, 8);
 	ALLOC_CACHE_ALIGN_BUFFER(u8, usb_stor_buf, 36);
-	u32 capacity, blksz;
+	u64 capacity;
+	u32 blksz;
 	struct scsi_cmd *pccb = &usb_ccb;
 
 	pccb->pdata = usb_stor_buf;
@@ -1486,10 +1587,37 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 	cap[1] = cpu_to_be32(cap[1]);
 #endif
 
-	capacity = be32_to_cpu(cap[0]) + 1;
+	capacity = (u64)be32_to_cpu(cap[0]) + 1;
 	blksz = be32_to_cpu(cap[1]);
 
-	debug("Capacity = 0x%08x, blocksz = 0x%08x\n", capacity, blksz);
+	/*
+	 * A device which is too large for READ CAPACITY(10) reports the
+	 * maximum value, and must then be accessed with 16-byte commands
+	 */
+	if (be32_to_cpu(cap[0]) == 0xffffffff && ss->protocol == US_PR_BULK) {
+		memset(pccb->pdata, 0, 32);
+		if (usb_read_capacity16(pccb, ss) == 0) {
+			capacity = ((u64)be32_to_cpu(cap[0]) << 32 |
+				    be32_to_cpu(cap[1])) + 1;
+			blksz = be32_to_cpu(cap[2]);
+			ss->flags |= USB_CMD16;
+		} else {
+			/* READ(10) cannot address the whole device */
+			printf("READ_CAP16 ERROR\n");
+			return -EIO;
+		}
+	}
+	if (capacity != (lbaint_t)capacity) {
+		printf("Device too large, enable CONFIG_SYS_64BIT_LBA\n");
+		capacity = (lbaint_t)-1;
+	}
+
+	/* The length passed to usb_bulk_msg() must fit in an int */
+	if (blksz)
+		ss->max_xfer_blk = min_t(unsigned int, ss->max_xfer_blk,
+					 INT_MAX / blksz);
+
+	debug("Capacity = 0x%llx, blocksz = 0x%08x\n", capacity, blksz);
 	dev_desc->lba = capacity;
 	dev_desc->blksz = blksz;
 	dev_desc->log2blksz = LOG2(dev_desc->blksz);
@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <blk.h>
+#include <bootstage.h>
 #include <dm.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -401,12 +402,123 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+#if CONFIG_IS_ENABLED(BLK_STATS)
+static ulong blk_stats_start(void)
+{
+	bootstage_start(BOOTSTAGE_ID_ACCUM_BLK, "blk_io");
+
+	return timer_get_us();
+}
+
+/**
+ * blk_stats_end() - Record a request which has been handled by the driver
+ *
+ * @desc:	Block device
+ * @op:		Operation which was performed
+ * @blkcnt:	Number of blocks requested
+ * @done:	Number of blocks handled by the driver, or -ve error
+ * @start_us:	Time the request was passed to the driver
+ */
+static void blk_stats_end(struct blk_desc *desc, enum blk_stats_op op,
+			  lbaint_t blkcnt, ulong done, ulong start_us)
+{
+	struct blk_op_stats *st = &desc->stats.op[op];
+	ulong us = timer_get_us() - start_us;
+	int bucket;
+
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_BLK);
+	if (!st->ops || us < st->min_us)
+		st->min_us = us;
+	if (us > st->max_us)
+		st->max_us = us;
+	st->ops++;
+	st->total_us += us;
+	if (IS_ERR_VALUE(done) || done != blkcnt)
+		st->errors++;
+	if (!IS_ERR_VALUE(done))
+		st->blocks += done;
+	for (bucket = 0; blkcnt > 1 && bucket < BLK_STATS_HIST_COUNT - 1;
+	     blkcnt >>= 1)
+		bucket++;
+	st->hist[bucket]++;
+}
+
+void blk_reset_stats(struct udevice *dev)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+
+	memset(&desc->stats, '\0', sizeof(desc->stats));
+}
+
+int blk_stats_fdt_add(void *blob, int parent)
+{
+	static const char *const op_name[BLK_STATS_OP_COUNT] = {
+		"read", "write", "erase",
+	};
+	struct udevice *dev;
+	char name[20];
+	int node, op;
+	int ret;
+
+	for (uclass_find_first_device(UCLASS_BLK, &dev);
+	     dev;
+	     uclass_find_next_device(&dev)) {
+		struct blk_desc *desc = dev_get_uclass_platdata(dev);
+
+		for (op = 0; op < BLK_STATS_OP_COUNT; op++) {
+			if (desc->stats.op[op].ops)
+				break;
+		}
+		if (op == BLK_STATS_OP_COUNT)
+			continue;
+		node = fdt_add_subnode(blob, parent, dev->name);
+		if (node < 0)
+			return -ENOSPC;
+		for (op = 0; op < BLK_STATS_OP_COUNT; op++) {
+			struct blk_op_stats *st = &desc->stats.op[op];
+
+			if (!st->ops)
+				continue;
+			snprintf(name, sizeof(name), "%s-ops", op_name[op]);
+			ret = fdt_setprop_u32(blob, node, name, st->ops);
+			snprintf(name, sizeof(name), "%s-blocks", op_name[op]);
+			ret |= fdt_setprop_u64(blob, node, name, st->blocks);
+			snprintf(name, sizeof(name), "%s-us", op_name[op]);
+			ret |= fdt_setprop_u64(blob, node, name, st->total_us);
+			if (ret)
+				return -ENOSPC;
+		}
+	}
+
+	return 0;
+}
+#else
+static inline ulong blk_stats_start(void)
+{
+	return 0;
+}
+
+static inline void blk_stats_end(struct blk_desc *desc, enum blk_stats_op op,
+				 lbaint_t blkcnt, ulong done, ulong start_us)
+{
+}
+
+void blk_reset_stats(struct udevice *dev)
+{
+}
+
+int blk_stats_fdt_add(void *blob, int parent)
+{
+	return 0;
+}
+#endif
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
-	ulong blks_read;
+	ulong blks_read, start_us;
 
 	if (!ops->read)
 		return -ENOSYS;
@@ -414,7 +526,9 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
+	start_us = blk_stats_start();
 	blks_read = ops->read(dev, start, blkcnt, buffer);
+	blk_stats_end(block_dev, BLK_STATS_READ, blkcnt, blks_read, start_us);
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
 			      start, blkcnt, block_dev->blksz, buffer);
@@ -427,12 +541,19 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks_written, start_us;
 
 	if (!ops->write)
 		return -ENOSYS;
 
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return ops->write(dev, start, blkcnt, buffer);
+	fs_invalidate();
+	start_us = blk_stats_start();
+	blks_written = ops->write(dev, start, blkcnt, buffer);
+	blk_stats_end(block_dev, BLK_STATS_WRITE, blkcnt, blks_written,
+		      start_us);
+
+	return blks_written;
 }
 
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
@@ -440,12 +561,19 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks_erased, start_us;
 
 	if (!ops->erase)
 		return -ENOSYS;
 
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return ops->erase(dev, start, blkcnt);
+	fs_invalidate();
+	start_us = blk_stats_start();
+	blks_erased = ops->erase(dev, start, blkcnt);
+	blk_stats_end(block_dev, BLK_STATS_ERASE, blkcnt, blks_erased,
+		      start_us);
+
+	return blks_erased;
 }
 
 int blk_prepare_device(struct udevice *dev)
@@ -13,6 +13,7 @@
 #include <malloc.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
+#include <dm/root.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -72,7 +73,7 @@ int device_unbind(struct udevice *dev)
 	if (!dev)
 		return -EINVAL;
 
-	if (dev->flags & DM_FLAG_ACTIVATED)
+	if (dev->flags & (DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING))
 		return -EINVAL;
 
 	if (!(dev->flags & DM_FLAG_BOUND))
@@ -109,6 +110,7 @@ int device_unbind(struct udevice *dev)
 
 	if (dev->parent)
 		list_del(&dev->sibling_node);
+	dm_lazy_forget(dev);
 
 	devres_release_all(dev);
 
@@ -168,7 +170,7 @@ int device_remove(struct udevice *dev, uint flags)
 	if (!dev)
 		return -EINVAL;
 
-	if (!(dev->flags & DM_FLAG_ACTIVATED))
+	if (!(dev->flags & (DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING)))
 		return 0;
 
 	drv = dev->driver;
@@ -204,7 +206,7 @@ int device_remove(struct udevice *dev, uint flags)
 		device_free(dev);
 
 		dev->seq = -1;
-		dev->flags &= ~DM_FLAG_ACTIVATED;
+		dev->flags &= ~(DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING);
 	}
 
 	return ret;
@@ -29,6 +29,34 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Alignment of each part of a device's arena, as malloc() would give */
+#define DM_ARENA_ALIGN(size)	ALIGN(size, 2 * sizeof(size_t))
+
+/**
+ * device_alloc_pdata() - Allocate platform data for a device being bound
+ *
+ * @dev: Device to allocate for
+ * @arenap: Pointer to the next free space in the device's arena, which is
+ *	updated, or pointer to NULL to allocate the data separately
+ * @size: Number of bytes to allocate
+ * @flag: Device flag to set if the data is allocated separately, and so
+ *	needs to be freed separately
+ * @return pointer to zeroed data, or NULL if out of memory
+ */
+static void *device_alloc_pdata(struct udevice *dev, void **arenap, int size,
+				uint flag)
+{
+	void *ptr = *arenap;
+
+	if (ptr) {
+		*arenap = ptr + DM_ARENA_ALIGN(size);
+		return ptr;
+	}
+	dev->flags |= flag;
+
+	return calloc(1, size);
+}
+
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *platdata,
 			      ulong driver_data, ofnode node,
@@ -36,20 +64,58 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 {
 	struct udevice *dev;
 	struct uclass *uc;
-	int size, ret = 0;
+	int plat_size = 0, uc_plat_size, parent_plat_size = 0;
+	void *arena = NULL;
+	uint flags = 0;
+	int ret = 0;
 
 	if (devp)
 		*devp = NULL;
 	if (!name)
 		return -EINVAL;
 
-	ret = uclass_get(drv->id, &uc);
+	ret = uclass_find_or_add(drv->id, &uc);
 	if (ret) {
 		debug("Missing uclass for driver %s\n", drv->name);
 		return ret;
 	}
 
-	dev = calloc(1, sizeof(struct udevice));
+	/* Work out which platform data must be allocated */
+	if (drv->platdata_auto_alloc_size) {
+		bool alloc = !platdata;
+
+		if (CONFIG_IS_ENABLED(OF_PLATDATA) ||
+		    CONFIG_IS_ENABLED(OF_PLATDATA_NODES)) {
+			if (of_platdata_size) {
+				flags |= DM_FLAG_OF_PLATDATA;
+				if (of_platdata_size <
+						drv->platdata_auto_alloc_size)
+					alloc = true;
+			}
+		}
+		if (alloc)
+			plat_size = drv->platdata_auto_alloc_size;
+	}
+	uc_plat_size = uc->uc_drv->per_device_platdata_auto_alloc_size;
+	if (parent) {
+		parent_plat_size = parent->driver->
+					per_child_platdata_auto_alloc_size;
+		if (!parent_plat_size) {
+			parent_plat_size = parent->uclass->uc_drv->
+					per_child_platdata_auto_alloc_size;
+		}
+	}
+
+	if (CONFIG_IS_ENABLED(DM_DEVICE_ARENA)) {
+		dev = calloc(1, DM_ARENA_ALIGN(sizeof(struct udevice)) +
+			     DM_ARENA_ALIGN(plat_size) +
+			     DM_ARENA_ALIGN(uc_plat_size) + parent_plat_size);
+		if (dev)
+			arena = (void *)dev +
+				DM_ARENA_ALIGN(sizeof(struct udevice));
+	} else {
+		dev = calloc(1, sizeof(struct udevice));
+	}
 	if (!dev)
 		return -ENOMEM;
 
@@ -66,6 +132,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	dev->parent = parent;
 	dev->driver = drv;
 	dev->uclass = uc;
+	dev->flags = flags;
 
 	dev->seq = -1;
 	dev->req_seq = -1;
@@ -84,55 +151,35 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		}
 	}
 
-	if (drv->platdata_auto_alloc_size) {
-		bool alloc = !platdata;
-
-		if (CONFIG_IS_ENABLED(OF_PLATDATA)) {
-			if (of_platdata_size) {
-				dev->flags |= DM_FLAG_OF_PLATDATA;
-				if (of_platdata_size <
-						drv->platdata_auto_alloc_size)
-					alloc = true;
-			}
-		}
-		if (alloc) {
-			dev->flags |= DM_FLAG_ALLOC_PDATA;
-			dev->platdata = calloc(1,
-					       drv->platdata_auto_alloc_size);
-			if (!dev->platdata) {
-				ret = -ENOMEM;
-				goto fail_alloc1;
-			}
-			if (CONFIG_IS_ENABLED(OF_PLATDATA) && platdata) {
-				memcpy(dev->platdata, platdata,
-				       of_platdata_size);
-			}
+	if (plat_size) {
+		dev->platdata = device_alloc_pdata(dev, &arena, plat_size,
+						   DM_FLAG_ALLOC_PDATA);
+		if (!dev->platdata) {
+			ret = -ENOMEM;
+			goto fail_alloc1;
 		}
+		if ((CONFIG_IS_ENABLED(OF_PLATDATA) ||
+		     CONFIG_IS_ENABLED(OF_PLATDATA_NODES)) && platdata)
+			memcpy(dev->platdata, platdata, of_platdata_size);
 	}
 
-	size = uc->uc_drv->per_device_platdata_auto_alloc_size;
-	if (size) {
-		dev->flags |= DM_FLAG_ALLOC_UCLASS_PDATA;
-		dev->uclass_platdata = calloc(1, size);
+	if (uc_plat_size) {
+		dev->uclass_platdata = device_alloc_pdata(dev, &arena,
+						uc_plat_size,
+						DM_FLAG_ALLOC_UCLASS_PDATA);
 		if (!dev->uclass_platdata) {
 			ret = -ENOMEM;
 			goto fail_alloc2;
 		}
 	}
 
-	if (parent) {
-		size = parent->driver->per_child_platdata_auto_alloc_size;
-		if (!size) {
-			size = parent->uclass->uc_drv->
-					per_child_platdata_auto_alloc_size;
-		}
-		if (size) {
-			dev->flags |= DM_FLAG_ALLOC_PARENT_PDATA;
-			dev->parent_platdata = calloc(1, size);
-			if (!dev->parent_platdata) {
-				ret = -ENOMEM;
-				goto fail_alloc3;
-			}
+	if (parent_plat_size) {
+		dev->parent_platdata = device_alloc_pdata(dev, &arena,
+						parent_plat_size,
+						DM_FLAG_ALLOC_PARENT_PDATA);
+		if (!dev->parent_platdata) {
+			ret = -ENOMEM;
+			goto fail_alloc3;
 		}
 	}
 
@@ -242,7 +289,7 @@ int device_bind_by_name(struct udevice *parent, bool pre_reloc_only,
 	if (pre_reloc_only && !(drv->flags & DM_FLAG_PRE_RELOC))
 		return -EPERM;
 
-#if CONFIG_IS_ENABLED(OF_PLATDATA)
+#if CONFIG_IS_ENABLED(OF_PLATDATA) || CONFIG_IS_ENABLED(OF_PLATDATA_NODES)
 	platdata_size = info->platdata_size;
 #endif
 	return device_bind_common(parent, drv, info->name,
@@ -294,19 +341,34 @@ static void *alloc_priv(int size, uint flags)
 	return priv;
 }
 
-int device_probe(struct udevice *dev)
+/* Undo the effects of a failed probe */
+static int device_probe_fail(struct udevice *dev, int ret)
+{
+	dev->flags &= ~(DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING);
+
+	dev->seq = -1;
+	device_free(dev);
+
+	return ret;
+}
+
+/**
+ * device_probe_prepare() - Get a device ready for its driver's probe method
+ *
+ * This allocates memory, probes the parents and handles everything that
+ * happens before the driver is called.
+ *
+ * @dev: Device to prepare
+ * @return 0 if ready, 1 if the device was probed while probing its parent,
+ * -ve on error
+ */
+static int device_probe_prepare(struct udevice *dev)
 {
 	const struct driver *drv;
 	int size = 0;
 	int ret;
 	int seq;
 
-	if (!dev)
-		return -EINVAL;
-
-	if (dev->flags & DM_FLAG_ACTIVATED)
-		return 0;
-
 	drv = dev->driver;
 	assert(drv);
 
@@ -354,7 +416,7 @@ int device_probe(struct udevice *dev)
 		 * so that we don't mess up the device.
 		 */
 		if (dev->flags & DM_FLAG_ACTIVATED)
-			return 0;
+			return 1;
 	}
 
 	seq = uclass_resolve_seq(dev);
@@ -396,34 +458,93 @@ int device_probe(struct udevice *dev)
 	if (ret)
 		goto fail;
 
+	return 0;
+fail:
+	return device_probe_fail(dev, ret);
+}
+
+/**
+ * device_probe_finish() - Call the driver's probe method and finish probing
+ *
+ * @dev: Device to probe, which has been through device_probe_prepare()
+ * @return 0 if OK, -ve on error
+ */
+static int device_probe_finish(struct udevice *dev)
+{
+	const struct driver *drv = dev->driver;
+	int ret;
+
+	if (dev->flags & DM_FLAG_PROBE_PENDING) {
+		dev->flags &= ~DM_FLAG_PROBE_PENDING;
+		dev->flags |= DM_FLAG_ACTIVATED;
+	}
 	if (drv->probe) {
 		ret = drv->probe(dev);
-		if (ret) {
-			dev->flags &= ~DM_FLAG_ACTIVATED;
-			goto fail;
-		}
+		if (ret)
+			return device_probe_fail(dev, ret);
 	}
 
 	ret = uclass_post_probe_device(dev);
-	if (ret)
-		goto fail_uclass;
+	if (ret) {
+		if (device_remove(dev, DM_REMOVE_NORMAL)) {
+			dm_warn("%s: Device '%s' failed to remove on error path\n",
+				__func__, dev->name);
+		}
+		return device_probe_fail(dev, ret);
+	}
 
 	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
 		pinctrl_select_state(dev, "default");
 
 	return 0;
-fail_uclass:
-	if (device_remove(dev, DM_REMOVE_NORMAL)) {
-		dm_warn("%s: Device '%s' failed to remove on error path\n",
-			__func__, dev->name);
-	}
-fail:
-	dev->flags &= ~DM_FLAG_ACTIVATED;
+}
 
-	dev->seq = -1;
-	device_free(dev);
+int device_probe(struct udevice *dev)
+{
+	int ret;
 
-	return ret;
+	if (!dev)
+		return -EINVAL;
+
+	/* Complete a probe started by device_probe_start() */
+	if (dev->flags & DM_FLAG_PROBE_PENDING)
+		return device_probe_finish(dev);
+
+	if (dev->flags & DM_FLAG_ACTIVATED)
+		return 0;
+
+	ret = device_probe_prepare(dev);
+	if (ret)
+		return ret < 0 ? ret : 0;
+
+	return device_probe_finish(dev);
+}
+
+int device_probe_start(struct udevice *dev)
+{
+	const struct driver *drv;
+	int ret;
+
+	if (!dev)
+		return -EINVAL;
+
+	if (dev->flags & (DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING))
+		return 0;
+
+	ret = device_probe_prepare(dev);
+	if (ret)
+		return ret < 0 ? ret : 0;
+
+	drv = dev->driver;
+	if (!drv->probe_start)
+		return device_probe_finish(dev);
+	ret = drv->probe_start(dev);
+	if (ret)
+		return device_probe_fail(dev, ret);
+	dev->flags &= ~DM_FLAG_ACTIVATED;
+	dev->flags |= DM_FLAG_PROBE_PENDING;
+
+	return 0;
 }
 
 void *dev_get_platdata(struct udevice *dev)
@@ -9,6 +9,8 @@
 #include <dm/root.h>
 #include <dm/util.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static void show_devices(struct udevice *dev, int depth, int last_flag)
 {
 	int i, is_last;
@@ -51,6 +53,16 @@ void dm_dump_all(void)
 		printf("----------------------------------------\n");
 		show_devices(root, -1, 0);
 	}
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+	if (gd->dm_lazy_list) {
+		struct dm_lazy_node *lazy;
+
+		printf("\nDeferred nodes (bound on first use of their uclass):\n");
+		for (lazy = gd->dm_lazy_list; lazy; lazy = lazy->next)
+			printf(" %-22s under %s\n", ofnode_get_name(lazy->node),
+			       lazy->parent->name);
+	}
+#endif
 }
 
 /**
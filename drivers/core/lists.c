@@ -15,8 +15,11 @@
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <linux/compiler.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 struct driver *lists_driver_lookup_name(const char *name)
 {
 	struct driver *drv =
@@ -122,10 +125,134 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp)
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+/**
+ * struct compat_entry - An entry in the compatible-string index
+ *
+ * @hash:	Hash of the compatible string
+ * @drv:	Driver which has this compatible string
+ * @id:		Matching entry in the driver's of_match table
+ */
+struct compat_entry {
+	u32 hash;
+	struct driver *drv;
+	const struct udevice_id *id;
+};
+
+/* Index sorted by hash, then by position in the driver list */
+static struct compat_entry *compat_index;
+static int compat_count;
+static bool compat_index_built;
+
+static u32 compat_hash(const char *str)
+{
+	u32 hash = 2166136261U;
+
+	/* FNV-1a */
+	while (*str)
+		hash = (hash ^ (u8)*str++) * 16777619;
+
+	return hash;
+}
+
+static int compat_entry_cmp(const void *va, const void *vb)
+{
+	const struct compat_entry *a = va, *b = vb;
+
+	if (a->hash != b->hash)
+		return a->hash < b->hash ? -1 : 1;
+	if (a->drv != b->drv)
+		return a->drv < b->drv ? -1 : 1;
+
+	return a->id < b->id ? -1 : a->id > b->id;
+}
+
+static int lists_build_compat_index(void)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id;
+	struct compat_entry *ent;
+	struct driver *entry;
+	int count = 0;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++)
+			count++;
+	}
+	if (count) {
+		compat_index = malloc(count * sizeof(*compat_index));
+		if (!compat_index)
+			return -ENOMEM;
+	}
+
+	ent = compat_index;
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++, ent++) {
+			ent->hash = compat_hash(id->compatible);
+			ent->drv = entry;
+			ent->id = id;
+		}
+	}
+	qsort(compat_index, count, sizeof(*compat_index), compat_entry_cmp);
+	compat_count = count;
+	compat_index_built = true;
+
+	return 0;
+}
+
+static struct driver *lists_lookup_compat_index(const char *compat,
+						const struct udevice_id **idp)
+{
+	u32 hash = compat_hash(compat);
+	int low = 0, high = compat_count;
+	struct compat_entry *ent;
+
+	/* Find the first entry with this hash */
+	while (low < high) {
+		int mid = (low + high) / 2;
+
+		if (compat_index[mid].hash < hash)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	for (ent = compat_index + low;
+	     ent != compat_index + compat_count && ent->hash == hash; ent++) {
+		if (!strcmp(ent->id->compatible, compat)) {
+			*idp = ent->id;
+			return ent->drv;
+		}
+	}
+
+	return NULL;
+}
+#endif
+
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+	/* Before relocation there is neither BSS nor much malloc() space */
+	if (gd->flags & GD_FLG_FULL_MALLOC_INIT) {
+		if (compat_index_built || !lists_build_compat_index())
+			return lists_lookup_compat_index(compat, idp);
+	}
+#endif
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -162,13 +289,8 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp)
 		pr_debug("   - attempt to match compatible string '%s'\n",
 			 compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = lists_driver_lookup_compat(compat, &id);
+		if (!entry)
 			continue;
 
 		pr_debug("   - found match at '%s'\n", entry->name);
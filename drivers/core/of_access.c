@@ -20,11 +20,13 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 #include <linux/libfdt.h>
 #include <dm/of_access.h>
 #include <linux/ctype.h>
 #include <linux/err.h>
 #include <linux/ioport.h>
+#include <linux/log2.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -376,6 +378,45 @@ struct device_node *of_find_compatible_node(struct device_node *from,
 	return np;
 }
 
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+/* Nodes indexed by (phandle & phandle_cache_mask) */
+static struct device_node **phandle_cache;
+static const struct device_node *phandle_cache_root;
+static u32 phandle_cache_mask;
+
+int of_populate_phandle_cache(struct device_node *root)
+{
+	struct device_node *np, **entry;
+	u32 count = 0;
+
+	free(phandle_cache);
+	phandle_cache = NULL;
+	phandle_cache_root = root;
+	if (!root)
+		return 0;
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (np->phandle)
+			count++;
+	}
+	if (!count)
+		return 0;
+	count = roundup_pow_of_two(count);
+	phandle_cache = calloc(count, sizeof(*phandle_cache));
+	if (!phandle_cache)
+		return -ENOMEM;
+	phandle_cache_mask = count - 1;
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		entry = &phandle_cache[np->phandle & phandle_cache_mask];
+		if (np->phandle && !*entry)
+			*entry = np;
+	}
+
+	return 0;
+}
+#endif
+
 struct device_node *of_find_node_by_phandle(phandle handle)
 {
 	struct device_node *np;
@@ -383,6 +424,15 @@ struct device_node *of_find_node_by_phandle(phandle handle)
 	if (!handle)
 		return NULL;
 
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+	if (phandle_cache_root != gd->of_root)
+		of_populate_phandle_cache(gd->of_root);
+	if (phandle_cache) {
+		np = phandle_cache[handle & phandle_cache_mask];
+		if (np && np->phandle == handle)
+			return np;
+	}
+#endif
 	for_each_of_allnodes(np)
 		if (np->phandle == handle)
 			break;
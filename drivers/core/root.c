@@ -158,6 +158,27 @@ int dm_init(bool of_live)
 		return -EINVAL;
 	}
 	INIT_LIST_HEAD(&DM_UCLASS_ROOT_NON_CONST);
+	/* Drop any deferred nodes left over from a previous tree */
+	while (gd->dm_lazy_list) {
+		struct dm_lazy_node *lazy = gd->dm_lazy_list;
+
+		gd->dm_lazy_list = lazy->next;
+		free(lazy);
+	}
+#if CONFIG_IS_ENABLED(DM_UCLASS_TABLE)
+	/*
+	 * Before relocation the table would use up scarce malloc() space
+	 * and there are only a few uclasses, so stick with the list.
+	 */
+	if (gd->flags & GD_FLG_FULL_MALLOC_INIT) {
+		if (!gd->uclass_table)
+			gd->uclass_table = calloc(UCLASS_COUNT,
+						  sizeof(struct uclass *));
+		else
+			memset(gd->uclass_table, '\0',
+			       UCLASS_COUNT * sizeof(struct uclass *));
+	}
+#endif
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
 	fix_drivers();
@@ -200,6 +221,45 @@ int dm_remove_devices_flags(uint flags)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+static int dm_probe_walk(struct udevice *parent, bool start)
+{
+	struct udevice *dev;
+	int ret, err = 0;
+
+	list_for_each_entry(dev, &parent->child_head, sibling_node) {
+		if (start && dev->driver->probe_start &&
+		    !(dev->flags & (DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING)))
+			ret = device_probe_start(dev);
+		else if (!start && (dev->flags & DM_FLAG_PROBE_PENDING))
+			ret = device_probe(dev);
+		else
+			ret = 0;
+		if (ret) {
+			dm_warn("%s: Device '%s' failed to probe (err=%d)\n",
+				__func__, dev->name, ret);
+			if (!err)
+				err = ret;
+		}
+		ret = dm_probe_walk(dev, start);
+		if (ret && !err)
+			err = ret;
+	}
+
+	return err;
+}
+
+int dm_probe_start_all(void)
+{
+	return dm_probe_walk(dm_root(), true);
+}
+
+int dm_probe_complete_all(void)
+{
+	return dm_probe_walk(dm_root(), false);
+}
+#endif
+
 int dm_scan_platdata(bool pre_reloc_only)
 {
 	int ret;
@@ -213,6 +273,134 @@ int dm_scan_platdata(bool pre_reloc_only)
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+/* Mark the uclasses that binding @node and its subnodes would use */
+static void dm_lazy_mark_uclasses(ofnode node, ulong *uclasses)
+{
+	const char *compat_list, *compat;
+	const struct udevice_id *of_id;
+	struct driver *drv;
+	ofnode subnode;
+	int len, i;
+
+	compat_list = ofnode_get_property(node, "compatible", &len);
+	for (i = 0; compat_list && i < len; i += strlen(compat) + 1) {
+		compat = compat_list + i;
+		drv = lists_driver_lookup_compat(compat, &of_id);
+		if (drv) {
+			uclasses[drv->id / BITS_PER_LONG] |=
+				1UL << (drv->id % BITS_PER_LONG);
+			break;
+		}
+	}
+	ofnode_for_each_subnode(subnode, node)
+		dm_lazy_mark_uclasses(subnode, uclasses);
+}
+
+static int dm_lazy_add(struct udevice *parent, ofnode node)
+{
+	struct dm_lazy_node *lazy, **tailp;
+
+	lazy = calloc(1, sizeof(*lazy));
+	if (!lazy)
+		return -ENOMEM;
+	lazy->parent = parent;
+	lazy->node = node;
+	dm_lazy_mark_uclasses(node, lazy->uclasses);
+
+	/* Keep the list in tree order so devices bind in the usual order */
+	for (tailp = &gd->dm_lazy_list; *tailp; tailp = &(*tailp)->next)
+		;
+	*tailp = lazy;
+
+	return 0;
+}
+
+static int dm_lazy_bind(enum uclass_id id, bool all)
+{
+	struct dm_lazy_node **prevp = &gd->dm_lazy_list;
+	struct dm_lazy_node *lazy;
+	int ret = 0, err;
+
+	while ((lazy = *prevp)) {
+		if (!all && !(lazy->uclasses[id / BITS_PER_LONG] &
+			      1UL << (id % BITS_PER_LONG))) {
+			prevp = &lazy->next;
+			continue;
+		}
+		*prevp = lazy->next;
+		pr_debug("binding deferred node %s\n",
+			 ofnode_get_name(lazy->node));
+		err = lists_bind_fdt(lazy->parent, lazy->node, NULL);
+		free(lazy);
+		if (err && !ret)
+			ret = err;
+
+		/* Binding may have added or removed entries, so start again */
+		prevp = &gd->dm_lazy_list;
+	}
+
+	return ret;
+}
+
+int dm_lazy_bind_uclass(enum uclass_id id)
+{
+	if ((uint)id >= UCLASS_COUNT)
+		return 0;
+
+	return dm_lazy_bind(id, false);
+}
+
+int dm_lazy_bind_all(void)
+{
+	return dm_lazy_bind(UCLASS_ROOT, true);
+}
+
+void dm_lazy_forget(struct udevice *parent)
+{
+	struct dm_lazy_node **prevp = &gd->dm_lazy_list;
+	struct dm_lazy_node *lazy;
+
+	while ((lazy = *prevp)) {
+		if (lazy->parent == parent) {
+			*prevp = lazy->next;
+			free(lazy);
+		} else {
+			prevp = &lazy->next;
+		}
+	}
+}
+#else
+static inline int dm_lazy_add(struct udevice *parent, ofnode node)
+{
+	return -ENOSYS;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(OF_CONTROL) && !CONFIG_IS_ENABLED(OF_PLATDATA)
+/**
+ * dm_bind_node() - Bind a device tree node, or defer it if requested
+ *
+ * Nodes which dtoc has converted to platform data are skipped, since they
+ * are bound by dm_scan_platdata().
+ *
+ * @parent: Parent device for the device that will be created
+ * @node: Node to bind
+ * @return 0 if OK, -ve on error
+ */
+static int dm_bind_node(struct udevice *parent, ofnode node)
+{
+	if (CONFIG_IS_ENABLED(OF_PLATDATA_NODES) &&
+	    ofnode_read_bool(node, "u-boot,dm-platdata"))
+		return 0;
+	if (CONFIG_IS_ENABLED(DM_LAZY_BIND) &&
+	    ofnode_read_bool(node, "u-boot,dm-lazy"))
+		return dm_lazy_add(parent, node);
+
+	return lists_bind_fdt(parent, node, NULL);
+}
+#endif
+
 #if CONFIG_IS_ENABLED(OF_LIVE)
 static int dm_scan_fdt_live(struct udevice *parent,
 			    const struct device_node *node_parent,
@@ -229,7 +417,7 @@ static int dm_scan_fdt_live(struct udevice *parent,
 			pr_debug("   - ignoring disabled device\n");
 			continue;
 		}
-		err = lists_bind_fdt(parent, np_to_ofnode(np), NULL);
+		err = dm_bind_node(parent, np_to_ofnode(np));
 		if (err && !ret) {
 			ret = err;
 			debug("%s: ret=%d\n", np->name, ret);
@@ -283,7 +471,7 @@ static int dm_scan_fdt_node(struct udevice *parent, const void *blob,
 			pr_debug("   - ignoring disabled device\n");
 			continue;
 		}
-		err = lists_bind_fdt(parent, offset_to_ofnode(offset), NULL);
+		err = dm_bind_node(parent, offset_to_ofnode(offset));
 		if (err && !ret) {
 			ret = err;
 			debug("%s: ret=%d\n", fdt_get_name(blob, offset, NULL),
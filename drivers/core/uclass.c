@@ -13,6 +13,7 @@
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <dm/root.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -25,11 +26,10 @@ struct uclass *uclass_find(enum uclass_id key)
 
 	if (!gd->dm_root)
 		return NULL;
-	/*
-	 * TODO(sjg@chromium.org): Optimise this, perhaps moving the found
-	 * node to the start of the list, or creating a linear array mapping
-	 * id to node.
-	 */
+#if CONFIG_IS_ENABLED(DM_UCLASS_TABLE)
+	if (gd->uclass_table)
+		return (uint)key < UCLASS_COUNT ? gd->uclass_table[key] : NULL;
+#endif
 	list_for_each_entry(uc, &gd->uclass_root, sibling_node) {
 		if (uc->uc_drv->id == key)
 			return uc;
@@ -79,6 +79,10 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 	INIT_LIST_HEAD(&uc->sibling_node);
 	INIT_LIST_HEAD(&uc->dev_head);
 	list_add(&uc->sibling_node, &DM_UCLASS_ROOT_NON_CONST);
+#if CONFIG_IS_ENABLED(DM_UCLASS_TABLE)
+	if (gd->uclass_table)
+		gd->uclass_table[id] = uc;
+#endif
 
 	if (uc_drv->init) {
 		ret = uc_drv->init(uc);
@@ -95,6 +99,10 @@ fail:
 		uc->priv = NULL;
 	}
 	list_del(&uc->sibling_node);
+#if CONFIG_IS_ENABLED(DM_UCLASS_TABLE)
+	if (gd->uclass_table)
+		gd->uclass_table[id] = NULL;
+#endif
 fail_mem:
 	free(uc);
 
@@ -128,6 +136,10 @@ int uclass_destroy(struct uclass *uc)
 	if (uc_drv->destroy)
 		uc_drv->destroy(uc);
 	list_del(&uc->sibling_node);
+#if CONFIG_IS_ENABLED(DM_UCLASS_TABLE)
+	if (gd->uclass_table)
+		gd->uclass_table[uc_drv->id] = NULL;
+#endif
 	if (uc_drv->priv_auto_alloc_size)
 		free(uc->priv);
 	free(uc);
@@ -135,7 +147,7 @@ int uclass_destroy(struct uclass *uc)
 	return 0;
 }
 
-int uclass_get(enum uclass_id id, struct uclass **ucp)
+int uclass_find_or_add(enum uclass_id id, struct uclass **ucp)
 {
 	struct uclass *uc;
 
@@ -148,6 +160,19 @@ int uclass_get(enum uclass_id id, struct uclass **ucp)
 	return 0;
 }
 
+int uclass_get(enum uclass_id id, struct uclass **ucp)
+{
+	int ret;
+
+	if (CONFIG_IS_ENABLED(DM_LAZY_BIND) && gd->dm_lazy_list) {
+		ret = dm_lazy_bind_uclass(id);
+		if (ret)
+			return ret;
+	}
+
+	return uclass_find_or_add(id, ucp);
+}
+
 const char *uclass_get_name(enum uclass_id id)
 {
 	struct uclass *uc;
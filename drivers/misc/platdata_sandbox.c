@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Sandbox device for testing of-platdata in U-Boot proper
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <dt-structs.h>
+
+/*
+ * The node is selected with 'u-boot,dm-platdata', so this is bound from
+ * the platform data generated by dtoc. The of_match is only there so that
+ * the test can tell if the node is also bound from the device tree, which
+ * it should not be.
+ */
+static const struct udevice_id sandbox_platdata_test_ids[] = {
+	{ .compatible = "sandbox,platdata-test" },
+	{ }
+};
+
+U_BOOT_DRIVER(sandbox_platdata_test) = {
+	.name	= "sandbox_platdata_test",
+	.id	= UCLASS_MISC,
+	.of_match = sandbox_platdata_test_ids,
+	.platdata_auto_alloc_size = sizeof(struct dtd_sandbox_platdata_test),
+};
@@ -111,6 +111,11 @@ struct pcie_dw_mvebu {
 	fdt_size_t cfg_size;
 	int first_busno;
 
+	/* Set by probe_start(), add-in card reset is released at reset_start */
+	bool started;
+	bool in_reset;
+	ulong reset_start;
+
 	/* IO and MEM PCI regions */
 	struct pci_region io;
 	struct pci_region mem;
@@ -462,20 +467,20 @@ static void pcie_dw_set_host_bars(const void *regs_base)
 }
 
 /**
- * pcie_dw_mvebu_probe() - Probe the PCIe bus for active link
+ * pcie_dw_mvebu_probe_start() - Release the add-in card from reset
  *
  * @dev: A pointer to the device being operated on
  *
- * Probe for an active link on the PCIe bus and configure the controller
- * to enable this port.
+ * The card needs 200ms to come out of reset before the link can be
+ * trained. Release the reset here and let pcie_dw_mvebu_probe() wait for
+ * whatever is left of that time, so that the delay overlaps the rest of
+ * the boot when probing is split (CONFIG_DM_ASYNC_PROBE).
  *
- * Return: 0 on success, else -ENODEV
+ * Return: 0 (always)
  */
-static int pcie_dw_mvebu_probe(struct udevice *dev)
+static int pcie_dw_mvebu_probe_start(struct udevice *dev)
 {
 	struct pcie_dw_mvebu *pcie = dev_get_priv(dev);
-	struct udevice *ctlr = pci_get_controller(dev);
-	struct pci_controller *hose = dev_get_uclass_priv(ctlr);
 #ifdef CONFIG_DM_GPIO
 	struct gpio_desc reset_gpio;
 
@@ -490,11 +495,39 @@ static int pcie_dw_mvebu_probe(struct udevice *dev)
 	 */
 	if (dm_gpio_is_valid(&reset_gpio)) {
 		dm_gpio_set_value(&reset_gpio, 1);
-		mdelay(200);
+		pcie->reset_start = get_timer(0);
+		pcie->in_reset = true;
 	}
 #else
 	debug("PCIE Reset on GPIO support is missing\n");
 #endif /* CONFIG_DM_GPIO */
+	pcie->started = true;
+
+	return 0;
+}
+
+/**
+ * pcie_dw_mvebu_probe() - Probe the PCIe bus for active link
+ *
+ * @dev: A pointer to the device being operated on
+ *
+ * Probe for an active link on the PCIe bus and configure the controller
+ * to enable this port.
+ *
+ * Return: 0 on success, else -ENODEV
+ */
+static int pcie_dw_mvebu_probe(struct udevice *dev)
+{
+	struct pcie_dw_mvebu *pcie = dev_get_priv(dev);
+	struct udevice *ctlr = pci_get_controller(dev);
+	struct pci_controller *hose = dev_get_uclass_priv(ctlr);
+
+	if (!pcie->started)
+		pcie_dw_mvebu_probe_start(dev);
+	if (pcie->in_reset) {
+		while (get_timer(pcie->reset_start) < 200)
+			;
+	}
 
 	pcie->first_busno = dev->seq;
 
@@ -576,5 +609,6 @@ U_BOOT_DRIVER(pcie_dw_mvebu) = {
 	.ops			= &pcie_dw_mvebu_ops,
 	.ofdata_to_platdata	= pcie_dw_mvebu_ofdata_to_platdata,
 	.probe			= pcie_dw_mvebu_probe,
+	.probe_start		= pcie_dw_mvebu_probe_start,
 	.priv_auto_alloc_size	= sizeof(struct pcie_dw_mvebu),
 };
@@ -77,6 +77,40 @@ int submit_bulk_msg(struct usb_device *udev, unsigned long pipe, void *buffer,
 	return ops->bulk(bus, udev, pipe, buffer, length);
 }
 
+int queue_bulk_msg(struct usb_device *udev, unsigned long pipe, void *buffer,
+		   int length)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->queue_bulk || !ops->complete_bulk || !ops->cancel_bulk)
+		return -ENOSYS;
+
+	return ops->queue_bulk(bus, udev, pipe, buffer, length);
+}
+
+int complete_bulk_msg(struct usb_device *udev, unsigned long pipe)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->complete_bulk)
+		return -ENOSYS;
+
+	return ops->complete_bulk(bus, udev, pipe);
+}
+
+int cancel_bulk_msg(struct usb_device *udev, unsigned long pipe)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->cancel_bulk)
+		return -ENOSYS;
+
+	return ops->cancel_bulk(bus, udev, pipe);
+}
+
 struct int_queue *create_int_queue(struct usb_device *udev,
 		unsigned long pipe, int queuesize, int elementsize,
 		void *buffer, int interval)
@@ -481,18 +481,17 @@ union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected)
  * (Careful: This will BUG() when there was no transfer in progress. Shouldn't
  * happen in practice for current uses and is too complicated to fix right now.)
  */
-static void abort_td(struct usb_device *udev, int ep_index)
+static void abort_td(struct xhci_ctrl *ctrl, int slot_id, int ep_index)
 {
-	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
-	struct xhci_ring *ring =  ctrl->devs[udev->slot_id]->eps[ep_index].ring;
+	struct xhci_ring *ring =  ctrl->devs[slot_id]->eps[ep_index].ring;
 	union xhci_trb *event;
 	u32 field;
 
-	xhci_queue_command(ctrl, NULL, udev->slot_id, ep_index, TRB_STOP_RING);
+	xhci_queue_command(ctrl, NULL, slot_id, ep_index, TRB_STOP_RING);
 
 	event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
 	field = le32_to_cpu(event->trans_event.flags);
-	BUG_ON(TRB_TO_SLOT_ID(field) != udev->slot_id);
+	BUG_ON(TRB_TO_SLOT_ID(field) != slot_id);
 	BUG_ON(TRB_TO_EP_INDEX(field) != ep_index);
 	BUG_ON(GET_COMP_CODE(le32_to_cpu(event->trans_event.transfer_len
 		!= COMP_STOP)));
@@ -500,59 +499,197 @@ static void abort_td(struct usb_device *udev, int ep_index)
 
 	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
 	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
-		!= udev->slot_id || GET_COMP_CODE(le32_to_cpu(
+		!= slot_id || GET_COMP_CODE(le32_to_cpu(
 		event->event_cmd.status)) != COMP_SUCCESS);
 	xhci_acknowledge_event(ctrl);
 
 	xhci_queue_command(ctrl, (void *)((uintptr_t)ring->enqueue |
-		ring->cycle_state), udev->slot_id, ep_index, TRB_SET_DEQ);
+		ring->cycle_state), slot_id, ep_index, TRB_SET_DEQ);
 	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
 	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
-		!= udev->slot_id || GET_COMP_CODE(le32_to_cpu(
+		!= slot_id || GET_COMP_CODE(le32_to_cpu(
 		event->event_cmd.status)) != COMP_SUCCESS);
 	xhci_acknowledge_event(ctrl);
 }
 
-static void record_transfer_result(struct usb_device *udev,
-				   union xhci_trb *event, int length)
+static void record_transfer_result(union xhci_trb *event, int length,
+				   unsigned long *status, int *act_len)
 {
-	udev->act_len = min(length, length -
+	*act_len = min(length, length -
 		(int)EVENT_TRB_LEN(le32_to_cpu(event->trans_event.transfer_len)));
 
 	switch (GET_COMP_CODE(le32_to_cpu(event->trans_event.transfer_len))) {
 	case COMP_SUCCESS:
-		BUG_ON(udev->act_len != length);
+		BUG_ON(*act_len != length);
 		/* fallthrough */
 	case COMP_SHORT_TX:
-		udev->status = 0;
+		*status = 0;
 		break;
 	case COMP_STALL:
-		udev->status = USB_ST_STALLED;
+		*status = USB_ST_STALLED;
 		break;
 	case COMP_DB_ERR:
 	case COMP_TRB_ERR:
-		udev->status = USB_ST_BUF_ERR;
+		*status = USB_ST_BUF_ERR;
 		break;
 	case COMP_BABBLE:
-		udev->status = USB_ST_BABBLE_DET;
+		*status = USB_ST_BABBLE_DET;
 		break;
 	default:
-		udev->status = 0x80;  /* USB_ST_TOO_LAZY_TO_MAKE_A_NEW_MACRO */
+		*status = 0x80;  /* USB_ST_TOO_LAZY_TO_MAKE_A_NEW_MACRO */
+	}
+}
+
+/**
+ * Records a transfer event against the bulk TD it completes. TDs on an
+ * endpoint complete in order, so this is the oldest TD not yet done.
+ *
+ * @param ctrl	Host controller data structure
+ * @param event	transfer event TRB
+ * @return 0 if OK, -ENOENT if the event does not belong to a queued TD
+ */
+static int record_bulk_td_result(struct xhci_ctrl *ctrl,
+				 union xhci_trb *event)
+{
+	u32 field = le32_to_cpu(event->trans_event.flags);
+	struct xhci_virt_device *virt_dev = ctrl->devs[TRB_TO_SLOT_ID(field)];
+	struct xhci_virt_ep *ep;
+	struct xhci_bulk_td *td = NULL;
+	int i;
+
+	if (!virt_dev)
+		return -ENOENT;
+	ep = &virt_dev->eps[TRB_TO_EP_INDEX(field)];
+	for (i = 0; i < ep->td_count; i++) {
+		td = &ep->tds[(ep->td_head + i) % XHCI_MAX_BULK_TDS];
+		if (!td->done)
+			break;
+	}
+	if (i == ep->td_count ||
+	    *(void **)(uintptr_t)le64_to_cpu(event->trans_event.buffer) -
+	    td->buffer > (size_t)td->length)
+		return -ENOENT;
+
+	record_transfer_result(event, td->length, &td->status, &td->act_len);
+	td->done = true;
+	ctrl->bulk_tds_pending--;
+
+	return 0;
+}
+
+/**
+ * Stops an endpoint and cancels the bulk TDs queued on it which have not
+ * completed yet. They remain queued, with a timeout status, until collected
+ * by xhci_bulk_complete() or dropped by xhci_bulk_cancel().
+ *
+ * @param ctrl		Host controller data structure
+ * @param slot_id	slot of the device
+ * @param ep_index	index of the endpoint
+ * @return none
+ */
+static void cancel_bulk_tds(struct xhci_ctrl *ctrl, int slot_id,
+			    int ep_index)
+{
+	struct xhci_virt_ep *ep = &ctrl->devs[slot_id]->eps[ep_index];
+	struct xhci_bulk_td *td;
+	bool aborted = false;
+	int i;
+
+	for (i = 0; i < ep->td_count; i++) {
+		td = &ep->tds[(ep->td_head + i) % XHCI_MAX_BULK_TDS];
+		if (td->done)
+			continue;
+		if (!aborted) {
+			abort_td(ctrl, slot_id, ep_index);
+			aborted = true;
+		}
+		/* closest thing to a timeout */
+		td->status = USB_ST_NAK_REC;
+		td->act_len = 0;
+		td->done = true;
+		ctrl->bulk_tds_pending--;
+	}
+}
+
+/**
+ * Waits until no bulk TD is in progress on the controller, so that a
+ * control transfer (for example to clear a halt) is not interleaved with
+ * their events. TDs which do not complete in time are cancelled. The
+ * results stay with the TDs until xhci_bulk_complete() collects them.
+ *
+ * @param ctrl	Host controller data structure
+ * @return none
+ */
+static void drain_bulk_tds(struct xhci_ctrl *ctrl)
+{
+	union xhci_trb *event;
+	int slot_id, ep_index;
+
+	while (ctrl->bulk_tds_pending) {
+		event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
+		if (!event)
+			break;
+		if (record_bulk_td_result(ctrl, event))
+			printf("Unexpected XHCI transfer event, skipping...\n");
+		xhci_acknowledge_event(ctrl);
+	}
+	if (!ctrl->bulk_tds_pending)
+		return;
+
+	debug("XHCI bulk transfer timed out, aborting...\n");
+	for (slot_id = 0; slot_id < MAX_HC_SLOTS; slot_id++) {
+		if (!ctrl->devs[slot_id])
+			continue;
+		for (ep_index = 0; ep_index < MAX_EP_CTX_NUM; ep_index++)
+			cancel_bulk_tds(ctrl, slot_id, ep_index);
+	}
+}
+
+/**
+ * Waits for a transfer event for an endpoint. Events completing bulk TDs on
+ * other endpoints are recorded against those TDs and any others skipped.
+ *
+ * @param ctrl		Host controller data structure
+ * @param slot_id	slot of the device
+ * @param ep_index	index of the endpoint
+ * @return pointer to the event, or NULL on timeout
+ */
+static union xhci_trb *wait_for_ep_event(struct xhci_ctrl *ctrl, int slot_id,
+					 int ep_index)
+{
+	union xhci_trb *event;
+	u32 field;
+
+	for (;;) {
+		event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
+		if (!event)
+			return NULL;
+		field = le32_to_cpu(event->trans_event.flags);
+		if (TRB_TO_SLOT_ID(field) == slot_id &&
+		    TRB_TO_EP_INDEX(field) == ep_index)
+			return event;
+		if (record_bulk_td_result(ctrl, event))
+			printf("Unexpected XHCI transfer event, skipping...\n");
+		xhci_acknowledge_event(ctrl);
 	}
 }
 
 /**** Bulk and Control transfer methods ****/
 /**
- * Queues up the BULK Request
+ * Queues up the BULK Request and starts it, without waiting for it to
+ * complete. Several requests may be queued on an endpoint at once; they
+ * are completed in order by xhci_bulk_complete(). The buffer must not be
+ * touched until then.
  *
  * @param udev		pointer to the USB device structure
  * @param pipe		contains the DIR_IN or OUT , devnum
  * @param length	length of the buffer
  * @param buffer	buffer to be read/written based on the request
- * @return returns 0 if successful else -1 on failure
+ * @return returns 0 if successful, -EBUSY if the endpoint cannot take
+ *	   another request yet, or other -ve error code on failure
  */
-int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
-			int length, void *buffer)
+int xhci_bulk_queue(struct usb_device *udev, unsigned long pipe,
+		    int length, void *buffer)
 {
 	int num_trbs = 0;
 	struct xhci_generic_trb *start_trb;
@@ -564,9 +701,10 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	int slot_id = udev->slot_id;
 	int ep_index;
 	struct xhci_virt_device *virt_dev;
+	struct xhci_virt_ep *ep;
+	struct xhci_bulk_td *td;
 	struct xhci_ep_ctx *ep_ctx;
 	struct xhci_ring *ring;		/* EP transfer ring */
-	union xhci_trb *event;
 
 	int running_total, trb_buff_len;
 	unsigned int total_packet_count;
@@ -581,13 +719,14 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 
 	ep_index = usb_pipe_ep_index(pipe);
 	virt_dev = ctrl->devs[slot_id];
+	ep = &virt_dev->eps[ep_index];
 
 	xhci_inval_cache((uintptr_t)virt_dev->out_ctx->bytes,
 			 virt_dev->out_ctx->size);
 
 	ep_ctx = xhci_get_ep_ctx(ctrl, virt_dev->out_ctx, ep_index);
 
-	ring = virt_dev->eps[ep_index].ring;
+	ring = ep->ring;
 	/*
 	 * How much data is (potentially) left before the 64KB boundary?
 	 * XHCI Spec puts restriction( TABLE 49 and 6.4.1 section of XHCI Spec)
@@ -612,6 +751,16 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		running_total += TRB_MAX_BUFF_SIZE;
 	}
 
+	/*
+	 * Make sure the TD fits on the ring behind those already queued. Each
+	 * segment loses one TRB to its link TRB, and the ring must never be
+	 * completely full.
+	 */
+	if (ep->td_count == XHCI_MAX_BULK_TDS ||
+	    ep->td_trbs + num_trbs >
+	    XFER_RING_NUM_SEGS * (TRBS_PER_SEGMENT - 1) - 1)
+		return -EBUSY;
+
 	/*
 	 * XXX: Calling routine prepare_ring() called in place of
 	 * prepare_trasfer() as there in 'Linux' since we are not
@@ -622,6 +771,15 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	if (ret < 0)
 		return ret;
 
+	td = &ep->tds[(ep->td_head + ep->td_count) % XHCI_MAX_BULK_TDS];
+	td->buffer = buffer;
+	td->length = length;
+	td->num_trbs = num_trbs;
+	td->done = false;
+	ep->td_count++;
+	ep->td_trbs += num_trbs;
+	ctrl->bulk_tds_pending++;
+
 	/*
 	 * Don't give the first TRB to the hardware (by toggling the cycle bit)
 	 * until we've finished creating all the other TRBs.  The ring's cycle
@@ -711,28 +869,101 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 
 	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
 
-	event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
-	if (!event) {
-		debug("XHCI bulk transfer timed out, aborting...\n");
-		abort_td(udev, ep_index);
-		udev->status = USB_ST_NAK_REC;  /* closest thing to a timeout */
-		udev->act_len = 0;
-		return -ETIMEDOUT;
+	return 0;
+}
+
+/**
+ * Waits for the oldest BULK Request queued on an endpoint to complete.
+ * Completion events for requests on other endpoints which arrive in the
+ * meantime are recorded against those requests.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @return returns 0 if successful else -ve on failure. The result of the
+ *	   transfer is in udev->status and udev->act_len
+ */
+int xhci_bulk_complete(struct usb_device *udev, unsigned long pipe)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	int ep_index = usb_pipe_ep_index(pipe);
+	struct xhci_virt_ep *ep = &ctrl->devs[udev->slot_id]->eps[ep_index];
+	struct xhci_bulk_td *td;
+	union xhci_trb *event;
+	bool timed_out = false;
+
+	if (!ep->td_count)
+		return -EINVAL;
+
+	td = &ep->tds[ep->td_head];
+	while (!td->done) {
+		event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
+		if (!event) {
+			debug("XHCI bulk transfer timed out, aborting...\n");
+			cancel_bulk_tds(ctrl, udev->slot_id, ep_index);
+			timed_out = true;
+			break;
+		}
+		if (record_bulk_td_result(ctrl, event))
+			printf("Unexpected XHCI transfer event, skipping...\n");
+		xhci_acknowledge_event(ctrl);
 	}
-	field = le32_to_cpu(event->trans_event.flags);
 
-	BUG_ON(TRB_TO_SLOT_ID(field) != slot_id);
-	BUG_ON(TRB_TO_EP_INDEX(field) != ep_index);
-	BUG_ON(*(void **)(uintptr_t)le64_to_cpu(event->trans_event.buffer) -
-		buffer > (size_t)length);
+	ep->td_head = (ep->td_head + 1) % XHCI_MAX_BULK_TDS;
+	ep->td_count--;
+	ep->td_trbs -= td->num_trbs;
 
-	record_transfer_result(udev, event, length);
-	xhci_acknowledge_event(ctrl);
-	xhci_inval_cache((uintptr_t)buffer, length);
+	udev->status = td->status;
+	udev->act_len = td->act_len;
+	if (timed_out)
+		return -ETIMEDOUT;
+	xhci_inval_cache((uintptr_t)td->buffer, td->length);
 
 	return (udev->status != USB_ST_NOT_PROC) ? 0 : -1;
 }
 
+/**
+ * Cancels all BULK Requests queued on an endpoint, without waiting for
+ * them to complete. Their buffers may be reused afterwards.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @return returns 0
+ */
+int xhci_bulk_cancel(struct usb_device *udev, unsigned long pipe)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	int ep_index = usb_pipe_ep_index(pipe);
+	struct xhci_virt_ep *ep = &ctrl->devs[udev->slot_id]->eps[ep_index];
+
+	cancel_bulk_tds(ctrl, udev->slot_id, ep_index);
+	ep->td_head = 0;
+	ep->td_count = 0;
+	ep->td_trbs = 0;
+
+	return 0;
+}
+
+/**
+ * Queues up the BULK Request and waits for it to complete
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param length	length of the buffer
+ * @param buffer	buffer to be read/written based on the request
+ * @return returns 0 if successful else -1 on failure
+ */
+int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
+			int length, void *buffer)
+{
+	int ret;
+
+	ret = xhci_bulk_queue(udev, pipe, length, buffer);
+	if (ret)
+		return ret;
+
+	return xhci_bulk_complete(udev, pipe);
+}
+
 /**
  * Queues up the Control Transfer Request
  *
@@ -772,6 +1003,9 @@ int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
 
 	ep_ring = virt_dev->eps[ep_index].ring;
 
+	/* Let queued bulk transfers finish before e.g. clearing a halt */
+	drain_bulk_tds(ctrl);
+
 	/*
 	 * Check to see if the max packet size for the default control
 	 * endpoint changed during FS device enumeration
@@ -908,15 +1142,11 @@ int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
 
 	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
 
-	event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
+	event = wait_for_ep_event(ctrl, slot_id, ep_index);
 	if (!event)
 		goto abort;
-	field = le32_to_cpu(event->trans_event.flags);
 
-	BUG_ON(TRB_TO_SLOT_ID(field) != slot_id);
-	BUG_ON(TRB_TO_EP_INDEX(field) != ep_index);
-
-	record_transfer_result(udev, event, length);
+	record_transfer_result(event, length, &udev->status, &udev->act_len);
 	xhci_acknowledge_event(ctrl);
 
 	/* Invalidate buffer to make it available to usb-core */
@@ -926,11 +1156,9 @@ int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
 	if (GET_COMP_CODE(le32_to_cpu(event->trans_event.transfer_len))
 			== COMP_SHORT_TX) {
 		/* Short data stage, clear up additional status stage event */
-		event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
+		event = wait_for_ep_event(ctrl, slot_id, ep_index);
 		if (!event)
 			goto abort;
-		BUG_ON(TRB_TO_SLOT_ID(field) != slot_id);
-		BUG_ON(TRB_TO_EP_INDEX(field) != ep_index);
 		xhci_acknowledge_event(ctrl);
 	}
 
@@ -938,7 +1166,7 @@ int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
 
 abort:
 	debug("XHCI control transfer timed out, aborting...\n");
-	abort_td(udev, ep_index);
+	abort_td(ctrl, slot_id, ep_index);
 	udev->status = USB_ST_NAK_REC;
 	udev->act_len = 0;
 	return -ETIMEDOUT;
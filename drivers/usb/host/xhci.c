@@ -570,7 +570,8 @@ static int xhci_set_configuration(struct usb_device *udev)
 		ep_ctx[ep_index] = xhci_get_ep_ctx(ctrl, in_ctx, ep_index);
 
 		/* Allocate the ep rings */
-		virt_dev->eps[ep_index].ring = xhci_ring_alloc(1, true);
+		virt_dev->eps[ep_index].ring =
+			xhci_ring_alloc(XFER_RING_NUM_SEGS, true);
 		if (!virt_dev->eps[ep_index].ring)
 			return -ENOMEM;
 
@@ -1384,6 +1385,32 @@ static int xhci_submit_bulk_msg(struct udevice *dev, struct usb_device *udev,
 	return _xhci_submit_bulk_msg(udev, pipe, buffer, length);
 }
 
+static int xhci_queue_bulk_msg(struct udevice *dev, struct usb_device *udev,
+			       unsigned long pipe, void *buffer, int length)
+{
+	debug("%s: dev='%s', udev=%p\n", __func__, dev->name, udev);
+	if (usb_pipetype(pipe) != PIPE_BULK) {
+		printf("non-bulk pipe (type=%lu)", usb_pipetype(pipe));
+		return -EINVAL;
+	}
+
+	return xhci_bulk_queue(udev, pipe, length, buffer);
+}
+
+static int xhci_complete_bulk_msg(struct udevice *dev, struct usb_device *udev,
+				  unsigned long pipe)
+{
+	debug("%s: dev='%s', udev=%p\n", __func__, dev->name, udev);
+	return xhci_bulk_complete(udev, pipe);
+}
+
+static int xhci_cancel_bulk_msg(struct udevice *dev, struct usb_device *udev,
+				unsigned long pipe)
+{
+	debug("%s: dev='%s', udev=%p\n", __func__, dev->name, udev);
+	return xhci_bulk_cancel(udev, pipe);
+}
+
 static int xhci_submit_int_msg(struct udevice *dev, struct usb_device *udev,
 			       unsigned long pipe, void *buffer, int length,
 			       int interval)
@@ -1459,13 +1486,15 @@ static int xhci_update_hub_device(struct udevice *dev, struct usb_device *udev)
 static int xhci_get_max_xfer_size(struct udevice *dev, size_t *size)
 {
 	/*
-	 * xHCD allocates one segment which includes 64 TRBs for each endpoint
-	 * and the last TRB in this segment is configured as a link TRB to form
-	 * a TRB ring. Each TRB can transfer up to 64K bytes, however data
-	 * buffers referenced by transfer TRBs shall not span 64KB boundaries.
-	 * Hence the maximum number of TRBs we can use in one transfer is 62.
+	 * xHCD allocates XFER_RING_NUM_SEGS segments of 64 TRBs for each
+	 * endpoint and the last TRB in each segment is configured as a link
+	 * TRB to form a TRB ring. Each TRB can transfer up to 64K bytes,
+	 * however data buffers referenced by transfer TRBs shall not span 64KB
+	 * boundaries, so an unaligned buffer needs one extra TRB. Hence the
+	 * maximum number of TRBs we can use in one transfer is 503.
 	 */
-	*size = (TRBS_PER_SEGMENT - 2) * TRB_MAX_BUFF_SIZE;
+	*size = (XFER_RING_NUM_SEGS * (TRBS_PER_SEGMENT - 1) - 1) *
+		TRB_MAX_BUFF_SIZE;
 
 	return 0;
 }
@@ -1520,6 +1549,9 @@ int xhci_deregister(struct udevice *dev)
 struct dm_usb_ops xhci_usb_ops = {
 	.control = xhci_submit_control_msg,
 	.bulk = xhci_submit_bulk_msg,
+	.queue_bulk = xhci_queue_bulk_msg,
+	.complete_bulk = xhci_complete_bulk_msg,
+	.cancel_bulk = xhci_cancel_bulk_msg,
 	.interrupt = xhci_submit_int_msg,
 	.alloc_device = xhci_alloc_device,
 	.update_hub_device = xhci_update_hub_device,
@@ -999,6 +999,11 @@ typedef enum {
 /* TRB buffer pointers can't cross 64KB boundaries */
 #define TRB_MAX_BUFF_SHIFT	16
 #define TRB_MAX_BUFF_SIZE	(1 << TRB_MAX_BUFF_SHIFT)
+/*
+ * Number of segments in each non-control endpoint transfer ring. A bulk
+ * transfer is queued as a single TD, so this bounds the transfer size.
+ */
+#define XFER_RING_NUM_SEGS	8
 
 struct xhci_segment {
 	union xhci_trb		*trbs;
@@ -1056,8 +1061,25 @@ struct xhci_scratchpad {
 #define XHCI_STOP_EP_CMD_TIMEOUT	5
 /* XXX: Make these module parameters */
 
+/* Maximum number of bulk TDs which may be queued on one endpoint */
+#define XHCI_MAX_BULK_TDS	4
+
+/* A bulk TD queued by xhci_bulk_queue() which has not been completed yet */
+struct xhci_bulk_td {
+	void			*buffer;
+	int			length;
+	int			num_trbs;
+	bool			done;
+	unsigned long		status;
+	int			act_len;
+};
+
 struct xhci_virt_ep {
 	struct xhci_ring		*ring;
+	struct xhci_bulk_td		tds[XHCI_MAX_BULK_TDS];
+	unsigned int			td_head;	/* oldest queued TD */
+	unsigned int			td_count;	/* number of queued TDs */
+	unsigned int			td_trbs;	/* TRBs used by them */
 	unsigned int			ep_state;
 #define SET_DEQ_PENDING		(1 << 0)
 #define EP_HALTED		(1 << 1)	/* For stall handling */
@@ -1230,6 +1252,7 @@ struct xhci_ctrl {
 	struct xhci_scratchpad *scratchpad;
 	struct xhci_virt_device *devs[MAX_HC_SLOTS];
 	int rootdev;
+	unsigned int bulk_tds_pending;	/* bulk TDs queued, not yet done */
 };
 
 unsigned long trb_addr(struct xhci_segment *seg, union xhci_trb *trb);
@@ -1255,6 +1278,10 @@ void xhci_acknowledge_event(struct xhci_ctrl *ctrl);
 union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected);
 int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		 int length, void *buffer);
+int xhci_bulk_queue(struct usb_device *udev, unsigned long pipe,
+		    int length, void *buffer);
+int xhci_bulk_complete(struct usb_device *udev, unsigned long pipe);
+int xhci_bulk_cancel(struct usb_device *udev, unsigned long pipe);
 int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
 		 struct devrequest *req, int length, void *buffer);
 int xhci_check_maxpacket(struct usb_device *udev);
@@ -7,6 +7,7 @@
 
 #include "btrfs.h"
 #include <config.h>
+#include <fs.h>
 #include <malloc.h>
 #include <linux/time.h>
 
@@ -212,6 +213,55 @@ void btrfs_close(void)
 	btrfs_chunk_map_exit();
 }
 
+/* An open file is identified by its subvolume root and inode number */
+struct btrfs_file {
+	struct btrfs_root root;
+	u64 inr;
+};
+
+int btrfs_open(const char *file, struct fs_file *fsfile)
+{
+	struct btrfs_inode_item inode;
+	struct btrfs_file *bf;
+	u8 type;
+
+	bf = malloc(sizeof(*bf));
+	if (!bf)
+		return -ENOMEM;
+
+	bf->root = btrfs_info.fs_root;
+	bf->inr = btrfs_lookup_path(&bf->root, bf->root.root_dirid, file,
+				    &type, &inode, 40);
+	if (bf->inr == -1ULL || type != BTRFS_FT_REG_FILE) {
+		free(bf);
+		return -ENOENT;
+	}
+
+	fsfile->size = inode.size;
+	fsfile->priv = bf;
+
+	return 0;
+}
+
+int btrfs_pread(struct fs_file *fsfile, void *buf, loff_t offset, loff_t len,
+		loff_t *actread)
+{
+	struct btrfs_file *bf = fsfile->priv;
+	u64 rd;
+
+	rd = btrfs_file_read(&bf->root, bf->inr, offset, len, buf);
+	if (rd == -1ULL)
+		return -EIO;
+
+	*actread = rd;
+	return 0;
+}
+
+void btrfs_release(struct fs_file *fsfile)
+{
+	free(fsfile->priv);
+}
+
 int btrfs_uuid(char *uuid_str)
 {
 #ifdef CONFIG_LIB_UUID
@@ -23,6 +23,7 @@
 #include <common.h>
 #include <ext_common.h>
 #include <ext4fs.h>
+#include <fs.h>
 #include "ext4_common.h"
 #include <div64.h>
 
@@ -207,6 +208,47 @@ int ext4fs_read(char *buf, loff_t offset, loff_t len, loff_t *actread)
 	return ext4fs_read_file(ext4fs_file, offset, len, buf, actread);
 }
 
+/*
+ * An open file keeps a copy of its inode, so reads only need the node to
+ * be re-attached to whichever mount of the filesystem is current.
+ */
+int ext4fs_open_file(const char *filename, struct fs_file *file)
+{
+	struct ext2fs_node *node;
+	loff_t len;
+
+	if (ext4fs_open(filename, &len) < 0)
+		return -ENOENT;
+
+	node = malloc(sizeof(*node));
+	if (!node)
+		return -ENOMEM;
+	*node = *ext4fs_file;
+	node->data = NULL;
+
+	file->size = len;
+	file->priv = node;
+
+	return 0;
+}
+
+int ext4fs_pread(struct fs_file *file, void *buf, loff_t offset, loff_t len,
+		 loff_t *actread)
+{
+	struct ext2fs_node *node = file->priv;
+
+	if (ext4fs_root == NULL)
+		return -ENODEV;
+	node->data = ext4fs_root;
+
+	return ext4fs_read_file(node, offset, len, buf, actread) < 0 ? -EIO : 0;
+}
+
+void ext4fs_release(struct fs_file *file)
+{
+	free(file->priv);
+}
+
 int ext4fs_probe(struct blk_desc *fs_dev_desc,
 		 disk_partition_t *fs_partition)
 {
@@ -1129,6 +1129,69 @@ int fat_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
 	return ret;
 }
 
+/*
+ * State kept for an open file: the directory entry found when the path was
+ * resolved, plus the partition parameters and FAT buffer so that sequential
+ * reads can reuse the cached FAT sectors.
+ */
+typedef struct {
+	fsdata fsdata;
+	dir_entry dent;
+} fat_file;
+
+int fat_open(const char *filename, struct fs_file *file)
+{
+	fat_file *ff;
+	fat_itr *itr;
+	int ret;
+
+	ff = calloc(1, sizeof(*ff));
+	itr = malloc_cache_aligned(sizeof(fat_itr));
+	if (!ff || !itr) {
+		ret = -ENOMEM;
+		goto out_free_itr;
+	}
+	ret = fat_itr_root(itr, &ff->fsdata);
+	if (ret)
+		goto out_free_itr;
+
+	ret = fat_itr_resolve(itr, filename, TYPE_FILE);
+	if (ret) {
+		free(ff->fsdata.fatbuf);
+		goto out_free_itr;
+	}
+
+	ff->dent = *itr->dent;
+	file->size = FAT2CPU32(ff->dent.size);
+	file->priv = ff;
+	free(itr);
+
+	return 0;
+
+out_free_itr:
+	free(itr);
+	free(ff);
+	return ret;
+}
+
+int fat_pread(struct fs_file *file, void *buf, loff_t offset, loff_t len,
+	      loff_t *actread)
+{
+	fat_file *ff = file->priv;
+
+	return get_contents(&ff->fsdata, &ff->dent, offset, buf, len, actread);
+}
+
+void fat_release(struct fs_file *file)
+{
+	fat_file *ff = file->priv;
+
+	if (!ff)
+		return;
+	free(ff->fsdata.fatbuf);
+	free(ff);
+}
+
 typedef struct {
 	struct fs_dir_stream parent;
 	struct fs_dirent dirent;
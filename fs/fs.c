@@ -6,6 +6,7 @@
 #include <config.h>
 #include <errno.h>
 #include <common.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <part.h>
 #include <ext4fs.h>
@@ -24,6 +25,10 @@ static struct blk_desc *fs_dev_desc;
 static int fs_dev_part;
 static disk_partition_t fs_partition;
 static int fs_type = FS_TYPE_ANY;
+/* bumped on every write, so that open file handles notice stale state */
+static unsigned int fs_write_seq;
+/* value of fs_write_seq when the current volume was mounted */
+static unsigned int fs_mount_seq;
 
 static inline int fs_probe_unsupported(struct blk_desc *fs_dev_desc,
 				      disk_partition_t *fs_partition)
@@ -105,6 +110,20 @@ static inline int fs_opendir_unsupported(const char *filename,
 	return -EACCES;
 }
 
+static inline int fs_open_unsupported(const char *filename,
+				      struct fs_file *file)
+{
+	return -EACCES;
+}
+
+/* generic implementation of file handles in terms of size/read */
+#if defined(CONFIG_SANDBOX) || defined(CONFIG_CMD_UBIFS)
+static int fs_open_generic(const char *filename, struct fs_file *file);
+#endif
+static int fs_pread_generic(struct fs_file *file, void *buf, loff_t offset,
+			    loff_t len, loff_t *actread);
+static void fs_release_generic(struct fs_file *file);
+
 struct fstype_info {
 	int fstype;
 	char *name;
@@ -142,6 +161,20 @@ struct fstype_info {
 	int (*readdir)(struct fs_dir_stream *dirs, struct fs_dirent **dentp);
 	/* see fs_closedir() */
 	void (*closedir)(struct fs_dir_stream *dirs);
+	/*
+	 * Open a regular file.  On success return 0 with file->size
+	 * filled in; the filesystem may keep its own state in file->priv.
+	 * On error, return -errno.  See fs_open().
+	 */
+	int (*open)(const char *filename, struct fs_file *file);
+	/*
+	 * Read from an open file.  The caller has already clamped
+	 * 'offset' and 'len' to the file size.  See fs_pread().
+	 */
+	int (*pread)(struct fs_file *file, void *buf, loff_t offset,
+		     loff_t len, loff_t *actread);
+	/* free file->priv as set up by .open(); see fs_close() */
+	void (*release)(struct fs_file *file);
 };
 
 static struct fstype_info fstypes[] = {
@@ -165,6 +198,9 @@ static struct fstype_info fstypes[] = {
 		.opendir = fat_opendir,
 		.readdir = fat_readdir,
 		.closedir = fat_closedir,
+		.open = fat_open,
+		.pread = fat_pread,
+		.release = fat_release,
 	},
 #endif
 #ifdef CONFIG_FS_EXT4
@@ -185,6 +221,9 @@ static struct fstype_info fstypes[] = {
 #endif
 		.uuid = ext4fs_uuid,
 		.opendir = fs_opendir_unsupported,
+		.open = ext4fs_open_file,
+		.pread = ext4fs_pread,
+		.release = ext4fs_release,
 	},
 #endif
 #ifdef CONFIG_SANDBOX
@@ -201,6 +240,9 @@ static struct fstype_info fstypes[] = {
 		.write = fs_write_sandbox,
 		.uuid = fs_uuid_unsupported,
 		.opendir = fs_opendir_unsupported,
+		.open = fs_open_generic,
+		.pread = fs_pread_generic,
+		.release = fs_release_generic,
 	},
 #endif
 #ifdef CONFIG_CMD_UBIFS
@@ -217,6 +259,9 @@ static struct fstype_info fstypes[] = {
 		.write = fs_write_unsupported,
 		.uuid = fs_uuid_unsupported,
 		.opendir = fs_opendir_unsupported,
+		.open = fs_open_generic,
+		.pread = fs_pread_generic,
+		.release = fs_release_generic,
 	},
 #endif
 #ifdef CONFIG_FS_BTRFS
@@ -233,6 +278,9 @@ static struct fstype_info fstypes[] = {
 		.write = fs_write_unsupported,
 		.uuid = btrfs_uuid,
 		.opendir = fs_opendir_unsupported,
+		.open = btrfs_open,
+		.pread = btrfs_pread,
+		.release = btrfs_release,
 	},
 #endif
 	{
@@ -248,6 +296,9 @@ static struct fstype_info fstypes[] = {
 		.write = fs_write_unsupported,
 		.uuid = fs_uuid_unsupported,
 		.opendir = fs_opendir_unsupported,
+		.open = fs_open_unsupported,
+		.pread = fs_pread_generic,
+		.release = fs_release_generic,
 	},
 };
 
@@ -265,6 +316,15 @@ static struct fstype_info *fs_get_info(int fstype)
 	return info;
 }
 
+static void fs_unmount(void)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+
+	info->close();
+
+	fs_type = FS_TYPE_ANY;
+}
+
 int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 {
 	struct fstype_info *info;
@@ -281,11 +341,17 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 			info->ls += gd->reloc_off;
 			info->read += gd->reloc_off;
 			info->write += gd->reloc_off;
+			info->open += gd->reloc_off;
+			info->pread += gd->reloc_off;
+			info->release += gd->reloc_off;
 		}
 		relocated = 1;
 	}
 #endif
 
+	if (fs_type != FS_TYPE_ANY)
+		fs_unmount();
+
 	part = blk_get_device_part_str(ifname, dev_part_str, &fs_dev_desc,
 					&fs_partition, 1);
 	if (part < 0)
@@ -315,6 +381,9 @@ int fs_set_blk_dev_with_part(struct blk_desc *desc, int part)
 	struct fstype_info *info;
 	int ret, i;
 
+	if (fs_type != FS_TYPE_ANY)
+		fs_unmount();
+
 	if (part >= 1)
 		ret = part_get_info(desc, part, &fs_partition);
 	else
@@ -322,6 +391,7 @@ int fs_set_blk_dev_with_part(struct blk_desc *desc, int part)
 	if (ret)
 		return ret;
 	fs_dev_desc = desc;
+	fs_dev_part = part;
 
 	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
 		if (!info->probe(fs_dev_desc, &fs_partition)) {
@@ -333,15 +403,6 @@ int fs_set_blk_dev_with_part(struct blk_desc *desc, int part)
 	return -1;
 }
 
-static void fs_close(void)
-{
-	struct fstype_info *info = fs_get_info(fs_type);
-
-	info->close();
-
-	fs_type = FS_TYPE_ANY;
-}
-
 int fs_uuid(char *uuid_str)
 {
 	struct fstype_info *info = fs_get_info(fs_type);
@@ -358,7 +419,7 @@ int fs_ls(const char *dirname)
 	ret = info->ls(dirname);
 
 	fs_type = FS_TYPE_ANY;
-	fs_close();
+	fs_unmount();
 
 	return ret;
 }
@@ -371,7 +432,7 @@ int fs_exists(const char *filename)
 
 	ret = info->exists(filename);
 
-	fs_close();
+	fs_unmount();
 
 	return ret;
 }
@@ -384,7 +445,7 @@ int fs_size(const char *filename, loff_t *size)
 
 	ret = info->size(filename, size);
 
-	fs_close();
+	fs_unmount();
 
 	return ret;
 }
@@ -407,7 +468,7 @@ int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	/* If we requested a specific number of bytes, check we got it */
 	if (ret == 0 && len && *actread != len)
 		debug("** %s shorter than offset + len **\n", filename);
-	fs_close();
+	fs_unmount();
 
 	return ret;
 }
@@ -422,12 +483,13 @@ int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
 	buf = map_sysmem(addr, len);
 	ret = info->write(filename, buf, offset, len, actwrite);
 	unmap_sysmem(buf);
+	fs_write_seq++;
 
 	if (ret < 0 && len != *actwrite) {
 		printf("** Unable to write file %s **\n", filename);
 		ret = -1;
 	}
-	fs_close();
+	fs_unmount();
 
 	return ret;
 }
@@ -439,7 +501,7 @@ struct fs_dir_stream *fs_opendir(const char *filename)
 	int ret;
 
 	ret = info->opendir(filename, &dirs);
-	fs_close();
+	fs_unmount();
 	if (ret) {
 		errno = -ret;
 		return NULL;
@@ -461,7 +523,7 @@ struct fs_dirent *fs_readdir(struct fs_dir_stream *dirs)
 	info = fs_get_info(fs_type);
 
 	ret = info->readdir(dirs, &dirent);
-	fs_close();
+	fs_unmount();
 	if (ret) {
 		errno = -ret;
 		return NULL;
@@ -481,7 +543,138 @@ void fs_closedir(struct fs_dir_stream *dirs)
 	info = fs_get_info(fs_type);
 
 	info->closedir(dirs);
-	fs_close();
+	fs_unmount();
+}
+
+/* Force the next handle operation to probe the volume again */
+void fs_invalidate(void)
+{
+	fs_write_seq++;
+}
+
+/*
+ * Make sure the given volume is the one currently mounted. The filesystem
+ * drivers only support one mounted volume at a time, so this acts as a
+ * single-entry cache: it is left mounted after handle operations and only
+ * re-probed when another volume was used in between.
+ */
+static int fs_mount(struct blk_desc *desc, int part)
+{
+	int ret;
+
+	if (fs_type != FS_TYPE_ANY && fs_dev_desc == desc &&
+	    fs_dev_part == part && fs_mount_seq == fs_write_seq)
+		return 0;
+
+	ret = fs_set_blk_dev_with_part(desc, part);
+	fs_mount_seq = fs_write_seq;
+
+	return ret;
+}
+
+#if defined(CONFIG_SANDBOX) || defined(CONFIG_CMD_UBIFS)
+static int fs_open_generic(const char *filename, struct fs_file *file)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+
+	if (!info->exists(filename) || info->size(filename, &file->size))
+		return -ENOENT;
+
+	return 0;
+}
+#endif
+
+static int fs_pread_generic(struct fs_file *file, void *buf, loff_t offset,
+			    loff_t len, loff_t *actread)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+
+	return info->read(file->path, buf, offset, len, actread) ? -EIO : 0;
+}
+
+static void fs_release_generic(struct fs_file *file)
+{
+}
+
+int fs_open(struct blk_desc *desc, int part, const char *filename,
+	    struct fs_file **filep)
+{
+	struct fstype_info *info;
+	struct fs_file *file;
+	int ret;
+
+	file = calloc(1, sizeof(*file));
+	if (!file)
+		return -ENOMEM;
+	file->path = strdup(filename);
+	if (!file->path) {
+		ret = -ENOMEM;
+		goto err;
+	}
+
+	if (fs_mount(desc, part)) {
+		ret = -ENODEV;
+		goto err;
+	}
+
+	info = fs_get_info(fs_type);
+	ret = info->open(filename, file);
+	if (ret)
+		goto err;
+
+	file->desc = desc;
+	file->part = part;
+	file->fstype = fs_type;
+	file->seq = fs_write_seq;
+	*filep = file;
+
+	return 0;
+err:
+	free(file->path);
+	free(file);
+	return ret;
+}
+
+int fs_pread(struct fs_file *file, void *buf, loff_t offset, loff_t len,
+	     loff_t *actread)
+{
+	struct fstype_info *info;
+	int ret;
+
+	if (fs_mount(file->desc, file->part) || fs_type != file->fstype)
+		return -ENODEV;
+	info = fs_get_info(fs_type);
+
+	/* A write may have changed the file, so resolve the path again */
+	if (file->seq != fs_write_seq) {
+		info->release(file);
+		file->priv = NULL;
+		ret = info->open(file->path, file);
+		if (ret)
+			return ret;
+		file->seq = fs_write_seq;
+	}
+
+	*actread = 0;
+	if (offset >= file->size || !len)
+		return 0;
+	if (len > file->size - offset)
+		len = file->size - offset;
+
+	return info->pread(file, buf, offset, len, actread);
+}
+
+void fs_close(struct fs_file *file)
+{
+	struct fstype_info *info;
+
+	if (!file)
+		return;
+
+	info = fs_get_info(file->fstype);
+	info->release(file);
+	free(file->path);
+	free(file);
 }
 
 
@@ -504,6 +697,54 @@ int do_size(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	return 0;
 }
 
+/*
+ * Read the structure at the start of a FIT file and find where to load the
+ * file so that its kernel data ends up at the kernel load address
+ */
+static int fs_fit_load_addr(const char *ifname, const char *dev_part_str,
+			    int fstype, const char *filename, ulong *addrp)
+{
+	loff_t len_read, size;
+	void *fit, *buf;
+	int ret;
+
+	fit = malloc(sizeof(struct fdt_header));
+	if (!fit)
+		return -ENOMEM;
+	if (fs_read(filename, map_to_sysmem(fit), 0, sizeof(struct fdt_header),
+		    &len_read) < 0 || len_read != sizeof(struct fdt_header) ||
+	    fdt_check_header(fit)) {
+		printf("** %s is not a FIT **\n", filename);
+		ret = -EINVAL;
+		goto out;
+	}
+	size = fdt_totalsize(fit);
+	buf = realloc(fit, size);
+	if (!buf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	fit = buf;
+	ret = fs_set_blk_dev(ifname, dev_part_str, fstype);
+	if (!ret && fs_read(filename, map_to_sysmem(fit), 0, size,
+			    &len_read) < 0)
+		ret = -EIO;
+	if (!ret)
+		ret = fit_get_kernel_placement(fit, addrp);
+	if (ret) {
+		printf("** Cannot place %s at its kernel address: %d **\n",
+		       filename, ret);
+		goto out;
+	}
+
+	/* fs_read() finishes with the device, so set it up again */
+	ret = fs_set_blk_dev(ifname, dev_part_str, fstype);
+out:
+	free(fit);
+
+	return ret;
+}
+
 int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype)
 {
@@ -515,6 +756,7 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	loff_t len_read;
 	int ret;
 	unsigned long time;
+	bool place_fit = false;
 	char *ep;
 
 	if (argc < 2)
@@ -525,7 +767,9 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	if (fs_set_blk_dev(argv[1], (argc >= 3) ? argv[2] : NULL, fstype))
 		return 1;
 
-	if (argc >= 4) {
+	if (IS_ENABLED(CONFIG_FIT) && argc >= 4 && !strcmp(argv[3], "-")) {
+		place_fit = true;
+	} else if (argc >= 4) {
 		addr = simple_strtoul(argv[3], &ep, 16);
 		if (ep == argv[3] || *ep != '\0')
 			return CMD_RET_USAGE;
@@ -554,6 +798,10 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	else
 		pos = 0;
 
+	if (place_fit && fs_fit_load_addr(argv[1], argv[2], fstype, filename,
+					  &addr))
+		return 1;
+
 	time = get_timer(0);
 	ret = fs_read(filename, addr, pos, bytes, &len_read);
 	time = get_timer(time);
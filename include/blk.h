@@ -41,6 +41,46 @@ enum if_type {
 #define BLK_PRD_SIZE		20
 #define BLK_REV_SIZE		8
 
+/* Operations for which block-device statistics are kept */
+enum blk_stats_op {
+	BLK_STATS_READ,
+	BLK_STATS_WRITE,
+	BLK_STATS_ERASE,
+
+	BLK_STATS_OP_COUNT,
+};
+
+/* Number of request-size buckets, each covering twice the previous one */
+#define BLK_STATS_HIST_COUNT	12
+
+/**
+ * struct blk_op_stats - I/O statistics for one type of operation
+ *
+ * @ops:	Number of requests passed to the driver
+ * @errors:	Number of requests which did not complete all their blocks
+ * @blocks:	Number of blocks transferred
+ * @total_us:	Total time spent in the driver in microseconds
+ * @min_us:	Time taken by the quickest request
+ * @max_us:	Time taken by the slowest request
+ * @hist:	Request-size histogram: bucket n counts requests of 2^n to
+ *		2^(n + 1) - 1 blocks, the last bucket also counting all larger
+ *		requests
+ */
+struct blk_op_stats {
+	ulong ops;
+	ulong errors;
+	u64 blocks;
+	u64 total_us;
+	ulong min_us;
+	ulong max_us;
+	ulong hist[BLK_STATS_HIST_COUNT];
+};
+
+/* I/O statistics for a block device, kept if CONFIG_BLK_STATS is enabled */
+struct blk_stats {
+	struct blk_op_stats op[BLK_STATS_OP_COUNT];
+};
+
 /*
  * Identifies the partition table type (ie. MBR vs GPT GUID) signature
  */
@@ -91,6 +131,9 @@ struct blk_desc {
 	 * device. Once these functions are removed we can drop this field.
 	 */
 	struct udevice *bdev;
+#if CONFIG_IS_ENABLED(BLK_STATS)
+	struct blk_stats stats;
+#endif
 #else
 	unsigned long	(*block_read)(struct blk_desc *block_dev,
 				      lbaint_t start,
@@ -196,6 +239,19 @@ static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
 
+#ifndef CONFIG_SPL_BUILD
+/**
+ * fs_invalidate() - note that blocks on a device have been written
+ *
+ * The fs layer keeps the last volume it used mounted, and open files keep
+ * their position in the filesystem. Both must be looked up again once the
+ * blocks underneath them may have changed.
+ */
+void fs_invalidate(void);
+#else
+static inline void fs_invalidate(void) {}
+#endif
+
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
@@ -399,6 +455,28 @@ int blk_find_max_devnum(enum if_type if_type);
  */
 int blk_select_hwpart(struct udevice *dev, int hwpart);
 
+/**
+ * blk_reset_stats() - Clear the I/O statistics of a block device
+ *
+ * This does nothing unless CONFIG_BLK_STATS is enabled.
+ *
+ * @dev:	Block device to reset
+ */
+void blk_reset_stats(struct udevice *dev);
+
+/**
+ * blk_stats_fdt_add() - Add block-device I/O statistics to a device tree
+ *
+ * A subnode is added to @parent for each block device which has done any
+ * I/O, holding the number of requests, blocks and microseconds spent for
+ * each operation.
+ *
+ * @blob:	Device tree to update
+ * @parent:	Offset of node to add the statistics to
+ * @return 0 if OK, -ve on error
+ */
+int blk_stats_fdt_add(void *blob, int parent);
+
 /**
  * blk_get_from_parent() - obtain a block device by looking up its parent
  *
@@ -439,6 +517,7 @@ static inline ulong blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt, const void *buffer)
 {
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	fs_invalidate();
 	return block_dev->block_write(block_dev, start, blkcnt, buffer);
 }
 
@@ -446,6 +525,7 @@ static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt)
 {
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	fs_invalidate();
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
@@ -15,6 +15,7 @@
 enum bootstage_flags {
 	BOOTSTAGEF_ERROR	= 1 << 0,	/* Error record */
 	BOOTSTAGEF_ALLOC	= 1 << 1,	/* Allocate an id */
+	BOOTSTAGEF_VALUE	= 1 << 2,	/* Value, not a time */
 };
 
 /* bootstate sub-IDs used for kernel and ramdisk ranges */
@@ -199,6 +200,11 @@ enum bootstage_id {
 	BOOTSTATE_ID_ACCUM_DM_SPL,
 	BOOTSTATE_ID_ACCUM_DM_F,
 	BOOTSTATE_ID_ACCUM_DM_R,
+	BOOTSTAGE_ID_ACCUM_BLK,
+	BOOTSTAGE_ID_ACCUM_FDT_FIXUP,
+	BOOTSTAGE_ID_MALLOC_F_SPL,
+	BOOTSTAGE_ID_MALLOC_F,
+	BOOTSTAGE_ID_ACCUM_DRAM,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -264,6 +270,18 @@ ulong bootstage_error(enum bootstage_id id);
 
 ulong bootstage_mark_name(enum bootstage_id id, const char *name);
 
+/**
+ * Record a value, such as an amount of memory used, rather than a time
+ *
+ * The value is shown separately in the report.
+ *
+ * @param id	Bootstage ID to use
+ * @param name	Name of record
+ * @param value	Value to record
+ * @return value
+ */
+ulong bootstage_value(enum bootstage_id id, const char *name, ulong value);
+
 /**
  * Mark a time stamp in the given function and line number
  *
@@ -387,6 +405,12 @@ static inline ulong bootstage_mark_name(enum bootstage_id id, const char *name)
 	return 0;
 }
 
+static inline ulong bootstage_value(enum bootstage_id id, const char *name,
+				    ulong value)
+{
+	return value;
+}
+
 static inline ulong bootstage_mark_code(const char *file, const char *func,
 					int linenum)
 {
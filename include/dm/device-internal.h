@@ -90,6 +90,23 @@ int device_bind_by_name(struct udevice *parent, bool pre_reloc_only,
  */
 int device_probe(struct udevice *dev);
 
+/**
+ * device_probe_start() - Start probing a device without waiting for it
+ *
+ * This does everything device_probe() does, including probing the parents,
+ * but then calls the driver's probe_start() method instead of probe(). The
+ * probe is completed by the next device_probe() call, which calls probe().
+ * This allows several slow devices to initialise at the same time. Until
+ * then the device has DM_FLAG_PROBE_PENDING set and is not active.
+ *
+ * If the driver has no probe_start() method this is the same as
+ * device_probe().
+ *
+ * @dev: Pointer to device to probe
+ * @return 0 if OK, -ve on error
+ */
+int device_probe_start(struct udevice *dev);
+
 /**
  * device_remove() - Remove a device, de-activating it
  *
@@ -61,6 +61,13 @@ struct driver_info;
  */
 #define DM_FLAG_OS_PREPARE		(1 << 10)
 
+/*
+ * Device probe has been started by device_probe_start() and the driver's
+ * probe() method has not yet been called to complete it. DM_FLAG_ACTIVATED
+ * stays clear until then, so the device is not treated as ready.
+ */
+#define DM_FLAG_PROBE_PENDING		(1 << 11)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
@@ -207,6 +214,10 @@ struct udevice_id {
  * for each.
  * @bind: Called to bind a device to its driver
  * @probe: Called to probe a device, i.e. activate it
+ * @probe_start: Optional. Called by device_probe_start() to start a slow
+ * probe (e.g. link training or power-up) without waiting for it. The
+ * probe() method is called later to wait for and complete the probe. If
+ * the device is removed in between, remove() is called without probe().
  * @remove: Called to remove a device, i.e. de-activate it
  * @unbind: Called to unbind a device from its driver
  * @ofdata_to_platdata: Called before probe to decode device tree data
@@ -240,6 +251,7 @@ struct driver {
 	const struct udevice_id *of_match;
 	int (*bind)(struct udevice *dev);
 	int (*probe)(struct udevice *dev);
+	int (*probe_start)(struct udevice *dev);
 	int (*remove)(struct udevice *dev);
 	int (*unbind)(struct udevice *dev);
 	int (*ofdata_to_platdata)(struct udevice *dev);
@@ -44,6 +44,20 @@ struct uclass_driver *lists_uclass_lookup(enum uclass_id id);
  */
 int lists_bind_drivers(struct udevice *parent, bool pre_reloc_only);
 
+/**
+ * lists_driver_lookup_compat() - Find a driver matching a compatible string
+ *
+ * This finds the first driver in the linker list with an of_match entry
+ * for @compat. If CONFIG_DM_COMPAT_INDEX is enabled this uses an index,
+ * once full malloc() is available.
+ *
+ * @compat:	Compatible string to look up
+ * @idp:	Returns the matching of_match entry
+ * @return pointer to driver, or NULL if none
+ */
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **idp);
+
 /**
  * lists_bind_fdt() - bind a device tree node
  *
@@ -193,6 +193,19 @@ static inline struct device_node *of_find_node_by_path(const char *path)
 struct device_node *of_find_compatible_node(struct device_node *from,
 				const char *type, const char *compatible);
 
+/**
+ * of_populate_phandle_cache() - Build the cache used to look up phandles
+ *
+ * This is called when the live tree is created. It is also called by
+ * of_find_node_by_phandle() if gd->of_root has changed since the cache
+ * was built. Lookups fall back to searching the tree if a node is not in
+ * the cache. This does nothing unless CONFIG_OF_PHANDLE_CACHE is enabled.
+ *
+ * @root:	Root node of the tree to index
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int of_populate_phandle_cache(struct device_node *root);
+
 /**
  * of_find_node_by_phandle() - Find a node given a phandle
  *
@@ -26,7 +26,7 @@
 struct driver_info {
 	const char *name;
 	const void *platdata;
-#if CONFIG_IS_ENABLED(OF_PLATDATA)
+#if CONFIG_IS_ENABLED(OF_PLATDATA) || CONFIG_IS_ENABLED(OF_PLATDATA_NODES)
 	uint platdata_size;
 #endif
 };
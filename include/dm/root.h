@@ -9,6 +9,9 @@
 #ifndef _DM_ROOT_H_
 #define _DM_ROOT_H_
 
+#include <dm/ofnode.h>
+#include <dm/uclass-id.h>
+
 struct udevice;
 
 /**
@@ -94,6 +97,79 @@ int dm_scan_other(bool pre_reloc_only);
  */
 int dm_init_and_scan(bool pre_reloc_only);
 
+/**
+ * struct dm_lazy_node - A device tree node whose binding has been deferred
+ *
+ * @parent:	Parent device to bind the node to
+ * @node:	Device tree node
+ * @uclasses:	Bitmap of the uclasses of this node and its subnodes
+ * @next:	Next deferred node
+ */
+struct dm_lazy_node {
+	struct udevice *parent;
+	ofnode node;
+	ulong uclasses[DIV_ROUND_UP(UCLASS_COUNT, BITS_PER_LONG)];
+	struct dm_lazy_node *next;
+};
+
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+/**
+ * dm_lazy_bind_uclass() - Bind deferred nodes which provide a uclass
+ *
+ * This binds each deferred node which has itself, or a subnode, in the
+ * given uclass. It is called when a uclass is looked up.
+ *
+ * @id:		Uclass ID to bind devices for
+ * @return 0 if OK, -ve on error
+ */
+int dm_lazy_bind_uclass(enum uclass_id id);
+
+/**
+ * dm_lazy_bind_all() - Bind all deferred nodes
+ *
+ * @return 0 if OK, -ve on error
+ */
+int dm_lazy_bind_all(void);
+
+/**
+ * dm_lazy_forget() - Drop deferred nodes which have a given parent
+ *
+ * This is called when @parent is unbound.
+ *
+ * @parent:	Parent device
+ */
+void dm_lazy_forget(struct udevice *parent);
+#else
+static inline int dm_lazy_bind_uclass(enum uclass_id id) { return 0; }
+static inline int dm_lazy_bind_all(void) { return 0; }
+static inline void dm_lazy_forget(struct udevice *parent) {}
+#endif
+
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+/**
+ * dm_probe_start_all() - Start probing devices with a probe_start() method
+ *
+ * This calls device_probe_start() on each bound device whose driver has a
+ * probe_start() method. Failures are reported but do not stop the others.
+ *
+ * @return 0 if OK, -ve on error (the first error seen)
+ */
+int dm_probe_start_all(void);
+
+/**
+ * dm_probe_complete_all() - Complete the probe of all started devices
+ *
+ * This calls device_probe() on each device started by dm_probe_start_all()
+ * which has not yet completed its probe.
+ *
+ * @return 0 if OK, -ve on error (the first error seen)
+ */
+int dm_probe_complete_all(void);
+#else
+static inline int dm_probe_start_all(void) { return 0; }
+static inline int dm_probe_complete_all(void) { return 0; }
+#endif
+
 /**
  * dm_init() - Initialise Driver Model structures
  *
@@ -39,6 +39,7 @@ enum {
 	DM_TEST_OP_UNBIND,
 	DM_TEST_OP_PROBE,
 	DM_TEST_OP_REMOVE,
+	DM_TEST_OP_PROBE_START,
 
 	/* For uclass */
 	DM_TEST_OP_POST_BIND,
@@ -69,8 +70,14 @@ struct dm_test_priv {
 	int op_count[DM_TEST_OP_COUNT];
 	int uclass_flag;
 	int uclass_total;
+	ulong ready_time;
+	int wait_seq;
+	int ready_seq;
 };
 
+/* Time taken by test_async_drv to probe */
+#define DM_TEST_ASYNC_DELAY_MS	20
+
 /**
  * struct dm_test_perdev_class_priv - private per-device data for test uclass
  */
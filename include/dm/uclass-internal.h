@@ -192,6 +192,18 @@ int uclass_pre_remove_device(struct udevice *dev);
 static inline int uclass_pre_remove_device(struct udevice *dev) { return 0; }
 #endif
 
+/**
+ * uclass_find_or_add() - Find a uclass by its id, creating it if needed
+ *
+ * This is like uclass_get() but does not bind deferred device tree nodes
+ * (see CONFIG_DM_LAZY_BIND). It is used when binding a device.
+ *
+ * @id:		Id to search for
+ * @ucp:	Returns pointer to uclass (there is only one per ID)
+ * @return 0 if OK, -ve on error
+ */
+int uclass_find_or_add(enum uclass_id id, struct uclass **ucp);
+
 /**
  * uclass_find() - Find uclass by its id
  *
@@ -6,8 +6,11 @@
 #ifndef __DT_STRUCTS
 #define __DT_STRUCTS
 
-/* These structures may only be used in SPL */
-#if CONFIG_IS_ENABLED(OF_PLATDATA)
+/*
+ * These structures may only be used in SPL, or in U-Boot for the nodes
+ * selected with CONFIG_OF_PLATDATA_NODES
+ */
+#if CONFIG_IS_ENABLED(OF_PLATDATA) || CONFIG_IS_ENABLED(OF_PLATDATA_NODES)
 struct phandle_0_arg {
 	const void *node;
 	int arg[0];
@@ -22,7 +25,11 @@ struct phandle_2_arg {
 	const void *node;
 	int arg[2];
 };
+#ifdef CONFIG_SPL_BUILD
 #include <generated/dt-structs-gen.h>
+#else
+#include <generated/dt-structs-u-boot.h>
+#endif
 #endif
 
 #endif
@@ -136,6 +136,10 @@ struct efi_open_protocol_info_item {
 struct efi_handler {
 	/* Link to the list of protocols of a handle */
 	struct list_head link;
+	/* Link to the list of all installations of the same protocol */
+	struct list_head index_link;
+	/* Handle on which the protocol is installed */
+	efi_handle_t handle;
 	const efi_guid_t *guid;
 	void *protocol_interface;
 	/* Link to the list of open protocol info items */
@@ -152,6 +156,8 @@ struct efi_handler {
 struct efi_object {
 	/* Every UEFI object is part of a global object list */
 	struct list_head link;
+	/* Link to the hash table used to validate handles */
+	struct hlist_node hash_link;
 	/* The list of protocols */
 	struct list_head protocols;
 	/* The object spawner can either use this for data or as identifier */
@@ -162,6 +168,7 @@ struct efi_object {
  * struct efi_event
  *
  * @link:		Link to list of all events
+ * @queue_link:		Link to list of queued notifications
  * @type:		Type of event, see efi_create_event
  * @notify_tpl:		Task priority level of notifications
  * @nofify_function:	Function to call when the event is triggered
@@ -170,11 +177,13 @@ struct efi_object {
  * @trigger_time:	Period of the timer
  * @trigger_next:	Next time to trigger the timer
  * @trigger_type:	Type of timer, see efi_set_timer
+ * @timer_index:	Position in the queue of armed timers, -1 if not armed
  * @is_queued:		The notification function is queued
  * @is_signaled:	The event occurred. The event is in the signaled state.
  */
 struct efi_event {
 	struct list_head link;
+	struct list_head queue_link;
 	uint32_t type;
 	efi_uintn_t notify_tpl;
 	void (EFIAPI *notify_function)(struct efi_event *event, void *context);
@@ -183,6 +192,7 @@ struct efi_event {
 	u64 trigger_next;
 	u64 trigger_time;
 	enum efi_timer_delay trigger_type;
+	int timer_index;
 	bool is_queued;
 	bool is_signaled;
 };
@@ -234,6 +244,8 @@ void efi_set_bootdev(const char *dev, const char *devnr, const char *path);
 void efi_add_handle(struct efi_object *obj);
 /* Create handle */
 efi_status_t efi_create_handle(efi_handle_t *handle);
+/* Remove handle from the object list without freeing it */
+void efi_remove_handle(struct efi_object *obj);
 /* Delete handle */
 void efi_delete_handle(struct efi_object *obj);
 /* Call this to validate a handle and find the EFI object for it */
@@ -252,6 +264,9 @@ efi_status_t efi_remove_protocol(const efi_handle_t handle,
 				 void *protocol_interface);
 /* Delete all protocols from a handle */
 efi_status_t efi_remove_all_protocols(const efi_handle_t handle);
+/* Iterate over all installations of a protocol */
+struct efi_handler *efi_next_handler(const efi_guid_t *protocol,
+				     struct efi_handler *prev);
 /* Call this to create an event */
 efi_status_t efi_create_event(uint32_t type, efi_uintn_t notify_tpl,
 			      void (EFIAPI *notify_function) (
@@ -424,6 +439,8 @@ efi_status_t EFIAPI efi_get_next_variable(
 efi_status_t EFIAPI efi_set_variable(s16 *variable_name,
 		efi_guid_t *vendor, u32 attributes,
 		unsigned long data_size, void *data);
+/* Write changed non-volatile variables back to the environment */
+efi_status_t efi_variables_commit(void);
 
 void *efi_bootmgr_load(struct efi_device_path **device_path,
 		       struct efi_device_path **file_path);
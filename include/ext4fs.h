@@ -133,11 +133,17 @@ int ext4_write_file(const char *filename, void *buf, loff_t offset, loff_t len,
 		    loff_t *actwrite);
 #endif
 
+struct fs_file;
+
 struct ext_filesystem *get_fs(void);
 int ext4fs_open(const char *filename, loff_t *len);
 int ext4fs_read(char *buf, loff_t offset, loff_t len, loff_t *actread);
 int ext4fs_mount(unsigned part_length);
 void ext4fs_close(void);
+int ext4fs_open_file(const char *filename, struct fs_file *file);
+int ext4fs_pread(struct fs_file *file, void *buf, loff_t offset, loff_t len,
+		 loff_t *actread);
+void ext4fs_release(struct fs_file *file);
 void ext4fs_reinit_global(void);
 int ext4fs_ls(const char *dirname);
 int ext4fs_exists(const char *filename);
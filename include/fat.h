@@ -201,5 +201,9 @@ int fat_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
 int fat_opendir(const char *filename, struct fs_dir_stream **dirsp);
 int fat_readdir(struct fs_dir_stream *dirs, struct fs_dirent **dentp);
 void fat_closedir(struct fs_dir_stream *dirs);
+int fat_open(const char *filename, struct fs_file *file);
+int fat_pread(struct fs_file *file, void *buf, loff_t offset, loff_t len,
+	      loff_t *actread);
+void fat_release(struct fs_file *file);
 void fat_close(void);
 #endif /* _FAT_H_ */
@@ -10,6 +10,89 @@
 #ifdef CONFIG_OF_LIBFDT
 
 #include <linux/libfdt.h>
+#include <linux/list.h>
+
+/**
+ * struct fdt_batch - A set of property writes to apply to an FDT together
+ *
+ * Rather than updating the tree for each fixup, which moves everything after
+ * the change each time, a batch collects the writes and applies them all in
+ * a single pass over the tree when committed. Nodes are identified by path,
+ * so the tree may still be changed directly while a batch is open, as long
+ * as the same properties are not written both ways.
+ *
+ * @blob: FDT to update
+ * @props: List of pending property writes
+ * @count: Number of pending property writes
+ * @extra: Upper bound on the bytes the pending writes add to the FDT
+ * @defer: true to collect the writes, false to apply each one immediately
+ */
+struct fdt_batch {
+	void *blob;
+	struct list_head props;
+	int count;
+	int extra;
+	bool defer;
+};
+
+/**
+ * fdt_batch_init() - Start a batch of writes to an FDT
+ *
+ * @batch: Batch to set up
+ * @blob: FDT to update
+ * @defer: true to collect writes until fdt_batch_commit() is called, false
+ *	to apply each one immediately. Writes are always applied immediately
+ *	if CONFIG_FDT_FIXUP_BATCH is not enabled.
+ */
+void fdt_batch_init(struct fdt_batch *batch, void *blob, bool defer);
+
+/**
+ * fdt_batch_setprop() - Add a property write to a batch
+ *
+ * The node is created if it does not exist, so long as its parent does (or
+ * is created by the same batch). A later write to the same property
+ * replaces an earlier one.
+ *
+ * @batch: Batch to add to
+ * @path: Path or alias of the node to write to
+ * @name: Name of property to write, or NULL to just create the node
+ * @val: Property value
+ * @len: Length of property value in bytes
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_setprop(struct fdt_batch *batch, const char *path,
+		      const char *name, const void *val, int len);
+
+/**
+ * fdt_batch_commit() - Apply all writes in a batch to its FDT
+ *
+ * The FDT is not changed if there is not enough space for all the writes.
+ * The batch is empty afterwards, whether or not this succeeds.
+ *
+ * @batch: Batch to apply
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_commit(struct fdt_batch *batch);
+
+/**
+ * fdt_batch_abort() - Drop all writes in a batch without applying them
+ *
+ * @batch: Batch to empty
+ */
+void fdt_batch_abort(struct fdt_batch *batch);
+
+/**
+ * fdt_batch_current() - Get the batch being collected for an FDT
+ *
+ * While a deferred batch is open, fdt_root(), fdt_chosen(), fdt_initrd(),
+ * fdt_fixup_ethernet() and fdt_fixup_memory_banks() add their writes to it
+ * rather than writing to the FDT directly. This lets fixups called from
+ * arch_fixup_fdt() join the batch in image_setup_libfdt().
+ *
+ * @blob: FDT to check
+ * @return the open batch for @blob, or NULL if none
+ */
+struct fdt_batch *fdt_batch_current(const void *blob);
 
 u32 fdt_getprop_u32_default_node(const void *fdt, int off, int cell,
 				const char *prop, const u32 dflt);
@@ -26,6 +109,16 @@ u32 fdt_getprop_u32_default(const void *fdt, const char *path,
  */
 int fdt_root(void *fdt);
 
+/**
+ * fdt_batch_root() - Add root-node data to an FDT batch
+ *
+ * This is the same as fdt_root() but adds the writes to a batch.
+ *
+ * @batch: Batch to add to
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_root(struct fdt_batch *batch);
+
 /**
  * Add chosen data the FDT before booting the OS.
  *
@@ -36,6 +129,16 @@ int fdt_root(void *fdt);
  */
 int fdt_chosen(void *fdt);
 
+/**
+ * fdt_batch_chosen() - Add chosen data to an FDT batch
+ *
+ * This is the same as fdt_chosen() but adds the writes to a batch.
+ *
+ * @batch: Batch to add to
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_chosen(struct fdt_batch *batch);
+
 /**
  * Add initrd information to the FDT before booting the OS.
  *
@@ -44,6 +147,20 @@ int fdt_chosen(void *fdt);
  */
 int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end);
 
+/**
+ * fdt_batch_initrd() - Add initrd information to an FDT batch
+ *
+ * This is the same as fdt_initrd() but adds the /chosen properties to a
+ * batch. The memory reservation is still added to the FDT directly.
+ *
+ * @batch: Batch to add to
+ * @initrd_start: Start address of the initrd
+ * @initrd_end: End address of the initrd
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_initrd(struct fdt_batch *batch, ulong initrd_start,
+		     ulong initrd_end);
+
 void do_fixup_by_path(void *fdt, const char *path, const char *prop,
 		      const void *val, int len, int create);
 void do_fixup_by_path_u32(void *fdt, const char *path, const char *prop,
@@ -94,6 +211,21 @@ int fdt_fixup_memory(void *blob, u64 start, u64 size);
  */
 #ifdef CONFIG_ARCH_FIXUP_FDT_MEMORY
 int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks);
+
+/**
+ * fdt_batch_memory_banks() - Add the memory node to an FDT batch
+ *
+ * This is the same as fdt_fixup_memory_banks() but adds the writes to a
+ * batch.
+ *
+ * @batch: Batch to add to
+ * @start: Array of size <banks> to hold the start addresses
+ * @size: Array of size <banks> to hold the size of each region
+ * @banks: Number of memory banks to create
+ * @return 0 if ok, or -1 or -FDT_ERR_... on error
+ */
+int fdt_batch_memory_banks(struct fdt_batch *batch, u64 start[], u64 size[],
+			   int banks);
 #else
 static inline int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[],
 					 int banks)
@@ -103,6 +235,15 @@ static inline int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[],
 #endif
 
 void fdt_fixup_ethernet(void *fdt);
+
+/**
+ * fdt_batch_ethernet() - Add ethernet MAC addresses to an FDT batch
+ *
+ * This is the same as fdt_fixup_ethernet() but adds the writes to a batch.
+ *
+ * @batch: Batch to add to
+ */
+void fdt_batch_ethernet(struct fdt_batch *batch);
 int fdt_find_and_setprop(void *fdt, const char *node, const char *prop,
 			 const void *val, int len, int create);
 void fdt_fixup_qe_firmware(void *fdt);
@@ -282,6 +423,8 @@ int fdt_setup_simplefb_node(void *fdt, int node, u64 base_address, u32 width,
 			    u32 height, u32 stride, const char *format);
 
 int fdt_overlay_apply_verbose(void *fdt, void *fdto);
+int fdt_overlay_apply_index_verbose(void *fdt, void *fdto,
+				    struct fdt_overlay_index *idx);
 
 #endif /* ifdef CONFIG_OF_LIBFDT */
 
@@ -658,6 +658,20 @@ const char *fdtdec_get_compatible(enum fdt_compat_id id);
  */
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name);
 
+/**
+ * fdtdec_node_offset_by_phandle() - Find the node with a given phandle
+ *
+ * This is equivalent to fdt_node_offset_by_phandle() but, for the control
+ * FDT and with CONFIG_OF_PHANDLE_CACHE enabled, uses a cache of node
+ * offsets indexed by phandle. Cached offsets are checked before use, so
+ * the FDT may be modified without invalidating the cache explicitly.
+ *
+ * @param blob		FDT blob
+ * @param phandle	phandle to look up
+ * @return node offset if found, -ve error code on error
+ */
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle);
+
 /**
  * Look up a property in a node and return its contents in an integer
  * array of given length. The property must have at least enough data for
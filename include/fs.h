@@ -145,6 +145,60 @@ struct fs_dirent *fs_readdir(struct fs_dir_stream *dirs);
  */
 void fs_closedir(struct fs_dir_stream *dirs);
 
+/* Note: fs_file should be treated as opaque to the user of fs layer */
+struct fs_file {
+	/* private to fs. layer: */
+	struct blk_desc *desc;
+	int part;
+	int fstype;
+	unsigned int seq;
+	char *path;
+	void *priv;
+	/* size of the file in bytes */
+	loff_t size;
+};
+
+/*
+ * fs_open - Open a regular file for repeated reads
+ *
+ * The path is resolved once and the volume is left mounted, so that
+ * subsequent fs_pread() calls on the same partition neither re-probe the
+ * filesystem nor walk the directory tree again. The handle stays valid if
+ * other fs calls mount a different volume in the meantime; it is then
+ * transparently remounted on the next read.
+ *
+ * @desc: block device holding the filesystem
+ * @part: partition number, or 0 for the whole device
+ * @filename: path of the file to open
+ * @filep: returns the new file handle
+ * @return 0 if ok, -ve on error
+ */
+int fs_open(struct blk_desc *desc, int part, const char *filename,
+	    struct fs_file **filep);
+
+/*
+ * fs_pread - Read from a file opened with fs_open()
+ *
+ * Unlike fs_read(), a @len of 0 reads nothing. Reads beyond the end of the
+ * file are truncated.
+ *
+ * @file: file handle
+ * @buf: buffer to read into
+ * @offset: offset in file to read from
+ * @len: maximum number of bytes to read
+ * @actread: returns the actual number of bytes read
+ * @return 0 if ok with valid *actread, -ve on error
+ */
+int fs_pread(struct fs_file *file, void *buf, loff_t offset, loff_t len,
+	     loff_t *actread);
+
+/*
+ * fs_close - Close a file handle returned by fs_open()
+ *
+ * @file: file handle, may be NULL
+ */
+void fs_close(struct fs_file *file);
+
 /*
  * Common implementation for various filesystem commands, optionally limited
  * to a specific filesystem type via the fstype parameter.
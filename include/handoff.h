@@ -0,0 +1,186 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Passing state from SPL to U-Boot proper
+ *
+ * SPL fills a handoff area in memory with tagged records describing what it
+ * has already set up, such as the DRAM banks. U-Boot proper checks the area
+ * early in board_init_f() and uses the records instead of working the same
+ * things out again.
+ */
+
+#ifndef _HANDOFF_H
+#define _HANDOFF_H
+
+#include <mapmem.h>
+#include <linux/errno.h>
+#include <linux/types.h>
+
+enum {
+	HANDOFF_MAGIC		= 0x4f444e48,	/* "HNDO" */
+	HANDOFF_VERSION		= 0,
+	HANDOFF_ALIGN		= 8,
+};
+
+/* Tags for the records in the handoff area */
+enum handoff_tag {
+	HANDOFF_TAG_NONE,
+	HANDOFF_TAG_DRAM,		/* struct handoff_dram */
+	HANDOFF_TAG_CLOCKS,		/* struct handoff_clocks */
+
+	/* Board-specific records from here */
+	HANDOFF_TAG_BOARD	= 0x100,
+};
+
+/**
+ * struct handoff_hdr - Header of the handoff area
+ *
+ * @magic:	HANDOFF_MAGIC
+ * @version:	HANDOFF_VERSION
+ * @size:	Number of bytes used, including this header
+ * @max_size:	Size of the area
+ * @crc32:	CRC32 of the records, from the end of the header to @size
+ * @spare:	Zero
+ */
+struct handoff_hdr {
+	u32 magic;
+	u32 version;
+	u32 size;
+	u32 max_size;
+	u32 crc32;
+	u32 spare;
+};
+
+/**
+ * struct handoff_rec - Header of a record in the handoff area
+ *
+ * The data follows the header and is padded to HANDOFF_ALIGN bytes.
+ *
+ * @tag:	Record tag (enum handoff_tag)
+ * @size:	Size of the data, not including padding
+ */
+struct handoff_rec {
+	u32 tag;
+	u32 size;
+};
+
+/**
+ * struct handoff_dram - DRAM set up by SPL
+ *
+ * @ram_size:	Value for gd->ram_size
+ * @bank:	Values for gd->bd->bi_dram[]
+ */
+struct handoff_dram {
+	u64 ram_size;
+#ifdef CONFIG_NR_DRAM_BANKS
+	struct {
+		u64 start;
+		u64 size;
+	} bank[CONFIG_NR_DRAM_BANKS];
+#endif
+};
+
+/**
+ * struct handoff_clocks - Clock rates set up by SPL, in Hz
+ *
+ * @cpu_clk:	Value for gd->cpu_clk
+ * @bus_clk:	Value for gd->bus_clk
+ * @mem_clk:	Value for gd->mem_clk
+ */
+struct handoff_clocks {
+	u64 cpu_clk;
+	u64 bus_clk;
+	u64 mem_clk;
+};
+
+/**
+ * handoff_invalidate() - Mark a handoff area as not valid
+ *
+ * This stops an area left in memory by an earlier boot from being used. It
+ * is available in SPL even without SPL_HANDOFF.
+ *
+ * @addr:	Address of the area
+ */
+static inline void handoff_invalidate(ulong addr)
+{
+	struct handoff_hdr *hdr = map_sysmem(addr, sizeof(*hdr));
+
+	hdr->magic = 0;
+	unmap_sysmem(hdr);
+}
+
+#if CONFIG_IS_ENABLED(HANDOFF)
+/**
+ * handoff_new() - Set up an empty handoff area
+ *
+ * @addr:	Address of the area
+ * @size:	Size of the area in bytes
+ * @return 0 if OK, -ENOSPC if the area is too small
+ */
+int handoff_new(ulong addr, int size);
+
+/**
+ * handoff_add() - Add a record to the handoff area
+ *
+ * In SPL the area is set up at CONFIG_HANDOFF_ADDR if this has not been
+ * done yet, so this must only be called once the memory there is usable.
+ * If a record with the same tag and size exists already, it is returned.
+ *
+ * @tag:	Record tag (enum handoff_tag)
+ * @size:	Size of the record data in bytes
+ * @return pointer to the zeroed record data, or NULL if there is no room
+ */
+void *handoff_add(uint tag, int size);
+
+/**
+ * handoff_find() - Find a record in the handoff area
+ *
+ * @tag:	Record tag (enum handoff_tag)
+ * @size:	Expected size of the record data in bytes
+ * @return pointer to the record data, or NULL if there is no record with
+ *	this tag and size
+ */
+void *handoff_find(uint tag, int size);
+
+/**
+ * handoff_finish() - Finish the handoff area before leaving SPL
+ *
+ * This calculates the checksum which U-Boot proper checks.
+ *
+ * @return 0 if OK, -ENOENT if there is no handoff area
+ */
+int handoff_finish(void);
+
+/**
+ * handoff_check() - Check for a valid handoff area and start using it
+ *
+ * The size is checked before anything is read from the area.
+ *
+ * @addr:	Address of the area
+ * @size:	Size of the area in bytes
+ * @return 0 if OK, -ENOENT if there is no handoff area, -EPROTO if its
+ *	version is not supported, -EIO if its checksum is wrong
+ */
+int handoff_check(ulong addr, int size);
+#else
+static inline void *handoff_add(uint tag, int size)
+{
+	return NULL;
+}
+
+static inline void *handoff_find(uint tag, int size)
+{
+	return NULL;
+}
+
+static inline int handoff_finish(void)
+{
+	return -ENOENT;
+}
+
+static inline int handoff_check(ulong addr, int size)
+{
+	return -ENOENT;
+}
+#endif
+
+#endif
@@ -305,6 +305,77 @@ int fdt_next_region(const void *fdt,
  */
 int fdt_add_alias_regions(const void *fdt, struct fdt_region *region, int count,
 			  int max_regions, struct fdt_region_state *info);
+
+/**
+ * struct fdt_overlay_target - A node in the base tree targeted by an overlay
+ *
+ * @phandle:	Phandle of the node
+ * @path:	Offset of the node's path in the index strings
+ */
+struct fdt_overlay_target {
+	uint32_t phandle;
+	uint32_t path;
+};
+
+/**
+ * struct fdt_overlay_index - Lookups kept across overlays applied to a tree
+ *
+ * Applying an overlay scans the whole base tree to find its highest phandle
+ * and again to find each fragment target by phandle. When several overlays
+ * are applied to the same tree the same scans are repeated for each one. An
+ * index records the results so that they are only done once per tree.
+ *
+ * An index must only be used with the tree it was first used with, and
+ * that tree must only be changed by fdt_overlay_apply_index() while it is in
+ * use. The tree may be moved or resized, since the index holds phandles and
+ * paths rather than offsets. A recorded target is only used if the node at
+ * its path still has the same phandle.
+ *
+ * @max_phandle:	Highest phandle in the tree, or 0 if not known yet
+ * @targets:		Targets found so far
+ * @count:		Number of targets in @targets
+ * @size:		Maximum number of targets in @targets
+ * @strings:		Paths of the targets
+ * @strings_used:	Number of bytes used in @strings
+ * @strings_size:	Size of @strings in bytes
+ */
+struct fdt_overlay_index {
+	uint32_t max_phandle;
+	struct fdt_overlay_target *targets;
+	int count;
+	int size;
+	char *strings;
+	int strings_used;
+	int strings_size;
+};
+
+/**
+ * fdt_overlay_index_init() - Set up an empty overlay index
+ *
+ * If the buffer fills up, further targets are looked up in the tree as
+ * normal.
+ *
+ * @idx:	Index to set up
+ * @buf:	Buffer to hold the index, aligned to 4 bytes
+ * @size:	Size of @buf in bytes
+ */
+void fdt_overlay_index_init(struct fdt_overlay_index *idx, void *buf,
+			    int size);
+
+/**
+ * fdt_overlay_apply_index() - Apply an overlay using an index
+ *
+ * This is the same as fdt_overlay_apply() but uses and updates an index of
+ * lookups in the base tree, which can be reused for the next overlay. If
+ * this fails, the index is emptied along with the base tree.
+ *
+ * @fdt:	Base device tree
+ * @fdto:	Device tree overlay, which is damaged by this function
+ * @idx:	Index for @fdt
+ * @return 0 on success, or -FDT_ERR_... on error
+ */
+int fdt_overlay_apply_index(void *fdt, void *fdto,
+			    struct fdt_overlay_index *idx);
 #endif /* SWIG */
 
 extern struct fdt_header *working_fdt;  /* Pointer to the working fdt */
@@ -10,6 +10,10 @@
  * Copyright (C) 2001 Peter Bergner, IBM Corp.
  */
 
+/*
+ * Number of regions which fit without allocating memory. Region arrays
+ * grow on the heap when more are needed.
+ */
 #define MAX_LMB_REGIONS 8
 
 struct lmb_property {
@@ -17,10 +21,20 @@ struct lmb_property {
 	phys_size_t size;
 };
 
+/*
+ * Regions are sorted by base address. They neither overlap nor touch each
+ * other, overlapping or adjacent regions are merged when added.
+ *
+ * The regions are held in @initial until it is full, then in @heap. Once
+ * an array has moved to the heap, the struct lmb owns it: it must be freed
+ * with lmb_release() and the struct must not be copied.
+ */
 struct lmb_region {
 	unsigned long cnt;
+	unsigned long max;
 	phys_size_t size;
-	struct lmb_property region[MAX_LMB_REGIONS+1];
+	struct lmb_property *heap;
+	struct lmb_property initial[MAX_LMB_REGIONS];
 };
 
 struct lmb {
@@ -31,6 +45,7 @@ struct lmb {
 extern struct lmb lmb;
 
 extern void lmb_init(struct lmb *lmb);
+extern void lmb_release(struct lmb *lmb);
 extern long lmb_add(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 extern long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 extern phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align);
@@ -43,10 +58,15 @@ extern long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 
 extern void lmb_dump_all(struct lmb *lmb);
 
+static inline struct lmb_property *lmb_regions(struct lmb_region *type)
+{
+	return type->heap ? type->heap : type->initial;
+}
+
 static inline phys_size_t
 lmb_size_bytes(struct lmb_region *type, unsigned long region_nr)
 {
-	return type->region[region_nr].size;
+	return lmb_regions(type)[region_nr].size;
 }
 
 void board_lmb_reserve(struct lmb *lmb);
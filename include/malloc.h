@@ -876,10 +876,12 @@ extern Void_t*     sbrk();
 #define malloc malloc_simple
 #define realloc realloc_simple
 #define memalign memalign_simple
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_FREE)
+#define free free_simple
+#else
 static inline void free(void *ptr) {}
+#endif
 void *calloc(size_t nmemb, size_t size);
-void *memalign_simple(size_t alignment, size_t bytes);
-void *realloc_simple(void *ptr, size_t size);
 #else
 
 # ifdef USE_DL_PREFIX
@@ -909,10 +911,53 @@ void *realloc_simple(void *ptr, size_t size);
 /* Set up pre-relocation malloc() ready for use */
 int initf_malloc(void);
 
+/* Number of request size classes counted with SYS_MALLOC_STATS */
+#define MALLOC_STATS_CLASSES	16
+
+/**
+ * struct malloc_info - Usage information for the malloc() pool
+ *
+ * @count:	Number of malloc() calls for each size class, if
+ *		SYS_MALLOC_STATS is enabled. Class 0 counts requests of up to
+ *		16 bytes, class n those up to 16 << n bytes and the last class
+ *		all larger ones
+ * @pool:	Size of the pool in bytes
+ * @in_use:	Number of bytes allocated, including overhead
+ * @peak:	Highest number of bytes of the pool taken into use so far
+ * @free:	Number of free bytes, including those held by the cache
+ * @free_blocks: Number of free blocks, not counting the cache
+ * @largest:	Size of the largest free block
+ * @cached:	Number of bytes in freed small blocks kept for reuse
+ */
+struct malloc_info {
+	unsigned long count[MALLOC_STATS_CLASSES];
+	unsigned long pool;
+	unsigned long in_use;
+	unsigned long peak;
+	unsigned long free;
+	unsigned long free_blocks;
+	unsigned long largest;
+	unsigned long cached;
+};
+
+/**
+ * malloc_get_info() - Get usage information for the malloc() pool
+ *
+ * This describes the pool set up by mem_malloc_init(), not the one used
+ * before relocation.
+ *
+ * @info:	Returns the information
+ */
+void malloc_get_info(struct malloc_info *info);
+
 /* Public routines */
 
 /* Simple versions which can be used when space is tight */
 void *malloc_simple(size_t size);
+void *memalign_simple(size_t alignment, size_t bytes);
+void *realloc_simple(void *ptr, size_t size);
+/* This does nothing unless SYS_MALLOC_F_FREE is enabled */
+void free_simple(void *ptr);
 
 #pragma GCC visibility push(hidden)
 # if __STD_C
@@ -9,8 +9,92 @@
 #ifndef _OF_LIVE_H
 #define _OF_LIVE_H
 
+#include <linux/libfdt_env.h>
+
 struct device_node;
 
+#define OF_LIVE_PACK_MAGIC	0x4f464c56	/* "OFLV" */
+#define OF_LIVE_PACK_VERSION	1
+
+/* Index value for no node or property */
+#define OF_LIVE_PACK_NONE	0xffffffff
+
+/* Set in a reference to a string in the pack rather than the flat tree */
+#define OF_LIVE_PACK_STR	0x80000000
+
+/**
+ * struct of_live_pack - Header of a packed live tree
+ *
+ * A pack holds a live tree in a form which can be turned into struct
+ * device_node and struct property with a single pass and no parsing of the
+ * flat tree. It is built from a flat tree by the of_live_pack host tool and
+ * only valid with that tree, since names and values are not copied.
+ *
+ * The header is followed by an array of struct of_live_pack_node in the
+ * order the nodes appear in the flat tree (so the root node is first), then
+ * an array of struct of_live_pack_prop, then a table of strings which are
+ * not in the flat tree, such as full node paths. All fields are big-endian
+ * and sized the same on all targets.
+ *
+ * A reference is an offset from the start of the flat tree or, if it has
+ * OF_LIVE_PACK_STR set, an offset into the string table of the pack.
+ *
+ * @magic: OF_LIVE_PACK_MAGIC
+ * @version: OF_LIVE_PACK_VERSION
+ * @totalsize: Total size of the pack in bytes
+ * @fdt_size: Size of the flat tree that the pack was built from
+ * @fdt_crc: crc32 of that flat tree
+ * @node_count: Number of nodes
+ * @prop_count: Number of properties
+ * @off_strings: Offset of the string table from the start of the pack
+ */
+struct of_live_pack {
+	fdt32_t magic;
+	fdt32_t version;
+	fdt32_t totalsize;
+	fdt32_t fdt_size;
+	fdt32_t fdt_crc;
+	fdt32_t node_count;
+	fdt32_t prop_count;
+	fdt32_t off_strings;
+};
+
+/**
+ * struct of_live_pack_node - A node in a packed live tree
+ *
+ * This follows struct device_node. Names are references and nodes and
+ * properties are indexes into their arrays, or OF_LIVE_PACK_NONE.
+ */
+struct of_live_pack_node {
+	fdt32_t name;
+	fdt32_t type;
+	fdt32_t phandle;
+	fdt32_t full_name;
+	fdt32_t properties;
+	fdt32_t parent;
+	fdt32_t child;
+	fdt32_t sibling;
+};
+
+/**
+ * struct of_live_pack_prop - A property in a packed live tree
+ *
+ * This follows struct property. The name and value are references and
+ * @next is the index of the next property of the node, or
+ * OF_LIVE_PACK_NONE.
+ */
+struct of_live_pack_prop {
+	fdt32_t name;
+	fdt32_t length;
+	fdt32_t value;
+	fdt32_t next;
+};
+
+#ifndef USE_HOSTCC
+/* Packed live tree for the control FDT, built with CONFIG_OF_LIVE_PACK */
+extern u8 __of_live_pack_begin[];
+#endif
+
 /**
  * of_live_build() - build a live (hierarchical) tree from a flat DT
  *
@@ -20,4 +104,48 @@ struct device_node;
  */
 int of_live_build(const void *fdt_blob, struct device_node **rootp);
 
+/**
+ * of_live_pack_fdt() - Write a packed live tree for a flat DT
+ *
+ * This is used by the of_live_pack host tool at build time, but also
+ * builds for the target.
+ *
+ * @fdt_blob: Flat tree to pack
+ * @buf: Buffer to write the pack to, 4-byte aligned, or NULL to just work
+ *	out the size
+ * @size: Size of @buf in bytes
+ * @return size of the pack in bytes, -FDT_ERR_NOSPACE if @buf is too small,
+ *	other -FDT_ERR_... value if @fdt_blob is not valid
+ */
+int of_live_pack_fdt(const void *fdt_blob, void *buf, int size);
+
+/**
+ * of_live_unpack() - Create a live tree from a packed one
+ *
+ * The whole tree is in a single allocation, starting with the root node.
+ * Names and values point into @fdt_blob or @pack, which must be kept.
+ *
+ * @pack: Packed live tree
+ * @fdt_blob: Flat tree that @pack was built from
+ * @rootp: Returns the live tree that was created
+ * @return 0 if OK, -ENOENT if @pack is not a valid pack, -ESTALE if it was
+ *	built from a different flat tree, -ENOMEM if out of memory
+ */
+int of_live_unpack(const void *pack, const void *fdt_blob,
+		   struct device_node **rootp);
+
+/**
+ * of_live_adopt() - Set up the live tree from a packed one
+ *
+ * This does the same as of_live_build(), but uses of_live_unpack() to create
+ * the tree instead of parsing the flat tree.
+ *
+ * @pack: Packed live tree
+ * @fdt_blob: Flat tree that @pack was built from
+ * @rootp: Returns the live tree that was created
+ * @return 0 if OK, -ve on error (see of_live_unpack())
+ */
+int of_live_adopt(const void *pack, const void *fdt_blob,
+		  struct device_node **rootp);
+
 #endif
@@ -186,6 +186,13 @@ int submit_control_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 int submit_int_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 			int transfer_len, int interval);
 
+#ifdef CONFIG_DM_USB
+int queue_bulk_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
+		   int transfer_len);
+int complete_bulk_msg(struct usb_device *dev, unsigned long pipe);
+int cancel_bulk_msg(struct usb_device *dev, unsigned long pipe);
+#endif
+
 #if defined CONFIG_USB_EHCI_HCD || defined CONFIG_USB_MUSB_HOST \
 	|| defined(CONFIG_DM_USB)
 struct int_queue *create_int_queue(struct usb_device *dev, unsigned long pipe,
@@ -261,6 +268,11 @@ int usb_control_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, unsigned short size, int timeout);
 int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, int len, int *actual_length, int timeout);
+int usb_bulk_msg_queue(struct usb_device *dev, unsigned int pipe,
+			void *data, int len);
+int usb_bulk_msg_complete(struct usb_device *dev, unsigned int pipe,
+			int *actual_length);
+int usb_bulk_msg_cancel(struct usb_device *dev, unsigned int pipe);
 int usb_submit_int_msg(struct usb_device *dev, unsigned long pipe,
 			void *buffer, int transfer_len, int interval);
 int usb_disable_asynch(int disable);
@@ -699,6 +711,40 @@ struct dm_usb_ops {
 	 */
 	int (*bulk)(struct udevice *bus, struct usb_device *udev,
 		    unsigned long pipe, void *buffer, int length);
+	/**
+	 * queue_bulk() - Start a bulk message without waiting for it
+	 *
+	 * Several messages may be queued on the same or on different
+	 * endpoints. Messages on an endpoint are completed in order by
+	 * complete_bulk(). @buffer must not be touched until then.
+	 *
+	 * Parameters are as above.
+	 *
+	 * @return 0 if OK, -EBUSY if no more messages can be queued on the
+	 *	endpoint until one is completed, other -ve on error
+	 */
+	int (*queue_bulk)(struct udevice *bus, struct usb_device *udev,
+			  unsigned long pipe, void *buffer, int length);
+	/**
+	 * complete_bulk() - Wait for the oldest bulk message queued on a pipe
+	 *
+	 * The result of the message is left in udev->status and
+	 * udev->act_len.
+	 *
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*complete_bulk)(struct udevice *bus, struct usb_device *udev,
+			     unsigned long pipe);
+	/**
+	 * cancel_bulk() - Cancel all bulk messages queued on a pipe
+	 *
+	 * The messages need not be completed with complete_bulk() and their
+	 * buffers may be reused.
+	 *
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*cancel_bulk)(struct udevice *bus, struct usb_device *udev,
+			   unsigned long pipe);
 	/**
 	 * interrupt() - Send an interrupt message
 	 *
@@ -25,9 +25,49 @@ static efi_uintn_t efi_tpl = TPL_APPLICATION;
 /* This list contains all the EFI objects our payload has access to */
 LIST_HEAD(efi_obj_list);
 
+#define EFI_INDEX_HASH_SIZE	32
+
+/* Objects hashed by handle, to validate handles without a list walk */
+static struct hlist_head efi_obj_hash[EFI_INDEX_HASH_SIZE];
+
+/*
+ * Index of the installed protocols. There is one entry per protocol GUID
+ * ever installed, holding the list of all handlers for that GUID.
+ */
+struct efi_protocol_entry {
+	struct hlist_node link;
+	efi_guid_t guid;
+	struct list_head handlers;
+};
+
+static struct hlist_head efi_protocol_index[EFI_INDEX_HASH_SIZE];
+
+static struct hlist_head *efi_obj_bucket(const efi_handle_t handle)
+{
+	return &efi_obj_hash[((uintptr_t)handle >> 4) % EFI_INDEX_HASH_SIZE];
+}
+
+static struct hlist_head *efi_protocol_bucket(const efi_guid_t *protocol)
+{
+	unsigned int i, hash = 0;
+
+	for (i = 0; i < sizeof(protocol->b); ++i)
+		hash = hash * 31 + protocol->b[i];
+
+	return &efi_protocol_index[hash % EFI_INDEX_HASH_SIZE];
+}
+
 /* List of all events */
 LIST_HEAD(efi_events);
 
+/* Events whose notification function is waiting for the TPL to drop */
+static LIST_HEAD(efi_event_queue);
+
+/* Armed timer events, a binary min-heap ordered by trigger_next */
+static struct efi_event **efi_timers;
+static int efi_timer_count;
+static int efi_timer_size;
+
 /*
  * If we're running on nasty systems (32bit ARM booting into non-EFI Linux)
  * we need to do trickery with caches. Since we don't want to break the EFI
@@ -178,10 +218,14 @@ const char *__efi_nesting_dec(void)
 static void efi_queue_event(struct efi_event *event, bool check_tpl)
 {
 	if (event->notify_function) {
-		event->is_queued = true;
+		if (!event->is_queued) {
+			event->is_queued = true;
+			list_add_tail(&event->queue_link, &efi_event_queue);
+		}
 		/* Check TPL */
 		if (check_tpl && efi_tpl >= event->notify_tpl)
 			return;
+		list_del_init(&event->queue_link);
 		EFI_CALL_VOID(event->notify_function(event,
 						     event->notify_context));
 	}
@@ -216,8 +260,11 @@ void efi_signal_event(struct efi_event *event, bool check_tpl)
 				continue;
 			evt->is_signaled = true;
 			if (evt->type & EVT_NOTIFY_SIGNAL &&
-			    evt->notify_function)
+			    evt->notify_function && !evt->is_queued) {
 				evt->is_queued = true;
+				list_add_tail(&evt->queue_link,
+					      &efi_event_queue);
+			}
 		}
 		list_for_each_entry(evt, &efi_events, link) {
 			if (!evt->group || guidcmp(evt->group, event->group))
@@ -418,6 +465,7 @@ void efi_add_handle(struct efi_object *obj)
 	INIT_LIST_HEAD(&obj->protocols);
 	obj->handle = obj;
 	list_add_tail(&obj->link, &efi_obj_list);
+	hlist_add_head(&obj->hash_link, efi_obj_bucket(obj->handle));
 }
 
 /*
@@ -441,6 +489,53 @@ efi_status_t efi_create_handle(efi_handle_t *handle)
 	return r;
 }
 
+/*
+ * Find the protocol index entry for a GUID.
+ *
+ * @protocol	GUID of the protocol
+ * @return	index entry or NULL if the protocol was never installed
+ */
+static struct efi_protocol_entry *efi_find_protocol_entry(
+			const efi_guid_t *protocol)
+{
+	struct efi_protocol_entry *entry;
+	struct hlist_node *node;
+
+	hlist_for_each_entry(entry, node, efi_protocol_bucket(protocol), link) {
+		if (!guidcmp(&entry->guid, protocol))
+			return entry;
+	}
+
+	return NULL;
+}
+
+/*
+ * Iterate over all installations of a protocol.
+ *
+ * The handlers are returned in the order in which the protocol was
+ * installed on the handles. Only the handles implementing the protocol are
+ * visited.
+ *
+ * @protocol	GUID of the protocol
+ * @prev	handler returned by the previous call or NULL to start
+ * @return	next handler or NULL if there are no more
+ */
+struct efi_handler *efi_next_handler(const efi_guid_t *protocol,
+				     struct efi_handler *prev)
+{
+	struct efi_protocol_entry *entry;
+	struct list_head *next;
+
+	entry = efi_find_protocol_entry(protocol);
+	if (!entry)
+		return NULL;
+	next = prev ? prev->index_link.next : entry->handlers.next;
+	if (next == &entry->handlers)
+		return NULL;
+
+	return list_entry(next, struct efi_handler, index_link);
+}
+
 /*
  * Find a protocol on a handle.
  *
@@ -495,6 +590,7 @@ efi_status_t efi_remove_protocol(const efi_handle_t handle,
 	if (guidcmp(handler->guid, protocol))
 		return EFI_INVALID_PARAMETER;
 	list_del(&handler->link);
+	list_del(&handler->index_link);
 	free(handler);
 	return EFI_SUCCESS;
 }
@@ -525,6 +621,23 @@ efi_status_t efi_remove_all_protocols(const efi_handle_t handle)
 	return EFI_SUCCESS;
 }
 
+/*
+ * Remove handle from the object list.
+ *
+ * All protocols are removed from the handle. The memory of the object is not
+ * freed.
+ *
+ * @obj	object to remove
+ */
+void efi_remove_handle(struct efi_object *obj)
+{
+	if (!obj)
+		return;
+	efi_remove_all_protocols(obj->handle);
+	list_del(&obj->link);
+	hlist_del(&obj->hash_link);
+}
+
 /*
  * Delete handle.
  *
@@ -534,8 +647,7 @@ void efi_delete_handle(struct efi_object *obj)
 {
 	if (!obj)
 		return;
-	efi_remove_all_protocols(obj->handle);
-	list_del(&obj->link);
+	efi_remove_handle(obj);
 	free(obj);
 }
 
@@ -602,6 +714,8 @@ efi_status_t efi_create_event(uint32_t type, efi_uintn_t notify_tpl,
 	evt->group = group;
 	/* Disable timers on bootup */
 	evt->trigger_next = -1ULL;
+	evt->timer_index = -1;
+	INIT_LIST_HEAD(&evt->queue_link);
 	evt->is_queued = false;
 	evt->is_signaled = false;
 	list_add_tail(&evt->link, &efi_events);
@@ -666,32 +780,148 @@ static efi_status_t EFIAPI efi_create_event_ext(
 					 notify_context, NULL, event));
 }
 
+/*
+ * Place a timer event at a position of the timer heap and record it there.
+ *
+ * @index	position in the heap
+ * @evt		timer event
+ */
+static void efi_timer_place(int index, struct efi_event *evt)
+{
+	efi_timers[index] = evt;
+	evt->timer_index = index;
+}
+
+/*
+ * Move a timer event towards the root of the heap until its parent is not
+ * due later.
+ *
+ * @index	position of the event in the heap
+ */
+static void efi_timer_sift_up(int index)
+{
+	struct efi_event *evt = efi_timers[index];
+
+	while (index) {
+		int parent = (index - 1) / 2;
+
+		if (efi_timers[parent]->trigger_next <= evt->trigger_next)
+			break;
+		efi_timer_place(index, efi_timers[parent]);
+		index = parent;
+	}
+	efi_timer_place(index, evt);
+}
+
+/*
+ * Move a timer event towards the leaves of the heap until no child is due
+ * earlier.
+ *
+ * @index	position of the event in the heap
+ */
+static void efi_timer_sift_down(int index)
+{
+	struct efi_event *evt = efi_timers[index];
+
+	for (;;) {
+		int child = 2 * index + 1;
+
+		if (child >= efi_timer_count)
+			break;
+		if (child + 1 < efi_timer_count &&
+		    efi_timers[child + 1]->trigger_next <
+		    efi_timers[child]->trigger_next)
+			++child;
+		if (evt->trigger_next <= efi_timers[child]->trigger_next)
+			break;
+		efi_timer_place(index, efi_timers[child]);
+		index = child;
+	}
+	efi_timer_place(index, evt);
+}
+
+/*
+ * Add a timer event to the queue of armed timers.
+ *
+ * @evt		timer event, not armed yet
+ * @return	status code
+ */
+static efi_status_t efi_timer_arm(struct efi_event *evt)
+{
+	if (efi_timer_count == efi_timer_size) {
+		int size = efi_timer_size ? 2 * efi_timer_size : 16;
+		struct efi_event **timers;
+
+		timers = realloc(efi_timers, size * sizeof(*timers));
+		if (!timers)
+			return EFI_OUT_OF_RESOURCES;
+		efi_timers = timers;
+		efi_timer_size = size;
+	}
+	efi_timers[efi_timer_count] = evt;
+	efi_timer_sift_up(efi_timer_count++);
+
+	return EFI_SUCCESS;
+}
+
+/*
+ * Remove a timer event from the queue of armed timers.
+ *
+ * @evt		timer event, armed or not
+ */
+static void efi_timer_disarm(struct efi_event *evt)
+{
+	int index = evt->timer_index;
+	struct efi_event *last;
+
+	if (index < 0)
+		return;
+	evt->timer_index = -1;
+	last = efi_timers[--efi_timer_count];
+	if (last == evt)
+		return;
+	efi_timers[index] = last;
+	efi_timer_sift_up(index);
+	efi_timer_sift_down(last->timer_index);
+}
+
 /*
  * Check if a timer event has occurred or a queued notification function should
  * be called.
  *
  * Our timers have to work without interrupts, so we check whenever keyboard
  * input or disk accesses happen if enough time elapsed for them to fire.
+ *
+ * Only the earliest armed timer has to be looked at to find out that nothing
+ * is due, and only events with a queued notification are visited.
  */
 void efi_timer_check(void)
 {
 	struct efi_event *evt;
-	u64 now = timer_get_us();
-
-	list_for_each_entry(evt, &efi_events, link) {
-		if (evt->is_queued)
-			efi_queue_event(evt, true);
-		if (!(evt->type & EVT_TIMER) || now < evt->trigger_next)
-			continue;
-		switch (evt->trigger_type) {
-		case EFI_TIMER_RELATIVE:
-			evt->trigger_type = EFI_TIMER_STOP;
-			break;
-		case EFI_TIMER_PERIODIC:
+	LIST_HEAD(queue);
+	u64 now;
+
+	/* Notifications queued again due to the TPL go back to the queue */
+	list_splice_init(&efi_event_queue, &queue);
+	while (!list_empty(&queue)) {
+		evt = list_first_entry(&queue, struct efi_event, queue_link);
+		list_del_init(&evt->queue_link);
+		evt->is_queued = false;
+		efi_queue_event(evt, true);
+	}
+
+	now = timer_get_us();
+	while (efi_timer_count && efi_timers[0]->trigger_next <= now) {
+		evt = efi_timers[0];
+		if (evt->trigger_type == EFI_TIMER_PERIODIC) {
+			/* Missed periods are coalesced into a single signal */
 			evt->trigger_next += evt->trigger_time;
-			break;
-		default:
-			continue;
+			if (evt->trigger_next <= now)
+				evt->trigger_next = now + 1;
+			efi_timer_sift_down(0);
+		} else {
+			evt->trigger_type = EFI_TIMER_STOP;
+			efi_timer_disarm(evt);
 		}
 		evt->is_signaled = false;
 		efi_signal_event(evt, true);
@@ -725,11 +955,18 @@ efi_status_t efi_set_timer(struct efi_event *event, enum efi_timer_delay type,
 
 	switch (type) {
 	case EFI_TIMER_STOP:
+		efi_timer_disarm(event);
 		event->trigger_next = -1ULL;
 		break;
 	case EFI_TIMER_PERIODIC:
 	case EFI_TIMER_RELATIVE:
+		efi_timer_disarm(event);
 		event->trigger_next = timer_get_us() + trigger_time;
+		if (efi_timer_arm(event) != EFI_SUCCESS) {
+			event->trigger_next = -1ULL;
+			event->trigger_type = EFI_TIMER_STOP;
+			return EFI_OUT_OF_RESOURCES;
+		}
 		break;
 	default:
 		return EFI_INVALID_PARAMETER;
@@ -854,6 +1091,8 @@ static efi_status_t EFIAPI efi_close_event(struct efi_event *event)
 	EFI_ENTRY("%p", event);
 	if (efi_is_event(event) != EFI_SUCCESS)
 		return EFI_EXIT(EFI_INVALID_PARAMETER);
+	efi_timer_disarm(event);
+	list_del(&event->queue_link);
 	list_del(&event->link);
 	free(event);
 	return EFI_EXIT(EFI_SUCCESS);
@@ -897,8 +1136,9 @@ static efi_status_t EFIAPI efi_check_event(struct efi_event *event)
 struct efi_object *efi_search_obj(const efi_handle_t handle)
 {
 	struct efi_object *efiobj;
+	struct hlist_node *node;
 
-	list_for_each_entry(efiobj, &efi_obj_list, link) {
+	hlist_for_each_entry(efiobj, node, efi_obj_bucket(handle), hash_link) {
 		if (efiobj->handle == handle)
 			return efiobj;
 	}
@@ -952,6 +1192,7 @@ efi_status_t efi_add_protocol(const efi_handle_t handle,
 			      const efi_guid_t *protocol,
 			      void *protocol_interface)
 {
+	struct efi_protocol_entry *entry;
 	struct efi_object *efiobj;
 	struct efi_handler *handler;
 	efi_status_t ret;
@@ -962,13 +1203,24 @@ efi_status_t efi_add_protocol(const efi_handle_t handle,
 	ret = efi_search_protocol(handle, protocol, NULL);
 	if (ret != EFI_NOT_FOUND)
 		return EFI_INVALID_PARAMETER;
+	entry = efi_find_protocol_entry(protocol);
+	if (!entry) {
+		entry = calloc(1, sizeof(struct efi_protocol_entry));
+		if (!entry)
+			return EFI_OUT_OF_RESOURCES;
+		memcpy(&entry->guid, protocol, sizeof(entry->guid));
+		INIT_LIST_HEAD(&entry->handlers);
+		hlist_add_head(&entry->link, efi_protocol_bucket(protocol));
+	}
 	handler = calloc(1, sizeof(struct efi_handler));
 	if (!handler)
 		return EFI_OUT_OF_RESOURCES;
+	handler->handle = efiobj->handle;
 	handler->guid = protocol;
 	handler->protocol_interface = protocol_interface;
 	INIT_LIST_HEAD(&handler->open_infos);
 	list_add_tail(&handler->link, &efiobj->protocols);
+	list_add_tail(&handler->index_link, &entry->handlers);
 	if (!guidcmp(&efi_guid_device_path, protocol))
 		EFI_PRINT("installed device path '%pD'\n", protocol_interface);
 	return EFI_SUCCESS;
@@ -1225,38 +1477,6 @@ static efi_status_t EFIAPI efi_register_protocol_notify(
 	return EFI_EXIT(EFI_OUT_OF_RESOURCES);
 }
 
-/*
- * Determine if an EFI handle implements a protocol.
- *
- * See the documentation of the LocateHandle service in the UEFI specification.
- *
- * @search_type		selection criterion
- * @protocol		GUID of the protocol
- * @search_key		registration key
- * @efiobj		handle
- * @return		0 if the handle implements the protocol
- */
-static int efi_search(enum efi_locate_search_type search_type,
-		      const efi_guid_t *protocol, void *search_key,
-		      struct efi_object *efiobj)
-{
-	efi_status_t ret;
-
-	switch (search_type) {
-	case ALL_HANDLES:
-		return 0;
-	case BY_REGISTER_NOTIFY:
-		/* TODO: RegisterProtocolNotify is not implemented yet */
-		return -1;
-	case BY_PROTOCOL:
-		ret = efi_search_protocol(efiobj->handle, protocol, NULL);
-		return (ret != EFI_SUCCESS);
-	default:
-		/* Invalid search type */
-		return -1;
-	}
-}
-
 /*
  * Locate handles implementing a protocol.
  *
@@ -1276,6 +1496,7 @@ static efi_status_t efi_locate_handle(
 			efi_uintn_t *buffer_size, efi_handle_t *buffer)
 {
 	struct efi_object *efiobj;
+	struct efi_handler *handler;
 	efi_uintn_t size = 0;
 
 	/* Check parameters */
@@ -1303,9 +1524,16 @@ static efi_status_t efi_locate_handle(
 	if (!buffer_size || (*buffer_size && !buffer))
 		return EFI_INVALID_PARAMETER;
 
-	/* Count how much space we need */
-	list_for_each_entry(efiobj, &efi_obj_list, link) {
-		if (!efi_search(search_type, protocol, search_key, efiobj))
+	/*
+	 * Count how much space we need. Handles implementing a protocol are
+	 * taken from the protocol index.
+	 */
+	if (search_type == BY_PROTOCOL) {
+		for (handler = efi_next_handler(protocol, NULL); handler;
+		     handler = efi_next_handler(protocol, handler))
+			size += sizeof(void *);
+	} else {
+		list_for_each_entry(efiobj, &efi_obj_list, link)
 			size += sizeof(void *);
 	}
 
@@ -1319,8 +1547,12 @@ static efi_status_t efi_locate_handle(
 		return EFI_NOT_FOUND;
 
 	/* Then fill the array */
-	list_for_each_entry(efiobj, &efi_obj_list, link) {
-		if (!efi_search(search_type, protocol, search_key, efiobj))
+	if (search_type == BY_PROTOCOL) {
+		for (handler = efi_next_handler(protocol, NULL); handler;
+		     handler = efi_next_handler(protocol, handler))
+			*buffer++ = handler->handle;
+	} else {
+		list_for_each_entry(efiobj, &efi_obj_list, link)
 			*buffer++ = efiobj->handle;
 	}
 
@@ -1770,7 +2002,7 @@ static efi_status_t EFIAPI efi_unload_image(efi_handle_t image_handle)
 	EFI_ENTRY("%p", image_handle);
 	efiobj = efi_search_obj(image_handle);
 	if (efiobj)
-		list_del(&efiobj->link);
+		efi_remove_handle(efiobj);
 
 	return EFI_EXIT(EFI_SUCCESS);
 }
@@ -1834,7 +2066,8 @@ static efi_status_t EFIAPI efi_exit_boot_services(efi_handle_t image_handle,
 		}
 	}
 
-	/* TODO Should persist EFI variables here */
+	/* Persist the EFI variables changed during boot */
+	efi_variables_commit();
 
 	board_quiesce_devices();
 
@@ -2158,25 +2391,17 @@ static efi_status_t EFIAPI efi_locate_protocol(const efi_guid_t *protocol,
 					       void *registration,
 					       void **protocol_interface)
 {
-	struct list_head *lhandle;
-	efi_status_t ret;
+	struct efi_handler *handler;
 
 	EFI_ENTRY("%pUl, %p, %p", protocol, registration, protocol_interface);
 
 	if (!protocol || !protocol_interface)
 		return EFI_EXIT(EFI_INVALID_PARAMETER);
 
-	list_for_each(lhandle, &efi_obj_list) {
-		struct efi_object *efiobj;
-		struct efi_handler *handler;
-
-		efiobj = list_entry(lhandle, struct efi_object, link);
-
-		ret = efi_search_protocol(efiobj->handle, protocol, &handler);
-		if (ret == EFI_SUCCESS) {
-			*protocol_interface = handler->protocol_interface;
-			return EFI_EXIT(EFI_SUCCESS);
-		}
+	handler = efi_next_handler(protocol, NULL);
+	if (handler) {
+		*protocol_interface = handler->protocol_interface;
+		return EFI_EXIT(EFI_SUCCESS);
 	}
 	*protocol_interface = NULL;
 
@@ -147,19 +147,13 @@ static struct efi_device_path *shorten_path(struct efi_device_path *dp)
 static struct efi_object *find_obj(struct efi_device_path *dp, bool short_path,
 				   struct efi_device_path **rem)
 {
-	struct efi_object *efiobj;
+	struct efi_handler *handler;
 	efi_uintn_t dp_size = efi_dp_instance_size(dp);
 
-	list_for_each_entry(efiobj, &efi_obj_list, link) {
-		struct efi_handler *handler;
-		struct efi_device_path *obj_dp;
-		efi_status_t ret;
-
-		ret = efi_search_protocol(efiobj->handle,
-					  &efi_guid_device_path, &handler);
-		if (ret != EFI_SUCCESS)
-			continue;
-		obj_dp = handler->protocol_interface;
+	for (handler = efi_next_handler(&efi_guid_device_path, NULL); handler;
+	     handler = efi_next_handler(&efi_guid_device_path, handler)) {
+		struct efi_object *efiobj = efi_search_obj(handler->handle);
+		struct efi_device_path *obj_dp = handler->protocol_interface;
 
 		do {
 			if (efi_dp_match(dp, obj_dp) == 0) {
@@ -28,6 +28,9 @@ struct file_handle {
 	loff_t offset;       /* current file position/cursor */
 	int isdir;
 
+	/* for reading a file, opened on first read: */
+	struct fs_file *file;
+
 	/* for reading a directory: */
 	struct fs_dir_stream *dirs;
 	struct fs_dirent *dent;
@@ -208,6 +211,7 @@ static efi_status_t EFIAPI efi_file_open(struct efi_file_handle *file,
 
 static efi_status_t file_close(struct file_handle *fh)
 {
+	fs_close(fh->file);
 	fs_closedir(fh->dirs);
 	free(fh);
 	return EFI_SUCCESS;
@@ -233,8 +237,11 @@ static efi_status_t file_read(struct file_handle *fh, u64 *buffer_size,
 {
 	loff_t actread;
 
-	if (fs_read(fh->path, (ulong)buffer, fh->offset,
-		    *buffer_size, &actread))
+	if (!fh->file &&
+	    fs_open(fh->fs->desc, fh->fs->part, fh->path, &fh->file))
+		return EFI_DEVICE_ERROR;
+
+	if (fs_pread(fh->file, buffer, fh->offset, *buffer_size, &actread))
 		return EFI_DEVICE_ERROR;
 
 	*buffer_size = actread;
@@ -252,6 +259,8 @@ static efi_status_t dir_read(struct file_handle *fh, u64 *buffer_size,
 
 	if (!fh->dirs) {
 		assert(fh->offset == 0);
+		if (set_blk_dev(fh))
+			return EFI_DEVICE_ERROR;
 		fh->dirs = fs_opendir(fh->path);
 		if (!fh->dirs)
 			return EFI_DEVICE_ERROR;
@@ -329,11 +338,6 @@ static efi_status_t EFIAPI efi_file_read(struct efi_file_handle *file,
 		goto error;
 	}
 
-	if (set_blk_dev(fh)) {
-		ret = EFI_DEVICE_ERROR;
-		goto error;
-	}
-
 	bs = *buffer_size;
 	if (fh->isdir)
 		ret = dir_read(fh, &bs, buffer);
@@ -76,17 +76,11 @@ efi_status_t efi_print_image_info(struct efi_loaded_image *image, void *pc)
  */
 void efi_print_image_infos(void *pc)
 {
-	struct efi_object *efiobj;
 	struct efi_handler *handler;
 
-	list_for_each_entry(efiobj, &efi_obj_list, link) {
-		list_for_each_entry(handler, &efiobj->protocols, link) {
-			if (!guidcmp(handler->guid, &efi_guid_loaded_image)) {
-				efi_print_image_info(
-					handler->protocol_interface, pc);
-			}
-		}
-	}
+	for (handler = efi_next_handler(&efi_guid_loaded_image, NULL); handler;
+	     handler = efi_next_handler(&efi_guid_loaded_image, handler))
+		efi_print_image_info(handler->protocol_interface, pc);
 }
 
 static efi_status_t efi_loader_relocate(const IMAGE_BASE_RELOCATION *rel,
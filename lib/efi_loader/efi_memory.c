@@ -11,33 +11,35 @@
 #include <malloc.h>
 #include <watchdog.h>
 #include <asm/global_data.h>
-#include <linux/list_sort.h>
+#include <linux/rbtree_augmented.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
 struct efi_mem_list {
-	struct list_head link;
+	struct rb_node node;
 	struct efi_mem_desc desc;
+	/* largest free region in this subtree, in pages */
+	u64 max_free;
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
-
-/* This list contains all memory map items */
-LIST_HEAD(efi_mem);
+/*
+ * This tree contains all memory map items, keyed by physical start address.
+ * The regions never overlap, so an in-order walk returns them sorted by
+ * both start and end address.
+ */
+static struct rb_root efi_mem = RB_ROOT;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
 #endif
 
 /*
- * U-Boot services each EFI AllocatePool request as a separate
- * (multiple) page allocation.  We have to track the number of pages
- * to be able to free the correct amount later.
- * EFI requires 8 byte alignment for pool allocations, so we can
- * prepend each allocation with an 64 bit header tracking the
- * allocation size, and hand out the remainder to the caller.
+ * Every pool allocation is prepended with a header of ARCH_DMA_MINALIGN
+ * bytes, which satisfies the 8 byte alignment EFI requires for pool
+ * allocations. Large requests are serviced by a (multiple) page allocation
+ * and the header tracks the number of pages to be able to free the correct
+ * amount later. Small requests are carved from a pool page, see below, and
+ * have num_pages set to 0.
  */
 struct efi_pool_allocation {
 	u64 num_pages;
@@ -45,113 +47,176 @@ struct efi_pool_allocation {
 };
 
 /*
- * Sorts the memory list from highest address to lowest address
- *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
+ * Small pool allocations are rounded up to one of a few slot sizes and
+ * handed out from single pages holding slots of that size. Each page only
+ * holds slots of one memory type, so that the memory map stays accurate.
+ * Pages with free slots are kept on a list per slot size and are returned
+ * to the page allocator when their last slot is freed.
  */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+#define EFI_POOL_SLOT_MIN	(2 * ARCH_DMA_MINALIGN)
+#define EFI_POOL_CLASSES	4
+
+struct efi_pool_page {
+	struct list_head link;
+	void *free;		/* first free slot, NULL if the page is full */
+	int memory_type;
+	u16 slot_size;
+	u8 class;
+	u16 used;		/* number of slots in use */
+} __aligned(ARCH_DMA_MINALIGN);
+
+static struct list_head efi_pool_pages[EFI_POOL_CLASSES] = {
+	LIST_HEAD_INIT(efi_pool_pages[0]),
+	LIST_HEAD_INIT(efi_pool_pages[1]),
+	LIST_HEAD_INIT(efi_pool_pages[2]),
+	LIST_HEAD_INIT(efi_pool_pages[3]),
+};
+
+static inline u64 efi_mem_end(struct efi_mem_list *mem)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
+	return mem->desc.physical_start +
+	       (mem->desc.num_pages << EFI_PAGE_SHIFT);
+}
 
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+static inline struct efi_mem_list *efi_mem_entry(struct rb_node *node)
+{
+	return node ? rb_entry(node, struct efi_mem_list, node) : NULL;
+}
+
+static inline u64 efi_mem_compute_max_free(struct efi_mem_list *mem)
+{
+	u64 pages = 0;
+
+	if (mem->desc.type == EFI_CONVENTIONAL_MEMORY)
+		pages = mem->desc.num_pages;
+	if (mem->node.rb_left)
+		pages = max(pages, efi_mem_entry(mem->node.rb_left)->max_free);
+	if (mem->node.rb_right)
+		pages = max(pages, efi_mem_entry(mem->node.rb_right)->max_free);
+
+	return pages;
+}
+
+RB_DECLARE_CALLBACKS(static, efi_mem_cb, struct efi_mem_list, node, u64,
+		     max_free, efi_mem_compute_max_free)
+
+/* Update the tree after a region was resized or changed type in place */
+static void efi_mem_update(struct efi_mem_list *mem)
+{
+	efi_mem_cb_propagate(&mem->node, NULL);
+}
+
+static void efi_mem_remove(struct efi_mem_list *mem)
+{
+	rb_erase_augmented(&mem->node, &efi_mem, &efi_mem_cb);
+	free(mem);
 }
 
-static void efi_mem_sort(void)
+static struct efi_mem_list *efi_mem_insert(struct efi_mem_desc *desc)
 {
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
+	struct rb_node **link = &efi_mem.rb_node, *parent = NULL;
+	struct efi_mem_list *mem, *new;
+
+	new = calloc(1, sizeof(*new));
+	if (!new)
+		return NULL;
+	new->desc = *desc;
+	new->max_free = efi_mem_compute_max_free(new);
+
+	while (*link) {
+		parent = *link;
+		mem = efi_mem_entry(parent);
+		if (mem->max_free < new->max_free)
+			mem->max_free = new->max_free;
+		if (desc->physical_start < mem->desc.physical_start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&new->node, parent, link);
+	rb_insert_augmented(&new->node, &efi_mem, &efi_mem_cb);
+
+	return new;
+}
+
+/* Return the lowest region ending above addr, if any */
+static struct efi_mem_list *efi_mem_search(u64 addr)
+{
+	struct rb_node *node = efi_mem.rb_node;
+	struct efi_mem_list *found = NULL;
+
+	while (node) {
+		struct efi_mem_list *mem = efi_mem_entry(node);
+
+		if (efi_mem_end(mem) <= addr) {
+			node = node->rb_right;
+		} else {
+			found = mem;
+			node = node->rb_left;
+		}
+	}
+
+	return found;
+}
+
+static bool efi_mem_mergeable(struct efi_mem_list *mem,
+			      struct efi_mem_desc *desc)
+{
+	return mem && mem->desc.type == desc->type &&
+	       mem->desc.attribute == desc->attribute;
 }
 
 /*
- * Unmaps all memory occupied by the carve_desc region from the
- * list entry pointed to by map.
- *
- * Returns EFI_CARVE_NO_OVERLAP if the regions don't overlap.
- * Returns EFI_CARVE_OVERLAPS_NONRAM if the carve and map overlap,
- *    and the map contains anything but free ram.
- *    (only when overlap_only_ram is true)
- * Returns EFI_CARVE_LOOP_AGAIN if the mapping list should be traversed
- *    again, as it has been altered
- * Returns the number of overlapping pages. The pages are removed from
- *     the mapping list.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to readd the already carved out pages to the mapping.
+ * Unmaps all memory in [start, end) from the map, splitting regions which
+ * only partially overlap. Returns -ENOMEM, with the map unchanged, if a
+ * region cannot be split.
  */
-static int efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
+static int efi_mem_carve_out(struct efi_mem_list *mem, u64 start, u64 end)
 {
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
+	struct efi_mem_list *next;
+
+	for (; mem && mem->desc.physical_start < end; mem = next) {
+		u64 map_start = mem->desc.physical_start;
+		u64 map_end = efi_mem_end(mem);
+
+		next = efi_mem_entry(rb_next(&mem->node));
+
+		if (map_start < start && map_end > end) {
+			/* [ mem | carve | tail ] */
+			struct efi_mem_desc tail = mem->desc;
+
+			tail.physical_start = end;
+			tail.virtual_start = end;
+			tail.num_pages = (map_end - end) >> EFI_PAGE_SHIFT;
+			if (!efi_mem_insert(&tail))
+				return -ENOMEM;
+			mem->desc.num_pages = (start - map_start) >>
+					      EFI_PAGE_SHIFT;
+			efi_mem_update(mem);
+			break;
+		} else if (map_start < start) {
+			mem->desc.num_pages = (start - map_start) >>
+					      EFI_PAGE_SHIFT;
+			efi_mem_update(mem);
+		} else if (map_end > end) {
+			mem->desc.physical_start = end;
+			mem->desc.virtual_start = end;
+			mem->desc.num_pages = (map_end - end) >> EFI_PAGE_SHIFT;
+			efi_mem_update(mem);
 		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
+			efi_mem_remove(mem);
 		}
-
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
 	}
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
-
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
-
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
-
-	return EFI_CARVE_LOOP_AGAIN;
+	return 0;
 }
 
 uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 			    bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
+	struct efi_mem_list *first, *prev, *next, *mem;
+	struct efi_mem_desc desc = {};
+	uint64_t end = start + (pages << EFI_PAGE_SHIFT);
 
 	debug("%s: 0x%" PRIx64 " 0x%" PRIx64 " %d %s\n", __func__,
 	      start, pages, memory_type, overlap_only_ram ? "yes" : "no");
@@ -159,118 +224,111 @@ uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 	if (!pages)
 		return start;
 
-	newlist = calloc(1, sizeof(*newlist));
-	newlist->desc.type = memory_type;
-	newlist->desc.physical_start = start;
-	newlist->desc.virtual_start = start;
-	newlist->desc.num_pages = pages;
+	desc.type = memory_type;
+	desc.physical_start = start;
+	desc.virtual_start = start;
+	desc.num_pages = pages;
 
 	switch (memory_type) {
 	case EFI_RUNTIME_SERVICES_CODE:
 	case EFI_RUNTIME_SERVICES_DATA:
-		newlist->desc.attribute = (1 << EFI_MEMORY_WB_SHIFT) |
-					  (1ULL << EFI_MEMORY_RUNTIME_SHIFT);
+		desc.attribute = (1 << EFI_MEMORY_WB_SHIFT) |
+				 (1ULL << EFI_MEMORY_RUNTIME_SHIFT);
 		break;
 	case EFI_MMAP_IO:
-		newlist->desc.attribute = 1ULL << EFI_MEMORY_RUNTIME_SHIFT;
+		desc.attribute = 1ULL << EFI_MEMORY_RUNTIME_SHIFT;
 		break;
 	default:
-		newlist->desc.attribute = 1 << EFI_MEMORY_WB_SHIFT;
+		desc.attribute = 1 << EFI_MEMORY_WB_SHIFT;
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			int r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return 0;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
+	first = efi_mem_search(start);
+
+	if (overlap_only_ram) {
+		uint64_t covered = 0;
 
-	if (overlap_only_ram && (carved_pages != pages)) {
 		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
+		 * The payload wants to have RAM overlaps only. Check the whole
+		 * range before touching the map, so a failure leaves it intact.
 		 */
-		return 0;
+		for (mem = first; mem && mem->desc.physical_start < end;
+		     mem = efi_mem_entry(rb_next(&mem->node))) {
+			if (mem->desc.type != EFI_CONVENTIONAL_MEMORY)
+				return 0;
+			covered += min(efi_mem_end(mem), end) -
+				   max(mem->desc.physical_start, start);
+		}
+		if (covered != end - start)
+			return 0;
 	}
 
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
+	if (efi_mem_carve_out(first, start, end))
+		return 0;
 
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	/* Merge with adjacent regions of the same kind */
+	next = efi_mem_search(start);
+	prev = efi_mem_entry(next ? rb_prev(&next->node) : rb_last(&efi_mem));
+	if (!efi_mem_mergeable(prev, &desc) || efi_mem_end(prev) != start)
+		prev = NULL;
+	if (!efi_mem_mergeable(next, &desc) ||
+	    next->desc.physical_start != end)
+		next = NULL;
+
+	if (prev) {
+		prev->desc.num_pages += pages;
+		if (next) {
+			prev->desc.num_pages += next->desc.num_pages;
+			efi_mem_remove(next);
+		}
+		efi_mem_update(prev);
+	} else if (next) {
+		next->desc.physical_start = start;
+		next->desc.virtual_start = start;
+		next->desc.num_pages += pages;
+		efi_mem_update(next);
+	} else if (!efi_mem_insert(&desc)) {
+		return 0;
+	}
 
 	return start;
 }
 
-static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
+/*
+ * Find the highest free range of len bytes ending at or below max_addr in
+ * the subtree at node. Subtrees without a large enough free region are
+ * skipped using the max_free annotation.
+ */
+static uint64_t efi_find_free_memory_in(struct rb_node *node, uint64_t len,
+					uint64_t max_addr)
 {
-	struct list_head *lhandle;
-
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
-		uint64_t curmax = min(max_addr, desc_end);
-		uint64_t ret = curmax - len;
-
-		/* We only take memory from free RAM */
-		if (desc->type != EFI_CONVENTIONAL_MEMORY)
-			continue;
-
-		/* Out of bounds for max_addr */
-		if ((ret + len) > max_addr)
-			continue;
-
-		/* Out of bounds for upper map limit */
-		if ((ret + len) > desc_end)
-			continue;
-
-		/* Out of bounds for lower map limit */
-		if (ret < desc->physical_start)
-			continue;
-
-		/* Return the highest address in this map within bounds */
-		return ret;
+	struct efi_mem_list *mem = efi_mem_entry(node);
+	uint64_t ret;
+
+	if (!mem || (mem->max_free << EFI_PAGE_SHIFT) < len)
+		return 0;
+
+	if (mem->desc.physical_start < max_addr) {
+		ret = efi_find_free_memory_in(node->rb_right, len, max_addr);
+		if (ret)
+			return ret;
+
+		if (mem->desc.type == EFI_CONVENTIONAL_MEMORY) {
+			uint64_t curmax = min(max_addr, efi_mem_end(mem));
+
+			curmax &= ~(uint64_t)EFI_PAGE_MASK;
+			if (curmax >= len &&
+			    curmax - len >= mem->desc.physical_start)
+				return curmax - len;
+		}
 	}
 
-	return 0;
+	return efi_find_free_memory_in(node->rb_left, len, max_addr);
+}
+
+static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
+{
+	return efi_find_free_memory_in(efi_mem.rb_node, len, max_addr);
 }
 
 /*
@@ -357,7 +415,6 @@ efi_status_t efi_free_pages(uint64_t memory, efi_uintn_t pages)
 	uint64_t r = 0;
 
 	r = efi_add_memory_map(memory, pages, EFI_CONVENTIONAL_MEMORY, false);
-	/* Merging of adjacent free regions is missing */
 
 	if (r == memory)
 		return EFI_SUCCESS;
@@ -365,6 +422,76 @@ efi_status_t efi_free_pages(uint64_t memory, efi_uintn_t pages)
 	return EFI_NOT_FOUND;
 }
 
+/* Return the slot size class for a pool allocation, or -1 if too large */
+static int efi_pool_class(efi_uintn_t size)
+{
+	int class;
+
+	for (class = 0; class < EFI_POOL_CLASSES; class++) {
+		if (size <= EFI_POOL_SLOT_MIN << class)
+			return class;
+	}
+
+	return -1;
+}
+
+static struct efi_pool_allocation *efi_pool_get_slot(int pool_type, int class)
+{
+	struct efi_pool_page *page;
+	efi_physical_addr_t t;
+	u8 *slot, *page_end;
+
+	list_for_each_entry(page, &efi_pool_pages[class], link) {
+		if (page->memory_type == pool_type)
+			goto found;
+	}
+
+	/* No page of this type with a free slot, start a new one */
+	if (efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, 1, &t) !=
+	    EFI_SUCCESS)
+		return NULL;
+
+	page = (void *)(uintptr_t)t;
+	page->free = NULL;
+	page->memory_type = pool_type;
+	page->slot_size = EFI_POOL_SLOT_MIN << class;
+	page->class = class;
+	page->used = 0;
+	page_end = (u8 *)page + EFI_PAGE_SIZE;
+	for (slot = page_end - page->slot_size; slot >= (u8 *)(page + 1);
+	     slot -= page->slot_size) {
+		*(void **)slot = page->free;
+		page->free = slot;
+	}
+	list_add(&page->link, &efi_pool_pages[class]);
+
+found:
+	slot = page->free;
+	page->free = *(void **)slot;
+	page->used++;
+	/* Full pages are taken off the list until a slot is freed */
+	if (!page->free)
+		list_del(&page->link);
+
+	return (struct efi_pool_allocation *)slot;
+}
+
+static void efi_pool_put_slot(struct efi_pool_allocation *alloc)
+{
+	struct efi_pool_page *page;
+
+	page = (void *)((uintptr_t)alloc & ~(uintptr_t)EFI_PAGE_MASK);
+	if (!page->free)
+		list_add(&page->link, &efi_pool_pages[page->class]);
+	*(void **)alloc = page->free;
+	page->free = alloc;
+
+	if (!--page->used) {
+		list_del(&page->link);
+		efi_free_pages((uintptr_t)page, 1);
+	}
+}
+
 /*
  * Allocate memory from pool.
  *
@@ -375,20 +502,33 @@ efi_status_t efi_free_pages(uint64_t memory, efi_uintn_t pages)
  */
 efi_status_t efi_allocate_pool(int pool_type, efi_uintn_t size, void **buffer)
 {
+	struct efi_pool_allocation *alloc;
 	efi_status_t r;
 	efi_physical_addr_t t;
 	u64 num_pages = (size + sizeof(struct efi_pool_allocation) +
 			 EFI_PAGE_MASK) >> EFI_PAGE_SHIFT;
+	int class;
 
 	if (size == 0) {
 		*buffer = NULL;
 		return EFI_SUCCESS;
 	}
 
+	class = efi_pool_class(size + sizeof(struct efi_pool_allocation));
+	if (class >= 0) {
+		alloc = efi_pool_get_slot(pool_type, class);
+		if (!alloc)
+			return EFI_OUT_OF_RESOURCES;
+		alloc->num_pages = 0;
+		*buffer = alloc->data;
+
+		return EFI_SUCCESS;
+	}
+
 	r = efi_allocate_pages(0, pool_type, num_pages, &t);
 
 	if (r == EFI_SUCCESS) {
-		struct efi_pool_allocation *alloc = (void *)(uintptr_t)t;
+		alloc = (void *)(uintptr_t)t;
 		alloc->num_pages = num_pages;
 		*buffer = alloc->data;
 	}
@@ -411,6 +551,11 @@ efi_status_t efi_free_pool(void *buffer)
 		return EFI_INVALID_PARAMETER;
 
 	alloc = container_of(buffer, struct efi_pool_allocation, data);
+	if (!alloc->num_pages) {
+		efi_pool_put_slot(alloc);
+		return EFI_SUCCESS;
+	}
+
 	/* Sanity check, was the supplied address returned by allocate_pool */
 	assert(((uintptr_t)alloc & EFI_PAGE_MASK) == 0);
 
@@ -438,10 +583,10 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 {
 	efi_uintn_t map_size = 0;
 	int map_entries = 0;
-	struct list_head *lhandle;
+	struct rb_node *node;
 	efi_uintn_t provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
+	for (node = rb_first(&efi_mem); node; node = rb_next(node))
 		map_entries++;
 
 	map_size = map_entries * sizeof(struct efi_mem_desc);
@@ -457,17 +602,10 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 	if (descriptor_version)
 		*descriptor_version = EFI_MEMORY_DESCRIPTOR_VERSION;
 
-	/* Copy list into array */
+	/* Copy tree into array, in ascending order */
 	if (memory_map) {
-		/* Return the list in ascending order */
-		memory_map = &memory_map[map_entries - 1];
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			*memory_map = lmem->desc;
-			memory_map--;
-		}
+		for (node = rb_first(&efi_mem); node; node = rb_next(node))
+			*memory_map++ = efi_mem_entry(node)->desc;
 	}
 
 	*map_key = 0;
@@ -8,11 +8,40 @@
 #include <malloc.h>
 #include <charset.h>
 #include <efi_loader.h>
+#include <environment.h>
+#include <search.h>
+#include <uuid.h>
+#include <u-boot/crc.h>
+#include <linux/list.h>
 
 #define READ_ONLY BIT(31)
 
 /*
- * Mapping between EFI variables and u-boot variables:
+ * EFI variables are kept in an in-memory store, indexed by a hash of
+ * (vendor GUID, name) and kept on a list in creation order for
+ * GetNextVariableName().
+ *
+ * Non-volatile variables are persisted as a single binary image in the
+ * U-Boot environment variable "efi_vars". Environment values are NUL
+ * terminated strings, so the image is hex encoded:
+ *
+ *   struct efi_var_file	header with magic, length and CRC32
+ *   struct efi_var_entry	one per variable, each followed by its
+ *				UTF-16 name and data, padded to 8 bytes
+ *
+ * The image is only decoded once, on first use, and only re-encoded when
+ * the store is committed by efi_variables_commit(): on ExitBootServices()
+ * and when an EFI application returns. SetVariable() itself never touches
+ * the environment, so payloads probing or updating many variables do not
+ * trigger repeated conversions. Persisting the environment to storage is
+ * left to 'saveenv', as before.
+ *
+ * Variables in the previous format, one environment variable each, are
+ * still supported. They stay in that format: a change to one of them is
+ * written back to its own environment variable on the next commit, and it
+ * is never copied into "efi_vars". The environment is only read on first
+ * use, so later changes made with 'setenv' are not seen until the next
+ * boot:
  *
  *   efi_$guid_$varname = {attributes}(type)value
  *
@@ -30,24 +59,61 @@
  *   + boot - boot-services access
  *   + run  - runtime access
  *
- * NOTE: with current implementation, no variables are available after
- * ExitBootServices, and all are persisted (if possible).
- *
- * If not specified, the attributes default to "{boot}".
+ * If not specified, the attributes default to "{boot}". The type is one of
+ * "utf8" (raw utf8 string) or "blob" (arbitrary length hex string).
  *
- * The required type is one of:
- *
- *   + utf8 - raw utf8 string
- *   + blob - arbitrary length hex string
- *
- * Maybe a utf16 type would be useful to for a string value to be auto
- * converted to utf16?
+ * NOTE: with current implementation, no variables are available after
+ * ExitBootServices.
  */
 
-#define MAX_VAR_NAME 31
-#define MAX_NATIVE_VAR_NAME \
-	(strlen("efi_xxxxxxxx-xxxx-xxxx-xxxxxxxxxxxxxxxx_") + \
-		(MAX_VAR_NAME * MAX_UTF8_PER_UTF16))
+#define EFI_VARS_ENV		"efi_vars"
+#define EFI_VAR_FILE_MAGIC	0x0161566966456255ULL /* "UbEfiVa", v1 */
+#define EFI_VAR_HASH_SIZE	64
+
+#define ACCESS_ATTR	(EFI_VARIABLE_RUNTIME_ACCESS | \
+			 EFI_VARIABLE_BOOTSERVICE_ACCESS)
+
+/* On-media header of the variable store */
+struct efi_var_file {
+	u64 magic;
+	u32 length;		/* total length including this header */
+	u32 crc32;		/* CRC32 of the entries */
+	u8 var[];
+};
+
+/* On-media variable entry, followed by the name and data */
+struct efi_var_entry {
+	u32 length;		/* size of the data in bytes */
+	u32 attr;
+	efi_guid_t guid;
+	u16 name[];		/* NUL terminated */
+};
+
+struct efi_var {
+	struct hlist_node hash;
+	struct list_head link;
+	efi_guid_t guid;
+	u32 attr;
+	u32 size;
+	u8 *data;
+	bool legacy;		/* stored in its own environment variable */
+	bool changed;		/* legacy variable changed since the commit */
+	u16 name[];
+};
+
+static struct hlist_head efi_var_hash[EFI_VAR_HASH_SIZE];
+static LIST_HEAD(efi_var_list);
+static bool efi_vars_loaded;
+static bool efi_vars_dirty;
+
+/* Names of old-style environment variables found or deleted */
+struct efi_legacy_var {
+	struct list_head link;
+	char name[];
+};
+
+/* Old-style variables deleted by SetVariable(), to drop on the next commit */
+static LIST_HEAD(efi_legacy_deleted);
 
 static int hex(unsigned char ch)
 {
@@ -113,22 +179,6 @@ static char *mem2hex(char *hexstr, const u8 *mem, int count)
 	return hexstr;
 }
 
-static efi_status_t efi_to_native(char *native, s16 *variable_name,
-		efi_guid_t *vendor)
-{
-	size_t len;
-
-	len = utf16_strlen((u16 *)variable_name);
-	if (len >= MAX_VAR_NAME)
-		return EFI_DEVICE_ERROR;
-
-	native += sprintf(native, "efi_%pUl_", vendor);
-	native  = (char *)utf16_to_utf8((u8 *)native, (u16 *)variable_name, len);
-	*native = '\0';
-
-	return EFI_SUCCESS;
-}
-
 static const char *prefix(const char *str, const char *prefix)
 {
 	size_t n = strlen(prefix);
@@ -175,76 +225,411 @@ static const char *parse_attr(const char *str, u32 *attrp)
 	return str;
 }
 
-/* http://wiki.phoenix.com/wiki/index.php/EFI_RUNTIME_SERVICES#GetVariable.28.29 */
-efi_status_t EFIAPI efi_get_variable(s16 *variable_name,
-		efi_guid_t *vendor, u32 *attributes,
-		unsigned long *data_size, void *data)
+static unsigned int efi_var_hash_of(const u16 *name, size_t len,
+				    const efi_guid_t *guid)
 {
-	char native_name[MAX_NATIVE_VAR_NAME + 1];
-	efi_status_t ret;
-	unsigned long in_size;
-	const char *val, *s;
-	u32 attr;
+	u32 hash = 2166136261u;	/* FNV-1a */
+	size_t i;
 
-	EFI_ENTRY("\"%ls\" %pUl %p %p %p", variable_name, vendor, attributes,
-		  data_size, data);
+	for (i = 0; i < sizeof(*guid); i++)
+		hash = (hash ^ guid->b[i]) * 16777619u;
+	for (i = 0; i < len; i++)
+		hash = (hash ^ name[i]) * 16777619u;
 
-	if (!variable_name || !vendor || !data_size)
-		return EFI_EXIT(EFI_INVALID_PARAMETER);
+	return hash % EFI_VAR_HASH_SIZE;
+}
 
-	ret = efi_to_native(native_name, variable_name, vendor);
-	if (ret)
-		return EFI_EXIT(ret);
+static struct efi_var *efi_var_find(const u16 *name, const efi_guid_t *guid)
+{
+	size_t len = utf16_strlen(name);
+	struct hlist_node *node;
+	struct efi_var *var;
+
+	hlist_for_each_entry(var, node,
+			     &efi_var_hash[efi_var_hash_of(name, len, guid)],
+			     hash) {
+		if (!guidcmp(&var->guid, guid) &&
+		    utf16_strlen(var->name) == len &&
+		    !memcmp(var->name, name, len * sizeof(u16)))
+			return var;
+	}
 
-	debug("%s: get '%s'\n", __func__, native_name);
+	return NULL;
+}
 
-	val = env_get(native_name);
-	if (!val)
-		return EFI_EXIT(EFI_NOT_FOUND);
+static struct efi_var *efi_var_new(const u16 *name, const efi_guid_t *guid)
+{
+	size_t len = utf16_strlen(name);
+	struct efi_var *var;
+
+	var = calloc(1, sizeof(*var) + (len + 1) * sizeof(u16));
+	if (!var)
+		return NULL;
+	memcpy(var->name, name, (len + 1) * sizeof(u16));
+	var->guid = *guid;
+	hlist_add_head(&var->hash,
+		       &efi_var_hash[efi_var_hash_of(name, len, guid)]);
+	list_add_tail(&var->link, &efi_var_list);
+
+	return var;
+}
 
-	val = parse_attr(val, &attr);
+static void efi_var_delete(struct efi_var *var)
+{
+	hlist_del(&var->hash);
+	list_del(&var->link);
+	free(var->data);
+	free(var);
+}
 
-	in_size = *data_size;
+/* Replace (or with append set, extend) the value of a variable */
+static efi_status_t efi_var_set_data(struct efi_var *var, const void *data,
+				     u32 size, bool append)
+{
+	u32 offset = append ? var->size : 0;
+	u8 *buf;
+
+	buf = malloc(offset + size);
+	if (!buf)
+		return EFI_OUT_OF_RESOURCES;
+	memcpy(buf, var->data, offset);
+	memcpy(buf + offset, data, size);
+	free(var->data);
+	var->data = buf;
+	var->size = offset + size;
 
-	if ((s = prefix(val, "(blob)"))) {
-		unsigned len = strlen(s);
+	return EFI_SUCCESS;
+}
 
-		/* two characters per byte: */
-		len = DIV_ROUND_UP(len, 2);
-		*data_size = len;
+/* Import the binary variable store image from the environment */
+static void efi_vars_load_image(void)
+{
+	const char *hexstr = env_get(EFI_VARS_ENV);
+	struct efi_var_file *file;
+	u8 *pos, *end;
+	size_t len;
 
-		if (in_size < len)
-			return EFI_EXIT(EFI_BUFFER_TOO_SMALL);
+	if (!hexstr)
+		return;
+
+	len = strlen(hexstr) / 2;
+	if (len < sizeof(*file))
+		goto bad;
+	file = malloc(len);
+	if (!file)
+		return;
+	hex2mem((u8 *)file, hexstr, len * 2);
+
+	if (file->magic != EFI_VAR_FILE_MAGIC || file->length != len ||
+	    crc32(0, file->var, len - sizeof(*file)) != file->crc32) {
+		free(file);
+		goto bad;
+	}
 
-		if (!data)
-			return EFI_EXIT(EFI_INVALID_PARAMETER);
+	pos = file->var;
+	end = (u8 *)file + len;
+	while (pos + sizeof(struct efi_var_entry) <= end) {
+		struct efi_var_entry *entry = (void *)pos;
+		size_t name_len;
+		struct efi_var *var;
+		u8 *data;
+
+		name_len = utf16_strnlen(entry->name,
+					 (end - (u8 *)entry->name) / 2);
+		data = (u8 *)(entry->name + name_len + 1);
+		if (data + entry->length > end)
+			break;
 
-		if (hex2mem(data, s, len * 2))
-			return EFI_EXIT(EFI_DEVICE_ERROR);
+		var = efi_var_new(entry->name, &entry->guid);
+		if (!var ||
+		    efi_var_set_data(var, data, entry->length, false))
+			break;
+		var->attr = entry->attr;
 
-		debug("%s: got value: \"%s\"\n", __func__, s);
-	} else if ((s = prefix(val, "(utf8)"))) {
-		unsigned len = strlen(s) + 1;
+		pos = (u8 *)ALIGN((uintptr_t)(data + entry->length), 8);
+	}
+	free(file);
 
-		*data_size = len;
+	return;
+bad:
+	printf("EFI: Ignoring invalid variable store '%s'\n", EFI_VARS_ENV);
+}
 
-		if (in_size < len)
-			return EFI_EXIT(EFI_BUFFER_TOO_SMALL);
+/* Get the name of the old-style environment variable holding a variable */
+static char *efi_var_legacy_name(const struct efi_var *var)
+{
+	size_t len = utf16_strlen(var->name);
+	char *name, *s;
 
-		if (!data)
-			return EFI_EXIT(EFI_INVALID_PARAMETER);
+	name = malloc(strlen("efi_") + UUID_STR_LEN + 1 +
+		      len * MAX_UTF8_PER_UTF16 + 1);
+	if (!name)
+		return NULL;
+	s = name + sprintf(name, "efi_%pUl_", &var->guid);
+	*utf16_to_utf8((u8 *)s, var->name, len) = '\0';
 
-		memcpy(data, s, len);
-		((char *)data)[len] = '\0';
+	return name;
+}
 
-		debug("%s: got value: \"%s\"\n", __func__, (char *)data);
+/* Write an old-style variable back to its environment variable */
+static efi_status_t efi_var_save_legacy(struct efi_var *var)
+{
+	efi_status_t ret = EFI_SUCCESS;
+	char *name, *val, *s;
+
+	name = efi_var_legacy_name(var);
+	val = malloc(2 * var->size + strlen("{ro,boot,run}(blob)") + 1);
+	if (!name || !val) {
+		ret = EFI_OUT_OF_RESOURCES;
+		goto out;
+	}
+
+	s = val + sprintf(val, "{%s%s%s}(blob)",
+			  var->attr & READ_ONLY ? "ro," : "",
+			  var->attr & EFI_VARIABLE_BOOTSERVICE_ACCESS ?
+			  "boot" : "",
+			  var->attr & EFI_VARIABLE_RUNTIME_ACCESS ?
+			  (var->attr & EFI_VARIABLE_BOOTSERVICE_ACCESS ?
+			   ",run" : "run") : "");
+	*mem2hex(s, var->data, var->size) = '\0';
+	if (env_set(name, val))
+		ret = EFI_DEVICE_ERROR;
+	else
+		var->changed = false;
+out:
+	free(val);
+	free(name);
+
+	return ret;
+}
+
+/* Stop storing a variable in the old format, e.g. because it was deleted */
+static void efi_var_drop_legacy(struct efi_var *var)
+{
+	struct efi_legacy_var *legacy;
+	char *name;
+
+	if (!var->legacy)
+		return;
+	var->legacy = false;
+	name = efi_var_legacy_name(var);
+	if (!name)
+		return;
+	legacy = malloc(sizeof(*legacy) + strlen(name) + 1);
+	if (legacy) {
+		strcpy(legacy->name, name);
+		list_add_tail(&legacy->link, &efi_legacy_deleted);
+	}
+	free(name);
+}
+
+/* Import a single old-style environment variable */
+static void efi_vars_load_legacy(const char *env_name, const char *val)
+{
+	char guid_str[UUID_STR_LEN + 1];
+	const char *name, *s;
+	struct efi_var *var;
+	efi_guid_t guid;
+	u16 *name16;
+	u32 attr;
+
+	strlcpy(guid_str, env_name + strlen("efi_"), sizeof(guid_str));
+	if (uuid_str_to_bin(guid_str, guid.b, UUID_STR_FORMAT_GUID))
+		return;
+	name = env_name + strlen("efi_") + UUID_STR_LEN + 1;
+
+	name16 = calloc(strlen(name) + 1, sizeof(u16));
+	if (!name16)
+		return;
+	utf8_to_utf16(name16, (const u8 *)name, strlen(name));
+	/* The binary store takes precedence */
+	if (efi_var_find(name16, &guid))
+		goto out;
+
+	val = parse_attr(val, &attr);
+	var = efi_var_new(name16, &guid);
+	if (!var)
+		goto out;
+	/* Everything used to be persisted */
+	var->attr = attr | EFI_VARIABLE_NON_VOLATILE;
+	var->legacy = true;
+
+	if ((s = prefix(val, "(blob)"))) {
+		var->size = DIV_ROUND_UP(strlen(s), 2);
+		var->data = malloc(var->size);
+		if (!var->data) {
+			efi_var_delete(var);
+			goto out;
+		}
+		hex2mem(var->data, s, var->size * 2);
+	} else if ((s = prefix(val, "(utf8)"))) {
+		if (efi_var_set_data(var, s, strlen(s) + 1, false)) {
+			efi_var_delete(var);
+			goto out;
+		}
 	} else {
 		debug("%s: invalid value: '%s'\n", __func__, val);
-		return EFI_EXIT(EFI_DEVICE_ERROR);
+		efi_var_delete(var);
+		goto out;
 	}
+out:
+	free(name16);
+}
+
+static LIST_HEAD(efi_legacy_found);
+
+static int efi_vars_find_legacy(ENTRY *entry)
+{
+	struct efi_legacy_var *legacy;
+	const char *name = entry->key;
+
+	if (strncmp(name, "efi_", 4) || strlen(name) <= 4 + UUID_STR_LEN + 1 ||
+	    name[4 + UUID_STR_LEN] != '_')
+		return 0;
+
+	legacy = malloc(sizeof(*legacy) + strlen(name) + 1);
+	if (legacy) {
+		strcpy(legacy->name, name);
+		list_add_tail(&legacy->link, &efi_legacy_found);
+	}
+
+	return 0;
+}
+
+static void efi_vars_load(void)
+{
+	struct efi_legacy_var *legacy, *tmp;
+
+	if (efi_vars_loaded)
+		return;
+	efi_vars_loaded = true;
+
+	efi_vars_load_image();
+
+	/* The walk must not modify the table, so collect the names first */
+	hwalk_r(&env_htab, efi_vars_find_legacy);
+	list_for_each_entry_safe(legacy, tmp, &efi_legacy_found, link) {
+		const char *val = env_get(legacy->name);
+
+		if (val)
+			efi_vars_load_legacy(legacy->name, val);
+		list_del(&legacy->link);
+		free(legacy);
+	}
+}
+
+/*
+ * Write the non-volatile variables back to the environment, if they
+ * changed since the last commit.
+ *
+ * @return	status code
+ */
+efi_status_t efi_variables_commit(void)
+{
+	struct efi_legacy_var *legacy, *tmp;
+	struct efi_var_file *file;
+	struct efi_var *var;
+	efi_status_t ret = EFI_SUCCESS;
+	size_t len = sizeof(*file);
+	char *hexstr;
+	u8 *pos;
+
+	/* Old-style variables are kept in their own environment variables */
+	list_for_each_entry_safe(legacy, tmp, &efi_legacy_deleted, link) {
+		env_set(legacy->name, NULL);
+		list_del(&legacy->link);
+		free(legacy);
+	}
+	list_for_each_entry(var, &efi_var_list, link) {
+		if (var->legacy && var->changed) {
+			ret = efi_var_save_legacy(var);
+			if (ret != EFI_SUCCESS)
+				return ret;
+		}
+	}
+
+	if (!efi_vars_dirty)
+		return EFI_SUCCESS;
+
+	list_for_each_entry(var, &efi_var_list, link) {
+		if (var->legacy || !(var->attr & EFI_VARIABLE_NON_VOLATILE))
+			continue;
+		len += sizeof(struct efi_var_entry) +
+		       (utf16_strlen(var->name) + 1) * sizeof(u16);
+		len = ALIGN(len + var->size, 8);
+	}
+
+	file = calloc(1, len);
+	hexstr = malloc(len * 2 + 1);
+	if (!file || !hexstr) {
+		ret = EFI_OUT_OF_RESOURCES;
+		goto out;
+	}
+
+	pos = file->var;
+	list_for_each_entry(var, &efi_var_list, link) {
+		struct efi_var_entry *entry = (void *)pos;
+		size_t name_size = (utf16_strlen(var->name) + 1) * sizeof(u16);
+
+		if (var->legacy || !(var->attr & EFI_VARIABLE_NON_VOLATILE))
+			continue;
+		entry->length = var->size;
+		entry->attr = var->attr;
+		entry->guid = var->guid;
+		memcpy(entry->name, var->name, name_size);
+		pos = (u8 *)entry->name + name_size;
+		memcpy(pos, var->data, var->size);
+		pos = (u8 *)file + ALIGN(pos + var->size - (u8 *)file, 8);
+	}
+	file->magic = EFI_VAR_FILE_MAGIC;
+	file->length = len;
+	file->crc32 = crc32(0, file->var, len - sizeof(*file));
+
+	*mem2hex(hexstr, (u8 *)file, len) = '\0';
+	if (env_set(EFI_VARS_ENV, hexstr)) {
+		ret = EFI_DEVICE_ERROR;
+		goto out;
+	}
+	efi_vars_dirty = false;
+out:
+	free(hexstr);
+	free(file);
+
+	return ret;
+}
+
+/* http://wiki.phoenix.com/wiki/index.php/EFI_RUNTIME_SERVICES#GetVariable.28.29 */
+efi_status_t EFIAPI efi_get_variable(s16 *variable_name,
+		efi_guid_t *vendor, u32 *attributes,
+		unsigned long *data_size, void *data)
+{
+	struct efi_var *var;
+
+	EFI_ENTRY("\"%ls\" %pUl %p %p %p", variable_name, vendor, attributes,
+		  data_size, data);
+
+	if (!variable_name || !vendor || !data_size)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+
+	efi_vars_load();
+
+	var = efi_var_find((u16 *)variable_name, vendor);
+	if (!var)
+		return EFI_EXIT(EFI_NOT_FOUND);
+
+	if (*data_size < var->size) {
+		*data_size = var->size;
+		return EFI_EXIT(EFI_BUFFER_TOO_SMALL);
+	}
+	*data_size = var->size;
+
+	if (!data)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+
+	memcpy(data, var->data, var->size);
 
 	if (attributes)
-		*attributes = attr & EFI_VARIABLE_MASK;
+		*attributes = var->attr & EFI_VARIABLE_MASK;
 
 	return EFI_EXIT(EFI_SUCCESS);
 }
@@ -254,9 +639,40 @@ efi_status_t EFIAPI efi_get_next_variable(
 		unsigned long *variable_name_size,
 		s16 *variable_name, efi_guid_t *vendor)
 {
+	struct list_head *next;
+	struct efi_var *var;
+	unsigned long size;
+
 	EFI_ENTRY("%p \"%ls\" %pUl", variable_name_size, variable_name, vendor);
 
-	return EFI_EXIT(EFI_DEVICE_ERROR);
+	if (!variable_name_size || !variable_name || !vendor)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+
+	efi_vars_load();
+
+	/* An empty name starts the enumeration */
+	if (!*variable_name) {
+		next = efi_var_list.next;
+	} else {
+		var = efi_var_find((u16 *)variable_name, vendor);
+		if (!var)
+			return EFI_EXIT(EFI_INVALID_PARAMETER);
+		next = var->link.next;
+	}
+	if (next == &efi_var_list)
+		return EFI_EXIT(EFI_NOT_FOUND);
+	var = list_entry(next, struct efi_var, link);
+
+	size = (utf16_strlen(var->name) + 1) * sizeof(u16);
+	if (*variable_name_size < size) {
+		*variable_name_size = size;
+		return EFI_EXIT(EFI_BUFFER_TOO_SMALL);
+	}
+	*variable_name_size = size;
+	memcpy(variable_name, var->name, size);
+	*vendor = var->guid;
+
+	return EFI_EXIT(EFI_SUCCESS);
 }
 
 /* http://wiki.phoenix.com/wiki/index.php/EFI_RUNTIME_SERVICES#SetVariable.28.29 */
@@ -264,71 +680,63 @@ efi_status_t EFIAPI efi_set_variable(s16 *variable_name,
 		efi_guid_t *vendor, u32 attributes,
 		unsigned long data_size, void *data)
 {
-	char native_name[MAX_NATIVE_VAR_NAME + 1];
+	bool append = attributes & EFI_VARIABLE_APPEND_WRITE;
 	efi_status_t ret = EFI_SUCCESS;
-	char *val, *s;
-	u32 attr;
+	struct efi_var *var;
+	bool legacy = false;
+	u32 old_attr = 0;
 
 	EFI_ENTRY("\"%ls\" %pUl %x %lu %p", variable_name, vendor, attributes,
 		  data_size, data);
 
-	if (!variable_name || !vendor)
+	if (!variable_name || !*variable_name || !vendor ||
+	    (data_size && !data))
 		return EFI_EXIT(EFI_INVALID_PARAMETER);
 
-	ret = efi_to_native(native_name, variable_name, vendor);
-	if (ret)
-		return EFI_EXIT(ret);
+	efi_vars_load();
 
-#define ACCESS_ATTR (EFI_VARIABLE_RUNTIME_ACCESS | EFI_VARIABLE_BOOTSERVICE_ACCESS)
+	var = efi_var_find((u16 *)variable_name, vendor);
+	if (var) {
+		if (var->attr & READ_ONLY)
+			return EFI_EXIT(EFI_WRITE_PROTECTED);
+		old_attr = var->attr;
+		legacy = var->legacy;
+	}
 
-	if ((data_size == 0) || !(attributes & ACCESS_ATTR)) {
+	if (!append && (data_size == 0 || !(attributes & ACCESS_ATTR))) {
 		/* delete the variable: */
-		env_set(native_name, NULL);
+		if (var) {
+			efi_var_drop_legacy(var);
+			efi_var_delete(var);
+			if (!legacy && (old_attr & EFI_VARIABLE_NON_VOLATILE))
+				efi_vars_dirty = true;
+		}
 		return EFI_EXIT(EFI_SUCCESS);
 	}
 
-	val = env_get(native_name);
-	if (val) {
-		parse_attr(val, &attr);
+	if (!data_size)
+		return EFI_EXIT(EFI_SUCCESS);
 
-		if (attr & READ_ONLY)
-			return EFI_EXIT(EFI_WRITE_PROTECTED);
+	if (!var) {
+		var = efi_var_new((u16 *)variable_name, vendor);
+		if (!var)
+			return EFI_EXIT(EFI_OUT_OF_RESOURCES);
+		append = false;
 	}
 
-	val = malloc(2 * data_size + strlen("{ro,run,boot}(blob)") + 1);
-	if (!val)
-		return EFI_EXIT(EFI_OUT_OF_RESOURCES);
-
-	s = val;
-
-	/* store attributes: */
-	attributes &= (EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS);
-	s += sprintf(s, "{");
-	while (attributes) {
-		u32 attr = 1 << (ffs(attributes) - 1);
-
-		if (attr == EFI_VARIABLE_BOOTSERVICE_ACCESS)
-			s += sprintf(s, "boot");
-		else if (attr == EFI_VARIABLE_RUNTIME_ACCESS)
-			s += sprintf(s, "run");
-
-		attributes &= ~attr;
-		if (attributes)
-			s += sprintf(s, ",");
+	ret = efi_var_set_data(var, data, data_size, append);
+	if (ret != EFI_SUCCESS) {
+		if (!var->data)
+			efi_var_delete(var);
+		return EFI_EXIT(ret);
 	}
-	s += sprintf(s, "}");
+	var->attr = attributes & (EFI_VARIABLE_NON_VOLATILE | ACCESS_ATTR);
+	if (!(var->attr & EFI_VARIABLE_NON_VOLATILE))
+		efi_var_drop_legacy(var);
+	var->changed = true;
 
-	/* store payload: */
-	s += sprintf(s, "(blob)");
-	s = mem2hex(s, data, data_size);
-	*s = '\0';
-
-	debug("%s: setting: %s=%s\n", __func__, native_name, val);
-
-	if (env_set(native_name, val))
-		ret = EFI_DEVICE_ERROR;
-
-	free(val);
+	if (!legacy && ((old_attr | var->attr) & EFI_VARIABLE_NON_VOLATILE))
+		efi_vars_dirty = true;
 
 	return EFI_EXIT(ret);
 }
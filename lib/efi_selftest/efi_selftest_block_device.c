@@ -383,9 +383,16 @@ static int execute(void)
 		efi_st_error("Failed to open file\n");
 		return EFI_ST_FAILURE;
 	}
-	buf_size = sizeof(buf) - 1;
+	/* Read in two parts to check that the file position is honoured */
+	buf_size = 6;
 	ret = file->read(file, &buf_size, buf);
-	if (ret != EFI_SUCCESS) {
+	if (ret != EFI_SUCCESS || buf_size != 6) {
+		efi_st_error("Failed to read file\n");
+		return EFI_ST_FAILURE;
+	}
+	buf_size = sizeof(buf) - 7;
+	ret = file->read(file, &buf_size, buf + 6);
+	if (ret != EFI_SUCCESS || buf_size != 7) {
 		efi_st_error("Failed to read file\n");
 		return EFI_ST_FAILURE;
 	}
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * efi_selftest_memory
+ *
+ * This unit test checks the pool and page allocation services.
+ *
+ * Many small pool buffers of two memory types are allocated. They must be
+ * 8 byte aligned, must not overlap and must lie in memory map regions of
+ * the requested type. Pages allocated below a maximum address must respect
+ * that limit. After freeing everything the amount of free memory must be
+ * the same as before.
+ */
+
+#include <efi_selftest.h>
+
+#define NUM_BUFFERS	64
+#define BUFFER_SIZE	40
+
+static struct efi_boot_services *boottime;
+static void *buffers[NUM_BUFFERS];
+
+/*
+ * Setup unit test.
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ * @return:	EFI_ST_SUCCESS for success
+ */
+static int setup(const efi_handle_t handle,
+		 const struct efi_system_table *systable)
+{
+	boottime = systable->boottime;
+
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Get the current memory map.
+ *
+ * @map:	returns the memory map, to be freed by the caller
+ * @entries:	returns the number of entries
+ * @desc_size:	returns the size of a single entry
+ * @return:	EFI_ST_SUCCESS for success
+ */
+static int get_map(struct efi_mem_desc **map, efi_uintn_t *entries,
+		   efi_uintn_t *desc_size)
+{
+	efi_uintn_t map_size = 0, map_key;
+	u32 desc_version;
+	efi_status_t ret;
+
+	ret = boottime->get_memory_map(&map_size, NULL, &map_key, desc_size,
+				       &desc_version);
+	if (ret != EFI_BUFFER_TOO_SMALL) {
+		efi_st_error("GetMemoryMap did not return size\n");
+		return EFI_ST_FAILURE;
+	}
+	/* Allocating the buffer may add entries to the map */
+	map_size += 4 * *desc_size;
+	ret = boottime->allocate_pool(EFI_LOADER_DATA, map_size,
+				      (void **)map);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("AllocatePool failed\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->get_memory_map(&map_size, *map, &map_key, desc_size,
+				       &desc_version);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("GetMemoryMap failed\n");
+		boottime->free_pool(*map);
+		return EFI_ST_FAILURE;
+	}
+	*entries = map_size / *desc_size;
+
+	return EFI_ST_SUCCESS;
+}
+
+static struct efi_mem_desc *map_entry(struct efi_mem_desc *map,
+				      efi_uintn_t desc_size, efi_uintn_t i)
+{
+	return (struct efi_mem_desc *)((u8 *)map + i * desc_size);
+}
+
+/*
+ * Find the type of the memory map region containing an address.
+ *
+ * @return:	memory type or -1 if not found
+ */
+static int find_type(struct efi_mem_desc *map, efi_uintn_t entries,
+		     efi_uintn_t desc_size, void *addr)
+{
+	efi_uintn_t i;
+
+	for (i = 0; i < entries; ++i) {
+		struct efi_mem_desc *desc = map_entry(map, desc_size, i);
+		u64 start = desc->physical_start;
+		u64 end = start + (desc->num_pages << EFI_PAGE_SHIFT);
+
+		if ((uintptr_t)addr >= start && (uintptr_t)addr < end)
+			return desc->type;
+	}
+
+	return -1;
+}
+
+/*
+ * Count the free pages in the memory map.
+ *
+ * @free_pages:	returns the number of free pages
+ * @return:	EFI_ST_SUCCESS for success
+ */
+static int count_free(u64 *free_pages)
+{
+	struct efi_mem_desc *map;
+	efi_uintn_t entries, desc_size, i;
+
+	if (get_map(&map, &entries, &desc_size) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	*free_pages = 0;
+	for (i = 0; i < entries; ++i) {
+		struct efi_mem_desc *desc = map_entry(map, desc_size, i);
+
+		if (desc->type == EFI_CONVENTIONAL_MEMORY)
+			*free_pages += desc->num_pages;
+	}
+	boottime->free_pool(map);
+
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Execute unit test.
+ *
+ * @return:	EFI_ST_SUCCESS for success
+ */
+static int execute(void)
+{
+	struct efi_mem_desc *map;
+	efi_uintn_t entries, desc_size;
+	efi_physical_addr_t pages, max_addr;
+	u64 free_before, free_after;
+	efi_status_t ret;
+	unsigned int i, j;
+
+	if (count_free(&free_before) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	for (i = 0; i < NUM_BUFFERS; ++i) {
+		int type = i & 1 ? EFI_BOOT_SERVICES_DATA : EFI_LOADER_DATA;
+
+		ret = boottime->allocate_pool(type, BUFFER_SIZE, &buffers[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("AllocatePool failed\n");
+			return EFI_ST_FAILURE;
+		}
+		if ((uintptr_t)buffers[i] & 7) {
+			efi_st_error("Pool buffer is not 8 byte aligned\n");
+			return EFI_ST_FAILURE;
+		}
+		boottime->set_mem(buffers[i], BUFFER_SIZE, i);
+	}
+	for (i = 0; i < NUM_BUFFERS; ++i) {
+		for (j = 0; j < BUFFER_SIZE; ++j) {
+			if (((u8 *)buffers[i])[j] != (u8)i) {
+				efi_st_error("Pool buffers overlap\n");
+				return EFI_ST_FAILURE;
+			}
+		}
+	}
+
+	if (get_map(&map, &entries, &desc_size) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	for (i = 0; i < NUM_BUFFERS; ++i) {
+		int type = i & 1 ? EFI_BOOT_SERVICES_DATA : EFI_LOADER_DATA;
+
+		if (find_type(map, entries, desc_size, buffers[i]) != type) {
+			efi_st_error("Pool buffer has wrong memory type\n");
+			boottime->free_pool(map);
+			return EFI_ST_FAILURE;
+		}
+	}
+	boottime->free_pool(map);
+
+	for (i = 0; i < NUM_BUFFERS; ++i) {
+		ret = boottime->free_pool(buffers[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("FreePool failed\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	/* Allocate below an address which is not page aligned */
+	ret = boottime->allocate_pages(EFI_ALLOCATE_ANY_PAGES, EFI_LOADER_DATA,
+				       1, &pages);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("AllocatePages failed\n");
+		return EFI_ST_FAILURE;
+	}
+	max_addr = pages + EFI_PAGE_SIZE / 2;
+	ret = boottime->free_pages(pages, 1);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("FreePages failed\n");
+		return EFI_ST_FAILURE;
+	}
+	pages = max_addr;
+	ret = boottime->allocate_pages(EFI_ALLOCATE_MAX_ADDRESS,
+				       EFI_LOADER_DATA, 2, &pages);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("AllocatePages failed\n");
+		return EFI_ST_FAILURE;
+	}
+	if ((pages & EFI_PAGE_MASK) || pages + 2 * EFI_PAGE_SIZE > max_addr) {
+		efi_st_error("AllocatePages ignored the maximum address\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->free_pages(pages, 2);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("FreePages failed\n");
+		return EFI_ST_FAILURE;
+	}
+
+	if (count_free(&free_after) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (free_after != free_before) {
+		efi_st_error("Memory was not released\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+EFI_UNIT_TEST(memory) = {
+	.name = "memory",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup,
+	.execute = execute,
+};
@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * efi_selftest_timers
+ *
+ * This unit test checks that many armed timer events fire in the order of
+ * their trigger times, that none of them fires early, and that stopped or
+ * closed timers do not fire.
+ */
+
+#include <efi_selftest.h>
+
+#define NUM_TIMERS	64
+/* Distance between the trigger times in multiples of 100 ns, i.e. 1 ms */
+#define TIMER_STEP	10000
+
+static struct efi_boot_services *boottime;
+static struct efi_event *timers[NUM_TIMERS];
+static unsigned int order[NUM_TIMERS];
+static unsigned int fired;
+
+/*
+ * Notification function, records the position of the timer.
+ *
+ * @event	notified event
+ * @context	position of the timer
+ */
+static void EFIAPI notify(struct efi_event *event, void *context)
+{
+	if (fired < NUM_TIMERS)
+		order[fired] = (uintptr_t)context;
+	++fired;
+}
+
+/*
+ * Setup unit test.
+ *
+ * Create the timer events.
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ * @return:	EFI_ST_SUCCESS for success
+ */
+static int setup(const efi_handle_t handle,
+		 const struct efi_system_table *systable)
+{
+	efi_status_t ret;
+	uintptr_t i;
+
+	boottime = systable->boottime;
+
+	for (i = 0; i < NUM_TIMERS; ++i) {
+		ret = boottime->create_event(EVT_TIMER | EVT_NOTIFY_SIGNAL,
+					     TPL_CALLBACK, notify, (void *)i,
+					     &timers[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("could not create event\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Tear down unit test.
+ *
+ * Close the events created in setup.
+ *
+ * @return:	EFI_ST_SUCCESS for success
+ */
+static int teardown(void)
+{
+	efi_status_t ret;
+	unsigned int i;
+
+	for (i = 0; i < NUM_TIMERS; ++i) {
+		if (!timers[i])
+			continue;
+		ret = boottime->close_event(timers[i]);
+		timers[i] = NULL;
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("could not close event\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Call CheckEvent until a timer event is signaled.
+ *
+ * @trigger_time:	trigger time in multiples of 100 ns
+ * @return:		EFI_ST_SUCCESS for success
+ */
+static int wait_timer(u64 trigger_time)
+{
+	struct efi_event *event;
+	efi_status_t ret;
+
+	ret = boottime->create_event(EVT_TIMER, TPL_CALLBACK, NULL, NULL,
+				     &event);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("could not create event\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->set_timer(event, EFI_TIMER_RELATIVE, trigger_time);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("could not set timer\n");
+		return EFI_ST_FAILURE;
+	}
+	while (boottime->check_event(event) != EFI_SUCCESS)
+		;
+	ret = boottime->close_event(event);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("could not close event\n");
+		return EFI_ST_FAILURE;
+	}
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Execute unit test.
+ *
+ * The timers are armed in a scrambled order. Every 8th timer is stopped
+ * and every 8th closed again before it can fire.
+ *
+ * @return:	EFI_ST_SUCCESS for success
+ */
+static int execute(void)
+{
+	unsigned int expected, i;
+	efi_status_t ret;
+
+	fired = 0;
+	for (i = 0; i < NUM_TIMERS; ++i) {
+		/* NUM_TIMERS is a power of two and 37 is odd */
+		unsigned int k = (37 * i) % NUM_TIMERS;
+
+		ret = boottime->set_timer(timers[k], EFI_TIMER_RELATIVE,
+					  (k + 10) * TIMER_STEP);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("could not set timer\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	for (i = 3; i < NUM_TIMERS; i += 8) {
+		ret = boottime->set_timer(timers[i], EFI_TIMER_STOP, 0);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("could not stop timer\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	for (i = 6; i < NUM_TIMERS; i += 8) {
+		ret = boottime->close_event(timers[i]);
+		timers[i] = NULL;
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("could not close event\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	expected = NUM_TIMERS - 2 * NUM_TIMERS / 8;
+
+	/* The first timer is due after 10 ms, so none may fire within 5 ms */
+	if (wait_timer(5 * TIMER_STEP) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (fired) {
+		efi_st_error("%u timers fired early\n", fired);
+		return EFI_ST_FAILURE;
+	}
+
+	/* Wait until all timers are due */
+	if (wait_timer((NUM_TIMERS + 20) * TIMER_STEP) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (fired != expected) {
+		efi_st_error("%u timers fired, expected %u\n", fired, expected);
+		return EFI_ST_FAILURE;
+	}
+	for (i = 0; i < fired; ++i) {
+		if (order[i] % 8 == 3 || order[i] % 8 == 6) {
+			efi_st_error("Disabled timer %u fired\n", order[i]);
+			return EFI_ST_FAILURE;
+		}
+		if (i && order[i] <= order[i - 1]) {
+			efi_st_error("Timers fired out of order\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	return EFI_ST_SUCCESS;
+}
+
+EFI_UNIT_TEST(timers) = {
+	.name = "timers",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup,
+	.execute = execute,
+	.teardown = teardown,
+};
@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * efi_selftest_variables
+ *
+ * This unit test checks the variable services.
+ *
+ * A variable is created, extended with EFI_VARIABLE_APPEND_WRITE, read back
+ * and found by enumerating all variables with GetNextVariableName().
+ * Finally it is deleted.
+ */
+
+#include <efi_selftest.h>
+
+#define EFI_ST_MAX_DATA_SIZE 16
+#define EFI_ST_MAX_VARNAME_SIZE 40
+
+static struct efi_runtime_services *runtime;
+static const efi_guid_t guid_vendor0 =
+	EFI_GUID(0x67029eb5, 0x0af2, 0xf6b1,
+		 0xda, 0x53, 0xfc, 0xb5, 0x66, 0xdd, 0x1c, 0xe6);
+
+/*
+ * Setup unit test.
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ * @return:	EFI_ST_SUCCESS for success
+ */
+static int setup(const efi_handle_t handle,
+		 const struct efi_system_table *systable)
+{
+	runtime = systable->runtime;
+
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Execute unit test.
+ *
+ * @return:	EFI_ST_SUCCESS for success
+ */
+static int execute(void)
+{
+	efi_status_t ret;
+	unsigned long len;
+	u32 attr;
+	u8 v[6] = {0x1, 0x2, 0x3, 0x4, 0x5, 0x6};
+	u8 data[EFI_ST_MAX_DATA_SIZE];
+	u16 varname[EFI_ST_MAX_VARNAME_SIZE];
+	efi_guid_t guid;
+	bool found = false;
+
+	/* Set variable */
+	ret = runtime->set_variable((s16 *)L"efi_st_var0",
+				    (efi_guid_t *)&guid_vendor0,
+				    EFI_VARIABLE_BOOTSERVICE_ACCESS,
+				    3, v);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("SetVariable failed\n");
+		return EFI_ST_FAILURE;
+	}
+	/* Append to variable */
+	ret = runtime->set_variable((s16 *)L"efi_st_var0",
+				    (efi_guid_t *)&guid_vendor0,
+				    EFI_VARIABLE_BOOTSERVICE_ACCESS |
+				    EFI_VARIABLE_APPEND_WRITE,
+				    3, v + 3);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("SetVariable(APPEND_WRITE) failed\n");
+		return EFI_ST_FAILURE;
+	}
+	/* Read variable, first with a buffer which is too small */
+	len = 1;
+	ret = runtime->get_variable((s16 *)L"efi_st_var0",
+				    (efi_guid_t *)&guid_vendor0,
+				    &attr, &len, data);
+	if (ret != EFI_BUFFER_TOO_SMALL || len != sizeof(v)) {
+		efi_st_error("GetVariable did not return the size\n");
+		return EFI_ST_FAILURE;
+	}
+	len = EFI_ST_MAX_DATA_SIZE;
+	ret = runtime->get_variable((s16 *)L"efi_st_var0",
+				    (efi_guid_t *)&guid_vendor0,
+				    &attr, &len, data);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("GetVariable failed\n");
+		return EFI_ST_FAILURE;
+	}
+	if (len != sizeof(v) || efi_st_memcmp(data, v, sizeof(v))) {
+		efi_st_error("GetVariable returned wrong value\n");
+		return EFI_ST_FAILURE;
+	}
+	if (attr != EFI_VARIABLE_BOOTSERVICE_ACCESS) {
+		efi_st_error("GetVariable returned wrong attributes\n");
+		return EFI_ST_FAILURE;
+	}
+	/* Enumerate variables */
+	varname[0] = 0;
+	for (;;) {
+		len = EFI_ST_MAX_VARNAME_SIZE * sizeof(u16);
+		ret = runtime->get_next_variable(&len, (s16 *)varname, &guid);
+		if (ret == EFI_NOT_FOUND)
+			break;
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("GetNextVariableName failed\n");
+			return EFI_ST_FAILURE;
+		}
+		if (!efi_st_memcmp(&guid, &guid_vendor0, sizeof(guid)) &&
+		    !efi_st_memcmp(varname, L"efi_st_var0", 24))
+			found = true;
+	}
+	if (!found) {
+		efi_st_error("Variable not found by GetNextVariableName\n");
+		return EFI_ST_FAILURE;
+	}
+	/* Delete variable */
+	ret = runtime->set_variable((s16 *)L"efi_st_var0",
+				    (efi_guid_t *)&guid_vendor0,
+				    0, 0, NULL);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("SetVariable failed\n");
+		return EFI_ST_FAILURE;
+	}
+	len = EFI_ST_MAX_DATA_SIZE;
+	ret = runtime->get_variable((s16 *)L"efi_st_var0",
+				    (efi_guid_t *)&guid_vendor0,
+				    &attr, &len, data);
+	if (ret != EFI_NOT_FOUND) {
+		efi_st_error("Variable was not deleted\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+EFI_UNIT_TEST(variables) = {
+	.name = "variables",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup,
+	.execute = execute,
+};
@@ -11,10 +11,12 @@
 #include <errno.h>
 #include <fdtdec.h>
 #include <fdt_support.h>
+#include <malloc.h>
 #include <linux/libfdt.h>
 #include <serial.h>
 #include <asm/sections.h>
 #include <linux/ctype.h>
+#include <linux/log2.h>
 #include <linux/lzo.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -616,6 +618,78 @@ int fdtdec_prepare_fdt(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+/* Offsets of nodes in the control FDT indexed by (phandle & mask), or -1 */
+static int *phandle_cache;
+static const void *phandle_cache_blob;
+static uint32_t phandle_cache_mask;
+
+static int fdtdec_build_phandle_cache(const void *blob)
+{
+	uint32_t phandle;
+	int count = 0;
+	int node;
+
+	free(phandle_cache);
+	phandle_cache = NULL;
+	phandle_cache_blob = blob;
+
+	for (node = fdt_next_node(blob, -1, NULL); node >= 0;
+	     node = fdt_next_node(blob, node, NULL)) {
+		if (fdt_get_phandle(blob, node))
+			count++;
+	}
+	if (!count)
+		return -ENOENT;
+	count = roundup_pow_of_two(count);
+	phandle_cache = malloc(count * sizeof(int));
+	if (!phandle_cache)
+		return -ENOMEM;
+	memset(phandle_cache, '\xff', count * sizeof(int));
+	phandle_cache_mask = count - 1;
+
+	for (node = fdt_next_node(blob, -1, NULL); node >= 0;
+	     node = fdt_next_node(blob, node, NULL)) {
+		phandle = fdt_get_phandle(blob, node);
+		if (phandle && phandle_cache[phandle & phandle_cache_mask] < 0)
+			phandle_cache[phandle & phandle_cache_mask] = node;
+	}
+
+	return 0;
+}
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+	int *entry;
+	int node;
+
+	/* There is no BSS or full malloc() before relocation */
+	if (blob != gd->fdt_blob || !(gd->flags & GD_FLG_FULL_MALLOC_INIT) ||
+	    !phandle || phandle == (uint32_t)-1)
+		return fdt_node_offset_by_phandle(blob, phandle);
+
+	if (blob != phandle_cache_blob)
+		fdtdec_build_phandle_cache(blob);
+	if (!phandle_cache)
+		return fdt_node_offset_by_phandle(blob, phandle);
+
+	/* Offsets change if the FDT is modified, so check the entry */
+	entry = &phandle_cache[phandle & phandle_cache_mask];
+	if (*entry >= 0 && fdt_get_phandle(blob, *entry) == phandle)
+		return *entry;
+	node = fdt_node_offset_by_phandle(blob, phandle);
+	if (node >= 0)
+		*entry = node;
+
+	return node;
+}
+#else
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+#endif
+
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 {
 	const u32 *phandle;
@@ -626,7 +700,7 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -757,8 +831,8 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = fdtdec_node_offset_by_phandle(blob,
+								     phandle);
 				if (!node) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
@@ -1,2 +1,102 @@
 #include <linux/libfdt_env.h>
+#include <linux/libfdt.h>
+
+/*
+ * U-Boot local addition: fdt_overlay_apply_index() keeps the results of
+ * the slow whole-tree scans in a struct fdt_overlay_index, so that they
+ * are not repeated for each of a stack of overlays. The upstream code is
+ * used unchanged, with those two scans redirected below.
+ */
+static struct fdt_overlay_index *overlay_index;
+
+static uint32_t overlay_index_max_phandle(const void *fdt)
+{
+	if (!overlay_index)
+		return fdt_get_max_phandle(fdt);
+	if (!overlay_index->max_phandle)
+		overlay_index->max_phandle = fdt_get_max_phandle(fdt);
+
+	return overlay_index->max_phandle;
+}
+
+static int overlay_index_node_by_phandle(const void *fdt, uint32_t phandle)
+{
+	struct fdt_overlay_index *idx = overlay_index;
+	struct fdt_overlay_target *target;
+	int node, len, i;
+
+	if (!idx)
+		return fdt_node_offset_by_phandle(fdt, phandle);
+
+	for (i = 0; i < idx->count; i++) {
+		target = &idx->targets[i];
+		if (target->phandle != phandle)
+			continue;
+		/* The node may have been given a new phandle by an overlay */
+		node = fdt_path_offset(fdt, idx->strings + target->path);
+		if (node >= 0 && fdt_get_phandle(fdt, node) == phandle)
+			return node;
+		target->phandle = 0;
+		break;
+	}
+
+	node = fdt_node_offset_by_phandle(fdt, phandle);
+	if (node < 0 || idx->count == idx->size)
+		return node;
+	if (fdt_get_path(fdt, node, idx->strings + idx->strings_used,
+			 idx->strings_size - idx->strings_used))
+		return node;
+	len = strlen(idx->strings + idx->strings_used) + 1;
+	target = &idx->targets[idx->count++];
+	target->phandle = phandle;
+	target->path = idx->strings_used;
+	idx->strings_used += len;
+
+	return node;
+}
+
+#define fdt_get_max_phandle		overlay_index_max_phandle
+#define fdt_node_offset_by_phandle	overlay_index_node_by_phandle
 #include "../../scripts/dtc/libfdt/fdt_overlay.c"
+#undef fdt_get_max_phandle
+#undef fdt_node_offset_by_phandle
+
+void fdt_overlay_index_init(struct fdt_overlay_index *idx, void *buf,
+			    int size)
+{
+	int count = size / (sizeof(struct fdt_overlay_target) + 64);
+
+	idx->max_phandle = 0;
+	idx->targets = buf;
+	idx->count = 0;
+	idx->size = count;
+	idx->strings = (char *)buf + count * sizeof(struct fdt_overlay_target);
+	idx->strings_used = 0;
+	idx->strings_size = size - count * sizeof(struct fdt_overlay_target);
+}
+
+int fdt_overlay_apply_index(void *fdt, void *fdto,
+			    struct fdt_overlay_index *idx)
+{
+	uint32_t max_phandle = 0;
+	int ret;
+
+	if (!idx)
+		return fdt_overlay_apply(fdt, fdto);
+
+	/* Phandles in the overlay are moved up past those in the tree */
+	if (!fdt_check_header(fdto))
+		max_phandle = fdt_get_max_phandle(fdto);
+	overlay_index = idx;
+	ret = fdt_overlay_apply(fdt, fdto);
+	overlay_index = NULL;
+	if (ret) {
+		fdt_overlay_index_init(idx, idx->targets,
+				       (char *)idx->strings + idx->strings_size -
+				       (char *)idx->targets);
+		return ret;
+	}
+	idx->max_phandle += max_phandle;
+
+	return 0;
+}
@@ -8,12 +8,15 @@
 
 #include <common.h>
 #include <lmb.h>
+#include <malloc.h>
 
 #define LMB_ALLOC_ANYWHERE	0
 
 void lmb_dump_all(struct lmb *lmb)
 {
 #ifdef DEBUG
+	struct lmb_property *mem = lmb_regions(&lmb->memory);
+	struct lmb_property *res = lmb_regions(&lmb->reserved);
 	unsigned long i;
 
 	debug("lmb_dump_all:\n");
@@ -22,9 +25,9 @@ void lmb_dump_all(struct lmb *lmb)
 	      (unsigned long long)lmb->memory.size);
 	for (i=0; i < lmb->memory.cnt ;i++) {
 		debug("    memory.reg[0x%lx].base   = 0x%llx\n", i,
-			(long long unsigned)lmb->memory.region[i].base);
+			(long long unsigned)mem[i].base);
 		debug("		   .size   = 0x%llx\n",
-			(long long unsigned)lmb->memory.region[i].size);
+			(long long unsigned)mem[i].size);
 	}
 
 	debug("\n    reserved.cnt	   = 0x%lx\n",
@@ -33,139 +36,142 @@ void lmb_dump_all(struct lmb *lmb)
 		(long long unsigned)lmb->reserved.size);
 	for (i=0; i < lmb->reserved.cnt ;i++) {
 		debug("    reserved.reg[0x%lx].base = 0x%llx\n", i,
-			(long long unsigned)lmb->reserved.region[i].base);
+			(long long unsigned)res[i].base);
 		debug("		     .size = 0x%llx\n",
-			(long long unsigned)lmb->reserved.region[i].size);
+			(long long unsigned)res[i].size);
 	}
 #endif /* DEBUG */
 }
 
-static long lmb_addrs_overlap(phys_addr_t base1,
-		phys_size_t size1, phys_addr_t base2, phys_size_t size2)
+/* Last address of a region, which avoids overflow at the top of memory */
+static phys_addr_t lmb_last(phys_addr_t base, phys_size_t size)
 {
-	return ((base1 < (base2+size2)) && (base2 < (base1+size1)));
+	return base + size - 1;
 }
 
-static long lmb_addrs_adjacent(phys_addr_t base1, phys_size_t size1,
-		phys_addr_t base2, phys_size_t size2)
+/*
+ * Find the first region which does not end below @addr. Regions are kept
+ * sorted, without overlaps, so a binary search will do.
+ *
+ * @touch: also skip regions which end right below @addr
+ * @return index of the region or rgn->cnt if there is none
+ */
+static unsigned long lmb_search(struct lmb_region *rgn, phys_addr_t addr,
+				bool touch)
 {
-	if (base2 == base1 + size1)
-		return 1;
-	else if (base1 == base2 + size2)
-		return -1;
+	unsigned long lo = 0, hi = rgn->cnt;
 
-	return 0;
+	while (lo < hi) {
+		unsigned long mid = lo + (hi - lo) / 2;
+		phys_addr_t last = lmb_last(lmb_regions(rgn)[mid].base,
+					    lmb_regions(rgn)[mid].size);
+
+		if (last < addr && !(touch && addr - last == 1))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
 }
 
-static long lmb_regions_adjacent(struct lmb_region *rgn,
-		unsigned long r1, unsigned long r2)
+static void lmb_remove_regions(struct lmb_region *rgn, unsigned long r,
+			       unsigned long n)
 {
-	phys_addr_t base1 = rgn->region[r1].base;
-	phys_size_t size1 = rgn->region[r1].size;
-	phys_addr_t base2 = rgn->region[r2].base;
-	phys_size_t size2 = rgn->region[r2].size;
-
-	return lmb_addrs_adjacent(base1, size1, base2, size2);
+	memmove(&lmb_regions(rgn)[r], &lmb_regions(rgn)[r + n],
+		(rgn->cnt - r - n) * sizeof(lmb_regions(rgn)[0]));
+	rgn->cnt -= n;
 }
 
 static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
 {
-	unsigned long i;
-
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
-	}
-	rgn->cnt--;
+	lmb_remove_regions(rgn, r, 1);
 }
 
-/* Assumption: base addr of region 1 < base addr of region 2 */
-static void lmb_coalesce_regions(struct lmb_region *rgn,
-		unsigned long r1, unsigned long r2)
+static void lmb_init_region(struct lmb_region *rgn)
 {
-	rgn->region[r1].size += rgn->region[r2].size;
-	lmb_remove_region(rgn, r2);
+	rgn->heap = NULL;
+	rgn->max = ARRAY_SIZE(rgn->initial);
+	rgn->cnt = 0;
+	rgn->size = 0;
 }
 
 void lmb_init(struct lmb *lmb)
 {
-	/* Create a dummy zero size LMB which will get coalesced away later.
-	 * This simplifies the lmb_add() code below...
-	 */
-	lmb->memory.region[0].base = 0;
-	lmb->memory.region[0].size = 0;
-	lmb->memory.cnt = 1;
-	lmb->memory.size = 0;
-
-	/* Ditto. */
-	lmb->reserved.region[0].base = 0;
-	lmb->reserved.region[0].size = 0;
-	lmb->reserved.cnt = 1;
-	lmb->reserved.size = 0;
+	lmb_init_region(&lmb->memory);
+	lmb_init_region(&lmb->reserved);
 }
 
-/* This routine called with relocation disabled. */
-static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
+void lmb_release(struct lmb *lmb)
 {
-	unsigned long coalesced = 0;
-	long adjacent, i;
+	free(lmb->memory.heap);
+	free(lmb->reserved.heap);
+	lmb_init(lmb);
+}
 
-	if ((rgn->cnt == 1) && (rgn->region[0].size == 0)) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		return 0;
+/* Double the capacity of a region array once it is full */
+static int lmb_grow_region(struct lmb_region *rgn)
+{
+	struct lmb_property *region;
+	unsigned long max = 2 * rgn->max;
+
+	if (!rgn->heap) {
+		region = malloc(max * sizeof(*region));
+		if (region)
+			memcpy(region, rgn->initial, sizeof(rgn->initial));
+	} else {
+		region = realloc(rgn->heap, max * sizeof(*region));
 	}
+	if (!region)
+		return -ENOMEM;
+	rgn->heap = region;
+	rgn->max = max;
 
-	/* First try and coalesce this LMB with another. */
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-
-		if ((rgnbase == base) && (rgnsize == size))
-			/* Already have this region, so we're done */
-			return 0;
+	return 0;
+}
 
-		adjacent = lmb_addrs_adjacent(base,size,rgnbase,rgnsize);
-		if ( adjacent > 0 ) {
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		}
-		else if ( adjacent < 0 ) {
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		}
-	}
+/*
+ * Add a region to the sorted table. Regions which overlap or touch the new
+ * one are merged with it.
+ *
+ * @return 0 if a new region was added, the number of merged regions if the
+ * region was coalesced, -1 on error
+ */
+static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
+{
+	phys_addr_t last = lmb_last(base, size);
+	unsigned long first, i;
 
-	if ((i < rgn->cnt-1) && lmb_regions_adjacent(rgn, i, i+1) ) {
-		lmb_coalesce_regions(rgn, i, i+1);
-		coalesced++;
-	}
+	if (!size)
+		return 0;
 
-	if (coalesced)
-		return coalesced;
-	if (rgn->cnt >= MAX_LMB_REGIONS)
-		return -1;
+	/* Find all regions overlapping or adjacent to the new one */
+	first = lmb_search(rgn, base, true);
+	for (i = first; i < rgn->cnt; i++) {
+		phys_addr_t rgnbase = lmb_regions(rgn)[i].base;
+		phys_addr_t rgnlast = lmb_last(rgnbase,
+					       lmb_regions(rgn)[i].size);
 
-	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i+1].base = rgn->region[i].base;
-			rgn->region[i+1].size = rgn->region[i].size;
-		} else {
-			rgn->region[i+1].base = base;
-			rgn->region[i+1].size = size;
+		if (rgnbase > last && rgnbase - last > 1)
 			break;
-		}
+		base = min(base, rgnbase);
+		last = max(last, rgnlast);
 	}
 
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
+	if (i > first) {
+		lmb_regions(rgn)[first].base = base;
+		lmb_regions(rgn)[first].size = last - base + 1;
+		lmb_remove_regions(rgn, first + 1, i - first - 1);
+		return i - first;
 	}
 
+	if (rgn->cnt == rgn->max && lmb_grow_region(rgn))
+		return -1;
+
+	memmove(&lmb_regions(rgn)[first + 1], &lmb_regions(rgn)[first],
+		(rgn->cnt - first) * sizeof(lmb_regions(rgn)[0]));
+	lmb_regions(rgn)[first].base = base;
+	lmb_regions(rgn)[first].size = size;
 	rgn->cnt++;
 
 	return 0;
@@ -184,21 +190,18 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	struct lmb_region *rgn = &(lmb->reserved);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size;
-	int i;
-
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	unsigned long i;
 
 	/* Find the region where (base, size) belongs to */
-	for (i=0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_search(rgn, base, false);
+	if (i == rgn->cnt)
+		return -1;
+	rgnbegin = lmb_regions(rgn)[i].base;
+	rgnend = rgnbegin + lmb_regions(rgn)[i].size;
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if (rgnbegin > base ||
+	    lmb_last(base, size) > lmb_last(rgnbegin, lmb_regions(rgn)[i].size))
 		return -1;
 
 	/* Check to see if we are removing entire region */
@@ -209,14 +212,14 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 
 	/* Check to see if region is matching at the front */
 	if (rgnbegin == base) {
-		rgn->region[i].base = end;
-		rgn->region[i].size -= size;
+		lmb_regions(rgn)[i].base = end;
+		lmb_regions(rgn)[i].size -= size;
 		return 0;
 	}
 
 	/* Check to see if the region is matching at the end */
 	if (rgnend == end) {
-		rgn->region[i].size -= size;
+		lmb_regions(rgn)[i].size -= size;
 		return 0;
 	}
 
@@ -224,7 +227,7 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	 * We need to split the entry -  adjust the current one to the
 	 * beginging of the hole and add the region after hole.
 	 */
-	rgn->region[i].size = base - rgn->region[i].base;
+	lmb_regions(rgn)[i].size = base - lmb_regions(rgn)[i].base;
 	return lmb_add_region(rgn, end, rgnend - end);
 }
 
@@ -240,15 +243,13 @@ static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 {
 	unsigned long i;
 
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if ( lmb_addrs_overlap(base,size,rgnbase,rgnsize) ) {
-			break;
-		}
-	}
+	if (!size)
+		return -1;
+	i = lmb_search(rgn, base, false);
+	if (i < rgn->cnt && lmb_regions(rgn)[i].base <= lmb_last(base, size))
+		return i;
 
-	return (i < rgn->cnt) ? i : -1;
+	return -1;
 }
 
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
@@ -286,8 +287,8 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 	phys_addr_t res_base;
 
 	for (i = lmb->memory.cnt-1; i >= 0; i--) {
-		phys_addr_t lmbbase = lmb->memory.region[i].base;
-		phys_size_t lmbsize = lmb->memory.region[i].size;
+		phys_addr_t lmbbase = lmb_regions(&lmb->memory)[i].base;
+		phys_size_t lmbsize = lmb_regions(&lmb->memory)[i].size;
 
 		if (lmbsize < size)
 			continue;
@@ -312,7 +313,7 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 					return 0;
 				return base;
 			}
-			res_base = lmb->reserved.region[j].base;
+			res_base = lmb_regions(&lmb->reserved)[j].base;
 			if (res_base < size)
 				break;
 			base = lmb_align_down(res_base - size, align);
@@ -323,15 +324,7 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
-
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return 1;
-	}
-	return 0;
+	return lmb_overlaps_region(&lmb->reserved, addr, 1) >= 0;
 }
 
 __weak void board_lmb_reserve(struct lmb *lmb)
@@ -14,6 +14,7 @@
 #include <malloc.h>
 #include <dm/of_access.h>
 #include <linux/err.h>
+#include <u-boot/crc.h>
 
 static void *unflatten_dt_alloc(void **mem, unsigned long size,
 				unsigned long align)
@@ -314,6 +315,27 @@ static int unflatten_device_tree(const void *blob,
 	return 0;
 }
 
+/* Set up aliases and the phandle cache for a new live tree */
+static int of_live_init(struct device_node *root)
+{
+	int ret;
+
+	ret = of_alias_scan();
+	if (ret) {
+		debug("Failed to scan live tree aliases: err=%d\n", ret);
+		return ret;
+	}
+	if (CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)) {
+		ret = of_populate_phandle_cache(root);
+		if (ret) {
+			debug("Failed to create phandle cache: err=%d\n", ret);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
 int of_live_build(const void *fdt_blob, struct device_node **rootp)
 {
 	int ret;
@@ -324,12 +346,95 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 		debug("Failed to create live tree: err=%d\n", ret);
 		return ret;
 	}
-	ret = of_alias_scan();
+	ret = of_live_init(*rootp);
+	debug("%s: stop\n", __func__);
+
+	return ret;
+}
+
+/* Turn a reference in a pack into a pointer into the flat tree or pack */
+static void *of_live_pack_ref(const void *fdt_blob, const char *strings,
+			      fdt32_t ref)
+{
+	u32 ofs = fdt32_to_cpu(ref);
+
+	if (ofs & OF_LIVE_PACK_STR)
+		return (void *)strings + (ofs & ~OF_LIVE_PACK_STR);
+
+	return (void *)fdt_blob + ofs;
+}
+
+#define OF_LIVE_PACK_PTR(base, idx)	\
+	(fdt32_to_cpu(idx) == OF_LIVE_PACK_NONE ? NULL : \
+	 &(base)[fdt32_to_cpu(idx)])
+
+int of_live_unpack(const void *pack, const void *fdt_blob,
+		   struct device_node **rootp)
+{
+	const struct of_live_pack *hdr = pack;
+	const struct of_live_pack_node *pn;
+	const struct of_live_pack_prop *pprop;
+	struct device_node *nodes, *np;
+	struct property *props, *pp;
+	u32 node_count, prop_count;
+	const char *strings;
+	u32 i;
+
+	if (fdt32_to_cpu(hdr->magic) != OF_LIVE_PACK_MAGIC ||
+	    fdt32_to_cpu(hdr->version) != OF_LIVE_PACK_VERSION)
+		return -ENOENT;
+	node_count = fdt32_to_cpu(hdr->node_count);
+	prop_count = fdt32_to_cpu(hdr->prop_count);
+	if (!node_count || fdt32_to_cpu(hdr->off_strings) != sizeof(*hdr) +
+	    node_count * sizeof(*pn) + prop_count * sizeof(*pprop))
+		return -ENOENT;
+	if (fdt32_to_cpu(hdr->fdt_size) != fdt_totalsize(fdt_blob) ||
+	    fdt32_to_cpu(hdr->fdt_crc) != crc32(0, fdt_blob,
+						fdt_totalsize(fdt_blob))) {
+		debug("Packed live tree is for a different flat tree\n");
+		return -ESTALE;
+	}
+
+	nodes = malloc(node_count * sizeof(*np) + prop_count * sizeof(*pp));
+	if (!nodes)
+		return -ENOMEM;
+	props = (struct property *)(nodes + node_count);
+	pn = pack + sizeof(*hdr);
+	pprop = (const struct of_live_pack_prop *)(pn + node_count);
+	strings = pack + fdt32_to_cpu(hdr->off_strings);
+
+	for (i = 0, np = nodes; i < node_count; i++, np++, pn++) {
+		np->name = of_live_pack_ref(fdt_blob, strings, pn->name);
+		np->type = of_live_pack_ref(fdt_blob, strings, pn->type);
+		np->phandle = fdt32_to_cpu(pn->phandle);
+		np->full_name = of_live_pack_ref(fdt_blob, strings,
+						 pn->full_name);
+		np->properties = OF_LIVE_PACK_PTR(props, pn->properties);
+		np->parent = OF_LIVE_PACK_PTR(nodes, pn->parent);
+		np->child = OF_LIVE_PACK_PTR(nodes, pn->child);
+		np->sibling = OF_LIVE_PACK_PTR(nodes, pn->sibling);
+	}
+	for (i = 0, pp = props; i < prop_count; i++, pp++, pprop++) {
+		pp->name = of_live_pack_ref(fdt_blob, strings, pprop->name);
+		pp->length = fdt32_to_cpu(pprop->length);
+		pp->value = of_live_pack_ref(fdt_blob, strings, pprop->value);
+		pp->next = OF_LIVE_PACK_PTR(props, pprop->next);
+	}
+	*rootp = nodes;
+
+	return 0;
+}
+
+int of_live_adopt(const void *pack, const void *fdt_blob,
+		  struct device_node **rootp)
+{
+	int ret;
+
+	ret = of_live_unpack(pack, fdt_blob, rootp);
 	if (ret) {
-		debug("Failed to scan live tree aliases: err=%d\n", ret);
+		debug("Failed to unpack live tree: err=%d\n", ret);
 		return ret;
 	}
-	debug("%s: stop\n", __func__);
 
-	return ret;
+	return of_live_init(*rootp);
 }
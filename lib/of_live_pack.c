@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Write a live tree in packed form, so that it can be set up at run time
+ * without parsing the flat tree. See struct of_live_pack for the format.
+ *
+ * This is built into the of_live_pack host tool as well as U-Boot.
+ */
+
+#ifndef USE_HOSTCC
+#include <common.h>
+#include <linux/libfdt.h>
+#else
+#include "fdt_host.h"
+#endif
+#include <of_live.h>
+#include <u-boot/crc.h>
+
+/**
+ * struct of_pack_ctx - State while writing a packed live tree
+ *
+ * @fdt: Flat tree being packed
+ * @nodes: Node array in the pack, or NULL to just count
+ * @props: Property array in the pack
+ * @strings: String table in the pack
+ * @node_count: Number of nodes so far
+ * @prop_count: Number of properties so far
+ * @str_size: Size of the string table so far
+ * @null_ref: Reference to the "<NULL>" string
+ * @name_ref: Reference to the "name" string
+ */
+struct of_pack_ctx {
+	const void *fdt;
+	struct of_live_pack_node *nodes;
+	struct of_live_pack_prop *props;
+	char *strings;
+	int node_count;
+	int prop_count;
+	int str_size;
+	uint32_t null_ref;
+	uint32_t name_ref;
+};
+
+/* Add a string of @len bytes plus a terminator to the string table */
+static uint32_t of_pack_str(struct of_pack_ctx *ctx, const char *str, int len)
+{
+	uint32_t ref = OF_LIVE_PACK_STR | ctx->str_size;
+
+	if (ctx->nodes) {
+		memcpy(ctx->strings + ctx->str_size, str, len);
+		ctx->strings[ctx->str_size + len] = '\0';
+	}
+	ctx->str_size += len + 1;
+
+	return ref;
+}
+
+static uint32_t of_pack_fdt_ref(struct of_pack_ctx *ctx, const void *ptr)
+{
+	return (const char *)ptr - (const char *)ctx->fdt;
+}
+
+/* Add a property, linking it after @prev or as the first of @node */
+static int of_pack_prop(struct of_pack_ctx *ctx, int node, int prev,
+			uint32_t name, int length, uint32_t value)
+{
+	struct of_live_pack_prop *pp;
+	int idx = ctx->prop_count++;
+
+	if (!ctx->nodes)
+		return idx;
+	pp = &ctx->props[idx];
+	pp->name = cpu_to_fdt32(name);
+	pp->length = cpu_to_fdt32(length);
+	pp->value = cpu_to_fdt32(value);
+	pp->next = cpu_to_fdt32(OF_LIVE_PACK_NONE);
+	if (prev != -1)
+		ctx->props[prev].next = cpu_to_fdt32(idx);
+	else
+		ctx->nodes[node].properties = cpu_to_fdt32(idx);
+
+	return idx;
+}
+
+/*
+ * Add the properties of a node, working out its name, type and phandle in
+ * the same way as of_live_build()
+ */
+static int of_pack_props(struct of_pack_ctx *ctx, int offset, int node)
+{
+	uint32_t name = OF_LIVE_PACK_NONE, type = ctx->null_ref;
+	const char *pname, *unit, *at;
+	int poffset, len, prev = -1;
+	uint32_t phandle = 0;
+	const void *val;
+
+	fdt_for_each_property_offset(poffset, ctx->fdt, offset) {
+		val = fdt_getprop_by_offset(ctx->fdt, poffset, &pname, &len);
+		if (!val)
+			return len;
+		if (!strcmp(pname, "name")) {
+			if (name == OF_LIVE_PACK_NONE)
+				name = of_pack_fdt_ref(ctx, val);
+		} else if (!strcmp(pname, "device_type")) {
+			if (type == ctx->null_ref)
+				type = of_pack_fdt_ref(ctx, val);
+		} else if (!strcmp(pname, "phandle") ||
+			   !strcmp(pname, "linux,phandle")) {
+			if (!phandle)
+				phandle = fdt32_to_cpu(*(fdt32_t *)val);
+		} else if (!strcmp(pname, "ibm,phandle")) {
+			phandle = fdt32_to_cpu(*(fdt32_t *)val);
+		}
+		prev = of_pack_prop(ctx, node, prev,
+				    of_pack_fdt_ref(ctx, pname), len,
+				    of_pack_fdt_ref(ctx, val));
+	}
+	if (poffset != -FDT_ERR_NOTFOUND)
+		return poffset;
+
+	/* Create a name property from the unit name if there is none */
+	if (name == OF_LIVE_PACK_NONE) {
+		unit = fdt_get_name(ctx->fdt, offset, &len);
+		at = strrchr(unit, '@');
+		if (at)
+			len = at - unit;
+		name = of_pack_str(ctx, unit, len);
+		of_pack_prop(ctx, node, prev, ctx->name_ref, len + 1, name);
+	}
+
+	if (ctx->nodes) {
+		ctx->nodes[node].name = cpu_to_fdt32(name);
+		ctx->nodes[node].type = cpu_to_fdt32(type);
+		ctx->nodes[node].phandle = cpu_to_fdt32(phandle);
+	}
+
+	return 0;
+}
+
+/* Add a node's full path, e.g. "/" for the root and "/bus@1/spi@1100" */
+static uint32_t of_pack_path(struct of_pack_ctx *ctx, uint32_t parent_path,
+			     int parent_len, const char *name, int len)
+{
+	uint32_t ref = OF_LIVE_PACK_STR | ctx->str_size;
+	char *str;
+
+	if (ctx->nodes) {
+		str = ctx->strings + ctx->str_size;
+		memcpy(str, ctx->strings + (parent_path & ~OF_LIVE_PACK_STR),
+		       parent_len);
+		str[parent_len] = '/';
+		memcpy(str + parent_len + 1, name, len);
+		str[parent_len + 1 + len] = '\0';
+	}
+	ctx->str_size += parent_len + len + 2;
+
+	return ref;
+}
+
+/* Add every node in the flat tree, in order */
+static int of_pack_tree(struct of_pack_ctx *ctx)
+{
+	int parent[FDT_MAX_DEPTH], last[FDT_MAX_DEPTH + 1];
+	int path_len[FDT_MAX_DEPTH];
+	uint32_t path[FDT_MAX_DEPTH];
+	struct of_live_pack_node *np;
+	int offset, depth, node, len, ret;
+	const char *name;
+
+	ctx->node_count = 0;
+	ctx->prop_count = 0;
+	ctx->str_size = 0;
+	ctx->null_ref = of_pack_str(ctx, "<NULL>", 6);
+	ctx->name_ref = of_pack_str(ctx, "name", 4);
+
+	for (offset = 0, depth = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(ctx->fdt, offset, &depth)) {
+		if (depth >= FDT_MAX_DEPTH)
+			return -FDT_ERR_BADSTRUCTURE;
+		node = ctx->node_count++;
+		parent[depth] = node;
+		last[depth + 1] = -1;
+
+		/* The root node has an empty name, so its path is just "/" */
+		name = fdt_get_name(ctx->fdt, offset, &len);
+		if (!name)
+			return len;
+		if (depth > 1) {
+			path[depth] = of_pack_path(ctx, path[depth - 1],
+						   path_len[depth - 1], name,
+						   len);
+			path_len[depth] = path_len[depth - 1] + 1 + len;
+		} else {
+			path[depth] = of_pack_path(ctx, 0, 0, name, len);
+			path_len[depth] = 1 + len;
+		}
+
+		if (ctx->nodes) {
+			np = &ctx->nodes[node];
+			np->full_name = cpu_to_fdt32(path[depth]);
+			np->properties = cpu_to_fdt32(OF_LIVE_PACK_NONE);
+			np->parent = cpu_to_fdt32(OF_LIVE_PACK_NONE);
+			np->child = cpu_to_fdt32(OF_LIVE_PACK_NONE);
+			np->sibling = cpu_to_fdt32(OF_LIVE_PACK_NONE);
+			if (depth) {
+				np->parent = cpu_to_fdt32(parent[depth - 1]);
+				if (last[depth] != -1)
+					ctx->nodes[last[depth]].sibling =
+						cpu_to_fdt32(node);
+				else
+					ctx->nodes[parent[depth - 1]].child =
+						cpu_to_fdt32(node);
+			}
+		}
+		last[depth] = node;
+
+		ret = of_pack_props(ctx, offset, node);
+		if (ret)
+			return ret;
+	}
+	if (offset < 0 && offset != -FDT_ERR_NOTFOUND)
+		return offset;
+
+	return 0;
+}
+
+int of_live_pack_fdt(const void *fdt_blob, void *buf, int size)
+{
+	struct of_pack_ctx ctx = { .fdt = fdt_blob };
+	struct of_live_pack *hdr = buf;
+	int off_strings, totalsize;
+	int ret;
+
+	ret = fdt_check_header(fdt_blob);
+	if (ret)
+		return ret;
+	ret = of_pack_tree(&ctx);
+	if (ret)
+		return ret;
+	off_strings = sizeof(*hdr) +
+		ctx.node_count * sizeof(struct of_live_pack_node) +
+		ctx.prop_count * sizeof(struct of_live_pack_prop);
+	totalsize = (off_strings + ctx.str_size + 3) & ~3;
+	if (!buf)
+		return totalsize;
+	if (size < totalsize)
+		return -FDT_ERR_NOSPACE;
+
+	memset(buf, '\0', totalsize);
+	ctx.nodes = buf + sizeof(*hdr);
+	ctx.props = (void *)(ctx.nodes + ctx.node_count);
+	ctx.strings = buf + off_strings;
+	ret = of_pack_tree(&ctx);
+	if (ret)
+		return ret;
+
+	hdr->magic = cpu_to_fdt32(OF_LIVE_PACK_MAGIC);
+	hdr->version = cpu_to_fdt32(OF_LIVE_PACK_VERSION);
+	hdr->totalsize = cpu_to_fdt32(totalsize);
+	hdr->fdt_size = cpu_to_fdt32(fdt_totalsize(fdt_blob));
+	hdr->fdt_crc = cpu_to_fdt32(crc32(0, fdt_blob,
+					  fdt_totalsize(fdt_blob)));
+	hdr->node_count = cpu_to_fdt32(ctx.node_count);
+	hdr->prop_count = cpu_to_fdt32(ctx.prop_count);
+	hdr->off_strings = cpu_to_fdt32(off_strings);
+
+	return totalsize;
+}
@@ -4,7 +4,11 @@
  */
 
 #include <common.h>
+#include <console.h>
 #include <dm.h>
+#include <membuff.h>
+#include <os.h>
+#include <sandboxblockdev.h>
 #include <usb.h>
 #include <asm/state.h>
 #include <dm/test.h>
@@ -167,3 +171,122 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_CMD_BLK_STATS
+/* Test that I/O statistics are recorded for a block device */
+static int dm_test_blk_stats(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct blk_op_stats *st;
+	struct udevice *dev;
+	char buf[1024];
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	blk_reset_stats(dev_desc->bdev);
+
+	ut_asserteq(2, blk_dread(dev_desc, 0, 2, buf));
+	ut_asserteq(1, blk_dread(dev_desc, 4, 1, buf));
+
+	st = &dev_desc->stats.op[BLK_STATS_READ];
+	ut_asserteq(2, st->ops);
+	ut_asserteq(3, st->blocks);
+	ut_asserteq(0, st->errors);
+	ut_asserteq(1, st->hist[0]);
+	ut_asserteq(1, st->hist[1]);
+	ut_assert(st->min_us <= st->max_us);
+	ut_asserteq(0, dev_desc->stats.op[BLK_STATS_WRITE].ops);
+
+	ut_assertok(run_command("blk stats", 0));
+	ut_assertok(run_command("blk stats reset", 0));
+	ut_asserteq(0, st->ops);
+	ut_asserteq(0, st->blocks);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_stats, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
+
+/* Get the number which follows @key in @buf */
+static ulong bench_value(const char *buf, const char *key)
+{
+	const char *p = strstr(buf, key);
+
+	return p ? simple_strtoul(p + strlen(key), NULL, 10) : ~0UL;
+}
+
+/* Run a 'bench' command and check the figures that it prints */
+static int check_bench(struct unit_test_state *uts, const char *cmd,
+		       const char *name, ulong bytes)
+{
+	ulong min_us, p50, p90, p99, max_us;
+	char buf[256], expect[40];
+	int ret, len;
+
+	console_record_reset_enable();
+	ret = run_command(cmd, 0);
+	gd->flags &= ~GD_FLG_RECORD;
+	ut_assertok(ret);
+	len = membuff_get(&gd->console_out, buf, sizeof(buf) - 1);
+	buf[len] = '\0';
+
+	snprintf(expect, sizeof(expect), "%s: %lu bytes in ", name, bytes);
+	ut_assert(strstr(buf, expect));
+	ut_assert(strstr(buf, " MB/s, "));
+	ut_assert(strstr(buf, " IOPS\n"));
+
+	min_us = bench_value(buf, "latency us: min ");
+	p50 = bench_value(buf, " p50 ");
+	p90 = bench_value(buf, " p90 ");
+	p99 = bench_value(buf, " p99 ");
+	max_us = bench_value(buf, " max ");
+	ut_assert(max_us != ~0UL);
+	ut_assert(min_us <= p50);
+	ut_assert(p50 <= p90);
+	ut_assert(p90 <= p99);
+	ut_assert(p99 <= max_us);
+
+	return 0;
+}
+
+/* Test the 'bench' command with a file-backed host block device */
+static int dm_test_blk_bench(struct unit_test_state *uts)
+{
+	char fname[] = "bench-test.img";
+	struct blk_desc *dev_desc;
+	char buf[0x1000];
+	int fd, i;
+
+	/* Create a 64KB backing file */
+	fd = os_open(fname, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	memset(buf, '\0', sizeof(buf));
+	for (i = 0; i < 16; i++)
+		ut_asserteq(sizeof(buf), os_write(fd, buf, sizeof(buf)));
+	os_close(fd);
+	ut_assertok(host_dev_bind(0, fname));
+	ut_assertok(blk_get_device_by_str("host", "0", &dev_desc));
+
+	ut_assertok(check_bench(uts, "bench blk host 0 write 0 10000 1000",
+				"write", 0x10000));
+	ut_asserteq(1, blk_dread(dev_desc, 0x10, 1, buf));
+	for (i = 0; i < 0x200; i++)
+		ut_asserteq(i & 0xff, (u8)buf[i]);
+	ut_assertok(check_bench(uts, "bench blk host 0 read 0 10000 1000",
+				"read", 0x10000));
+	ut_assertok(check_bench(uts, "bench blk host 0 randread 0 10000 200",
+				"randread", 0x10000));
+	ut_assertok(check_bench(uts, "bench blk host 0 randwrite 8000 8000 400",
+				"randwrite", 0x8000));
+
+	/* Unaligned and out-of-range requests should fail */
+	ut_asserteq(1, run_command("bench blk host 0 read 0 10000 100", 0));
+	ut_asserteq(1, run_command("bench blk host 0 read 0 20000 1000", 0));
+	ut_asserteq(1, run_command("bench blk host 0 seek 0 10000 1000", 0));
+
+	ut_assertok(host_dev_bind(0, NULL));
+	ut_assertok(os_unlink(fname));
+
+	return 0;
+}
+DM_TEST(dm_test_blk_bench, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -5,6 +5,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <malloc.h>
 #include <dm/device-internal.h>
 #include <dm/test.h>
 #include <dm/uclass-internal.h>
@@ -453,6 +454,55 @@ static int dm_test_bus_parent_platdata_uclass(struct unit_test_state *uts)
 DM_TEST(dm_test_bus_parent_platdata_uclass,
 	DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/* Test that a child's platform data is allocated along with the device */
+static int dm_test_bus_device_arena(struct unit_test_state *uts)
+{
+	const uint alloc_flags = DM_FLAG_ALLOC_PDATA |
+		DM_FLAG_ALLOC_UCLASS_PDATA | DM_FLAG_ALLOC_PARENT_PDATA;
+	struct mallinfo before, after;
+	struct udevice *bus, *dev;
+	int child_count, parent_size, arena_size = 0;
+
+	ut_assertok(uclass_get_device(UCLASS_TEST_BUS, 0, &bus));
+	parent_size = bus->driver->per_child_platdata_auto_alloc_size;
+	for (device_find_first_child(bus, &dev), child_count = 0;
+	     dev;
+	     device_find_next_child(&dev)) {
+		ut_assertnonnull(dev->platdata);
+		ut_assertnonnull(dev->parent_platdata);
+		if (CONFIG_IS_ENABLED(DM_DEVICE_ARENA)) {
+			/* Nothing should need to be freed separately */
+			ut_asserteq(0, dev->flags & alloc_flags);
+			ut_assert(dev->platdata >= (void *)(dev + 1));
+			ut_assert(dev->parent_platdata > dev->platdata);
+			ut_assert(dev->parent_platdata + parent_size <=
+				  (void *)dev + malloc_usable_size(dev));
+			/* The block and its malloc() header */
+			arena_size += malloc_usable_size(dev) + sizeof(size_t);
+		} else {
+			ut_asserteq(alloc_flags & ~DM_FLAG_ALLOC_UCLASS_PDATA,
+				    dev->flags & alloc_flags);
+		}
+		child_count++;
+	}
+	ut_asserteq(3, child_count);
+
+	/* Unbinding the children should release all their bind-time data */
+	before = mallinfo();
+	do {
+		device_find_first_child(bus, &dev);
+		if (dev)
+			ut_assertok(device_unbind(dev));
+	} while (dev);
+	after = mallinfo();
+	ut_assert(after.uordblks < before.uordblks);
+	if (CONFIG_IS_ENABLED(DM_DEVICE_ARENA))
+		ut_asserteq(arena_size, before.uordblks - after.uordblks);
+
+	return 0;
+}
+DM_TEST(dm_test_bus_device_arena, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /* Test that the child post_bind method is called */
 static int dm_test_bus_child_post_bind(struct unit_test_state *uts)
 {
@@ -70,6 +70,11 @@ static struct driver_info driver_info_act_dma = {
 	.name = "test_act_dma_drv",
 };
 
+static struct driver_info driver_info_async = {
+	.name = "test_async_drv",
+	.platdata = &test_pdata_manual,
+};
+
 void dm_leak_check_start(struct unit_test_state *uts)
 {
 	uts->start = mallinfo();
@@ -91,6 +96,8 @@ int dm_leak_check_end(struct unit_test_state *uts)
 			continue;
 		ut_assertok(uclass_destroy(uc));
 	}
+	/* Deferred nodes under the root device are still recorded */
+	dm_lazy_forget(dm_root());
 
 	end = mallinfo();
 	diff = end.uordblks - uts->start.uordblks;
@@ -659,6 +666,103 @@ static int dm_test_pre_reloc(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_pre_reloc, 0);
 
+/* Test that probing can be split into start and complete phases */
+static int dm_test_probe_start(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct udevice *dev, *dev2;
+
+	ut_assertok(device_bind_by_name(dms->root, false, &driver_info_async,
+					&dev));
+	ut_assertok(device_bind_by_name(dms->root, false, &driver_info_async,
+					&dev2));
+
+	/* Starting the probe calls probe_start() but not probe() */
+	ut_assertok(device_probe_start(dev));
+	ut_asserteq(1, dm_testdrv_op_count[DM_TEST_OP_PROBE_START]);
+	ut_asserteq(0, dm_testdrv_op_count[DM_TEST_OP_PROBE]);
+	ut_assert(dev->flags & DM_FLAG_PROBE_PENDING);
+	ut_assert(!device_active(dev));
+
+	/* Starting it again does nothing */
+	ut_assertok(device_probe_start(dev));
+	ut_asserteq(1, dm_testdrv_op_count[DM_TEST_OP_PROBE_START]);
+
+	/* A normal probe completes it */
+	ut_assertok(device_probe(dev));
+	ut_asserteq(1, dm_testdrv_op_count[DM_TEST_OP_PROBE]);
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_PENDING));
+	ut_assert(device_active(dev));
+	ut_assertok(device_probe(dev));
+	ut_asserteq(1, dm_testdrv_op_count[DM_TEST_OP_PROBE]);
+
+	/* Removing a device whose probe is started clears the flag */
+	ut_assertok(device_probe_start(dev2));
+	ut_assertok(device_remove(dev2, DM_REMOVE_NORMAL));
+	ut_assert(!(dev2->flags & DM_FLAG_PROBE_PENDING));
+	ut_asserteq(1, dm_testdrv_op_count[DM_TEST_OP_PROBE]);
+
+	/* Start and complete everything from the top */
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(dm_probe_start_all());
+	ut_asserteq(4, dm_testdrv_op_count[DM_TEST_OP_PROBE_START]);
+	ut_asserteq(1, dm_testdrv_op_count[DM_TEST_OP_PROBE]);
+	ut_assertok(dm_probe_complete_all());
+	ut_asserteq(3, dm_testdrv_op_count[DM_TEST_OP_PROBE]);
+	ut_assert(device_active(dev));
+	ut_assert(device_active(dev2));
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_PENDING));
+	ut_assert(!(dev2->flags & DM_FLAG_PROBE_PENDING));
+
+	/* Drivers without probe_start() are probed straight away */
+	ut_assertok(device_bind_by_name(dms->root, false, &driver_info_manual,
+					&dev));
+	ut_assertok(device_probe_start(dev));
+	ut_asserteq(4, dm_testdrv_op_count[DM_TEST_OP_PROBE]);
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_PENDING));
+
+	return 0;
+}
+DM_TEST(dm_test_probe_start, 0);
+
+/* Test that starting slow devices together overlaps their probe time */
+static int dm_test_probe_start_overlap(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct dm_test_priv *priv, *priv2;
+	struct udevice *dev, *dev2;
+	ulong start;
+
+	ut_assertok(device_bind_by_name(dms->root, false, &driver_info_async,
+					&dev));
+	ut_assertok(device_bind_by_name(dms->root, false, &driver_info_async,
+					&dev2));
+
+	/* Probing one after the other waits for each device in turn */
+	start = get_timer(0);
+	ut_assertok(device_probe(dev));
+	ut_assertok(device_probe(dev2));
+	ut_assert(get_timer(start) >= 2 * DM_TEST_ASYNC_DELAY_MS);
+	priv = dev_get_priv(dev);
+	priv2 = dev_get_priv(dev2);
+	ut_assert(priv->ready_seq < priv2->wait_seq);
+
+	/* Starting both first means that each waits while the other does */
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_remove(dev2, DM_REMOVE_NORMAL));
+	ut_assertok(dm_probe_start_all());
+	ut_assertok(dm_probe_complete_all());
+	ut_assert(device_active(dev));
+	ut_assert(device_active(dev2));
+	priv = dev_get_priv(dev);
+	priv2 = dev_get_priv(dev2);
+	ut_assert(priv->wait_seq < priv2->ready_seq);
+	ut_assert(priv2->wait_seq < priv->ready_seq);
+
+	return 0;
+}
+DM_TEST(dm_test_probe_start_overlap, 0);
+
 /*
  * Test that removal of devices, either via the "normal" device_remove()
  * API or via the device driver selective flag works as expected
@@ -737,6 +841,66 @@ static int dm_test_uclass_before_ready(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_uclass_before_ready, 0);
 
+/* Check that the uclass table gives the same results as the list */
+static int dm_test_uclass_table(struct unit_test_state *uts)
+{
+	struct uclass **table = gd->uclass_table;
+	struct uclass *uc, *list_uc;
+	int id;
+
+	ut_assertnonnull(table);
+	for (id = 0; id < UCLASS_COUNT; id++) {
+		uc = uclass_find(id);
+		gd->uclass_table = NULL;
+		list_uc = uclass_find(id);
+		gd->uclass_table = table;
+		ut_asserteq_ptr(list_uc, uc);
+	}
+	ut_asserteq_ptr(NULL, uclass_find(UCLASS_COUNT));
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_table, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/*
+ * Time a number of lookups of all uclasses, returning the fastest of a few
+ * runs in microseconds, so that an interruption does not skew the result
+ */
+static ulong time_uclass_find(int loops)
+{
+	ulong best = ~0UL;
+	ulong start;
+	int run, i, id;
+
+	for (run = 0; run < 3; run++) {
+		start = timer_get_us();
+		for (i = 0; i < loops; i++) {
+			for (id = 0; id < UCLASS_COUNT; id++)
+				uclass_find(id);
+		}
+		best = min(best, timer_get_us() - start);
+	}
+
+	return best;
+}
+
+/* Check that lookups using the uclass table are faster than the list walk */
+static int dm_test_uclass_find_speed(struct unit_test_state *uts)
+{
+	struct uclass **table = gd->uclass_table;
+	ulong table_us, list_us;
+
+	ut_assertnonnull(table);
+	table_us = time_uclass_find(1000);
+	gd->uclass_table = NULL;
+	list_us = time_uclass_find(1000);
+	gd->uclass_table = table;
+	ut_assert(table_us < list_us);
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_find_speed, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 static int dm_test_uclass_devices_find(struct unit_test_state *uts)
 {
 	struct udevice *dev;
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the filesystem file-handle API
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <fs.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <sandboxblockdev.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+/* Path of the test file in the image, written by test_fs_handle.py */
+#define FS_HANDLE_FILE		"/handle.bin"
+
+/* Read part of the test file by path, as a reference for fs_pread() */
+static int fs_handle_read_path(struct unit_test_state *uts,
+			       struct blk_desc *desc, void *buf, loff_t offset,
+			       loff_t len, loff_t *actread)
+{
+	ut_assertok(fs_set_blk_dev_with_part(desc, 0));
+	ut_assertok(fs_read(FS_HANDLE_FILE, map_to_sysmem(buf), offset, len,
+			    actread));
+
+	return 0;
+}
+
+/*
+ * Test reading a file through a handle on the image in $fs_handle_image
+ *
+ * This is run by test_fs_handle.py for each filesystem it can create, and
+ * does nothing if the variable is not set.
+ */
+static int dm_test_fs_handle(struct unit_test_state *uts)
+{
+	struct fs_file *file, *other;
+	struct blk_desc *desc;
+	disk_partition_t info;
+	const char *fname;
+	loff_t size, actread;
+	char *expect, *buf;
+
+	fname = env_get("fs_handle_image");
+	if (!fname)
+		return 0;
+	ut_assertok(host_dev_bind(0, (char *)fname));
+	ut_assertok(blk_get_device_part_str("host", "0:0", &desc, &info, 1));
+
+	ut_assertok(fs_set_blk_dev_with_part(desc, 0));
+	ut_assertok(fs_size(FS_HANDLE_FILE, &size));
+	ut_assert(size > 0);
+	expect = malloc(size);
+	ut_assertnonnull(expect);
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	ut_assertok(fs_handle_read_path(uts, desc, expect, 0, 0, &actread));
+	ut_asserteq(size, actread);
+
+	ut_assertok(fs_open(desc, 0, FS_HANDLE_FILE, &file));
+	ut_asserteq(size, file->size);
+
+	/* The whole file, then a range which does not start on a block */
+	memset(buf, '\xff', size);
+	ut_assertok(fs_pread(file, buf, 0, size, &actread));
+	ut_asserteq(size, actread);
+	ut_assertok(memcmp(expect, buf, size));
+	memset(buf, '\xff', size);
+	ut_assertok(fs_pread(file, buf, 1000, 5000, &actread));
+	ut_asserteq(5000, actread);
+	ut_assertok(memcmp(expect + 1000, buf, 5000));
+
+	/* Reads are truncated at the end of the file */
+	ut_assertok(fs_pread(file, buf, size - 10, 100, &actread));
+	ut_asserteq(10, actread);
+	ut_assertok(memcmp(expect + size - 10, buf, 10));
+	ut_assertok(fs_pread(file, buf, size, 100, &actread));
+	ut_asserteq(0, actread);
+	ut_assertok(fs_pread(file, buf, 0, 0, &actread));
+	ut_asserteq(0, actread);
+
+	/* A path-based call in between must not upset the handle */
+	ut_assertok(fs_handle_read_path(uts, desc, buf, 0, 100, &actread));
+	ut_assertok(fs_pread(file, buf, 3000, 100, &actread));
+	ut_asserteq(100, actread);
+	ut_assertok(memcmp(expect + 3000, buf, 100));
+
+	/* Two handles on the same volume */
+	ut_assertok(fs_open(desc, 0, FS_HANDLE_FILE, &other));
+	ut_assertok(fs_pread(other, buf, 100, 100, &actread));
+	ut_assertok(memcmp(expect + 100, buf, 100));
+	fs_close(other);
+	ut_assertok(fs_pread(file, buf, 200, 100, &actread));
+	ut_assertok(memcmp(expect + 200, buf, 100));
+	fs_close(file);
+
+	ut_assert(fs_open(desc, 0, "/no-such-file", &file) < 0);
+	fs_close(NULL);
+
+	free(buf);
+	free(expect);
+	ut_assertok(host_dev_bind(0, NULL));
+
+	return 0;
+}
+DM_TEST(dm_test_fs_handle, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
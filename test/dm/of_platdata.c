@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for of-platdata in U-Boot proper (CONFIG_OF_PLATDATA_NODES)
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <dt-structs.h>
+#include <dm/test.h>
+#include <dm/uclass-internal.h>
+#include <test/ut.h>
+
+/* Test that a selected node is bound from its platform data */
+static int dm_test_of_platdata_nodes(struct unit_test_state *uts)
+{
+	struct dtd_sandbox_platdata_test *plat;
+	struct udevice *dev;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_MISC,
+					      "sandbox_platdata_test", &dev));
+	ut_assert(dev->flags & DM_FLAG_OF_PLATDATA);
+	plat = dev_get_platdata(dev);
+	ut_asserteq(7, plat->intval);
+	ut_asserteq_str("proper", plat->stringval);
+
+	/* The node is not bound from the device tree as well */
+	ut_asserteq(-ENODEV, uclass_find_device_by_name(UCLASS_MISC,
+							"platdata-test", &dev));
+
+	return 0;
+}
+DM_TEST(dm_test_of_platdata_nodes, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
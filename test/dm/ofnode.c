@@ -2,9 +2,14 @@
 
 #include <common.h>
 #include <dm.h>
+#include <fdtdec.h>
+#include <malloc.h>
+#include <of_live.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static int dm_test_ofnode_compatible(struct unit_test_state *uts)
 {
 	ofnode root_node = ofnode_path("/");
@@ -15,3 +20,143 @@ static int dm_test_ofnode_compatible(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_ofnode_compatible, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/*
+ * Adding a node moves the others; lookups must still be correct. The cache
+ * is only used for gd->fdt_blob, so point that at the copy and restore it
+ * before checking the results.
+ */
+static int check_phandle_moved(struct unit_test_state *uts, void *blob,
+			       int size)
+{
+	const void *old_blob = gd->fdt_blob;
+	int offset, found, moved, found_moved;
+	uint phandle;
+
+	ut_assertok(fdt_open_into(old_blob, blob, size));
+	offset = fdt_path_offset(blob, "/extra-gpios");
+	phandle = fdt_get_phandle(blob, offset);
+	ut_assert(phandle);
+	gd->fdt_blob = blob;
+	found = fdtdec_node_offset_by_phandle(blob, phandle);
+	fdt_add_subnode(blob, 0, "a-new-node");
+	moved = fdt_path_offset(blob, "/extra-gpios");
+	found_moved = fdtdec_node_offset_by_phandle(blob, phandle);
+	gd->fdt_blob = old_blob;
+
+	ut_asserteq(offset, found);
+	ut_assert(moved != offset);
+	ut_asserteq(moved, found_moved);
+
+	return 0;
+}
+
+/* Test that phandles resolve to the right node, including after changes */
+static int dm_test_ofnode_phandle(struct unit_test_state *uts)
+{
+	const int size = 0x10000;
+	uint phandle;
+	ofnode node;
+	void *blob;
+	int ret;
+
+	/* Every node with a phandle should be found from that phandle */
+	ofnode_for_each_subnode(node, ofnode_path("/")) {
+		if (ofnode_is_np(node))
+			phandle = ofnode_to_np(node)->phandle;
+		else
+			phandle = fdt_get_phandle(gd->fdt_blob,
+						  ofnode_to_offset(node));
+		if (phandle)
+			ut_assert(ofnode_equal(node,
+					       ofnode_get_by_phandle(phandle)));
+	}
+	ut_assert(!ofnode_valid(ofnode_get_by_phandle(0xfffffff)));
+	if (of_live_active())
+		return 0;
+
+	blob = malloc(size);
+	ut_assertnonnull(blob);
+	ret = check_phandle_moved(uts, blob, size);
+	free(blob);
+
+	return ret;
+}
+DM_TEST(dm_test_ofnode_phandle, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Check that two live trees have the same nodes and properties */
+static int check_same_tree(struct unit_test_state *uts,
+			   const struct device_node *np,
+			   const struct device_node *expect)
+{
+	const struct device_node *child, *echild;
+	const struct property *pp, *epp;
+
+	ut_asserteq_str(expect->full_name, np->full_name);
+	ut_asserteq_str(expect->name, np->name);
+	ut_asserteq_str(expect->type, np->type);
+	ut_asserteq(expect->phandle, np->phandle);
+	for (pp = np->properties, epp = expect->properties; epp;
+	     pp = pp->next, epp = epp->next) {
+		ut_assertnonnull(pp);
+		ut_asserteq_str(epp->name, pp->name);
+		ut_asserteq(epp->length, pp->length);
+		ut_assertok(memcmp(epp->value, pp->value, epp->length));
+	}
+	ut_asserteq_ptr(NULL, pp);
+
+	for (child = np->child, echild = expect->child; echild;
+	     child = child->sibling, echild = echild->sibling) {
+		ut_assertnonnull(child);
+		ut_asserteq_ptr(np, child->parent);
+		ut_assertok(check_same_tree(uts, child, echild));
+	}
+	ut_asserteq_ptr(NULL, child);
+
+	return 0;
+}
+
+static int check_of_live_pack(struct unit_test_state *uts, void *pack,
+			      int size)
+{
+	struct of_live_pack *hdr = pack;
+	struct device_node *root;
+	int ret;
+
+	ut_asserteq(-FDT_ERR_NOSPACE,
+		    of_live_pack_fdt(gd->fdt_blob, pack, size - 1));
+	ut_asserteq(size, of_live_pack_fdt(gd->fdt_blob, pack, size));
+	ut_assertok(of_live_unpack(pack, gd->fdt_blob, &root));
+	ret = check_same_tree(uts, root, gd->of_root);
+	free(root);
+	ut_assertok(ret);
+
+	/* The pack is only used with the flat tree it was built from */
+	hdr->fdt_crc = cpu_to_fdt32(fdt32_to_cpu(hdr->fdt_crc) + 1);
+	ut_asserteq(-ESTALE, of_live_unpack(pack, gd->fdt_blob, &root));
+	hdr->magic = 0;
+	ut_asserteq(-ENOENT, of_live_unpack(pack, gd->fdt_blob, &root));
+
+	return 0;
+}
+
+/* Test that a packed live tree is the same as the one built at start-up */
+static int dm_test_of_live_pack(struct unit_test_state *uts)
+{
+	void *pack;
+	int size;
+	int ret;
+
+	if (!IS_ENABLED(CONFIG_OF_LIVE_PACK) || !of_live_active())
+		return 0;
+
+	size = of_live_pack_fdt(gd->fdt_blob, NULL, 0);
+	ut_assert(size > 0);
+	pack = malloc(size);
+	ut_assertnonnull(pack);
+	ret = check_of_live_pack(uts, pack, size);
+	free(pack);
+
+	return ret;
+}
+DM_TEST(dm_test_of_live_pack, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
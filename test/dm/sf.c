@@ -7,11 +7,13 @@
 #include <dm.h>
 #include <fdtdec.h>
 #include <spi.h>
+#include <mapmem.h>
 #include <spi_flash.h>
 #include <asm/state.h>
 #include <dm/test.h>
 #include <dm/util.h>
 #include <test/ut.h>
+#include <u-boot/crc.h>
 
 /* Test that sandbox SPI flash works correctly */
 static int dm_test_spi_flash(struct unit_test_state *uts)
@@ -40,3 +42,55 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_spi_flash, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test that 'sf update' with a hash manifest skips unchanged sectors */
+static int dm_test_spi_flash_update_hashes(struct unit_test_state *uts)
+{
+	const int sector_size = 0x10000;
+	u8 *data, *flash_data;
+	u32 *hashes;
+	int i;
+
+	ut_asserteq(0, run_command_list(
+		"sb save hostfs - 0 spi.bin 200000;"
+		"sf probe;"
+		"mw.l 10000 0 3;"
+		"mw.b 20000 5a 30000;"
+		"sf update 20000 0 30000 10000;"
+		"sf read 60000 0 30000;"
+		"cmp.b 20000 60000 30000", -1, 0));
+
+	/* The manifest should now describe the new contents */
+	hashes = map_sysmem(0x10000, 3 * sizeof(u32));
+	data = map_sysmem(0x20000, 3 * sector_size);
+	for (i = 0; i < 3; i++)
+		ut_asserteq(crc32(0, data + i * sector_size, sector_size),
+			    be32_to_cpu(hashes[i]));
+	unmap_sysmem(data);
+	unmap_sysmem(hashes);
+
+	/*
+	 * Change the flash behind the manifest's back. An update using the
+	 * manifest must not notice, since it does not read the flash.
+	 */
+	ut_asserteq(0, run_command_list(
+		"sf erase 10000 10000;"
+		"sf update 20000 0 30000 10000;"
+		"sf read 60000 10000 10000", -1, 0));
+	flash_data = map_sysmem(0x60000, sector_size);
+	for (i = 0; i < sector_size; i++)
+		ut_asserteq(0xff, flash_data[i]);
+	unmap_sysmem(flash_data);
+
+	/* Without the manifest the flash is read back and fixed up */
+	ut_asserteq(0, run_command_list(
+		"sf update 20000 0 30000;"
+		"sf read 60000 0 30000;"
+		"cmp.b 20000 60000 30000", -1, 0));
+
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_update_hashes,
+	DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
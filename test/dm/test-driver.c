@@ -146,6 +146,49 @@ U_BOOT_DRIVER(test_manual_drv) = {
 	.unbind	= test_manual_unbind,
 };
 
+/* Sequence number of the last wait started or finished by test_async_drv */
+static int test_async_seq;
+
+/* Pretend that the hardware takes DM_TEST_ASYNC_DELAY_MS to become ready */
+static int test_async_probe_start(struct udevice *dev)
+{
+	struct dm_test_priv *priv = dev_get_priv(dev);
+
+	dm_testdrv_op_count[DM_TEST_OP_PROBE_START]++;
+	priv->ready_time = get_timer(0) + DM_TEST_ASYNC_DELAY_MS;
+	priv->wait_seq = ++test_async_seq;
+
+	return 0;
+}
+
+static int test_async_probe(struct udevice *dev)
+{
+	struct dm_test_priv *priv = dev_get_priv(dev);
+
+	dm_testdrv_op_count[DM_TEST_OP_PROBE]++;
+	if (!priv->ready_time) {
+		priv->ready_time = get_timer(0) + DM_TEST_ASYNC_DELAY_MS;
+		priv->wait_seq = ++test_async_seq;
+	}
+	while (get_timer(0) < priv->ready_time)
+		;
+	priv->ready_seq = ++test_async_seq;
+
+	return 0;
+}
+
+U_BOOT_DRIVER(test_async_drv) = {
+	.name	= "test_async_drv",
+	.id	= UCLASS_TEST,
+	.ops	= &test_manual_ops,
+	.bind	= test_manual_bind,
+	.probe	= test_async_probe,
+	.probe_start	= test_async_probe_start,
+	.remove	= test_manual_remove,
+	.unbind	= test_manual_unbind,
+	.priv_auto_alloc_size = sizeof(struct dm_test_priv),
+};
+
 U_BOOT_DRIVER(test_pre_reloc_drv) = {
 	.name	= "test_pre_reloc_drv",
 	.id	= UCLASS_TEST,
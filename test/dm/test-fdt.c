@@ -6,12 +6,14 @@
 #include <common.h>
 #include <dm.h>
 #include <errno.h>
+#include <fdt_support.h>
 #include <fdtdec.h>
 #include <malloc.h>
 #include <asm/io.h>
 #include <dm/test.h>
-#include <dm/root.h>
 #include <dm/device-internal.h>
+#include <dm/lists.h>
+#include <dm/root.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
 #include <test/ut.h>
@@ -461,3 +463,200 @@ static int dm_test_fdt_translation(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_fdt_translation, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Find the first driver matching a compatible string by scanning the list */
+static struct driver *scan_compat(const char *compat,
+				  const struct udevice_id **idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id;
+	struct driver *entry;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++) {
+			if (!strcmp(id->compatible, compat)) {
+				*idp = id;
+				return entry;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Test that looking up a driver by compatible string finds the first match */
+static int dm_test_fdt_lookup_compat(struct unit_test_state *uts)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_id, *id, *expect_id = NULL;
+	struct driver *entry, *expect;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_id = entry->of_match; of_id && of_id->compatible;
+		     of_id++) {
+			expect = scan_compat(of_id->compatible, &expect_id);
+			ut_asserteq_ptr(expect, lists_driver_lookup_compat(
+						of_id->compatible, &id));
+			ut_asserteq_ptr(expect_id, id);
+		}
+	}
+	ut_asserteq_ptr(NULL, lists_driver_lookup_compat("sandbox,no-such",
+							 &id));
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_lookup_compat, 0);
+
+/* Test that a node marked u-boot,dm-lazy is bound when its uclass is used */
+static int dm_test_fdt_lazy_bind(struct unit_test_state *uts)
+{
+	ofnode node = ofnode_path("/lazy-test");
+	struct dm_lazy_node *lazy;
+	struct udevice *dev;
+
+	ut_assert(ofnode_valid(node));
+	lazy = gd->dm_lazy_list;
+	ut_assertnonnull(lazy);
+	ut_assert(ofnode_equal(node, lazy->node));
+	ut_asserteq_ptr(dm_root(), lazy->parent);
+	ut_assert(lazy->uclasses[UCLASS_TEST_DUMMY / BITS_PER_LONG] &
+		  1UL << (UCLASS_TEST_DUMMY % BITS_PER_LONG));
+
+	/* Nothing is bound by looking at another uclass */
+	ut_assertok(uclass_first_device_err(UCLASS_TEST_FDT, &dev));
+	ut_asserteq_ptr(lazy, gd->dm_lazy_list);
+	list_for_each_entry(dev, &dm_root()->child_head, sibling_node)
+		ut_assert(strcmp("lazy-test", dev->name));
+
+	ut_assertok(uclass_get_device_by_ofnode(UCLASS_TEST_DUMMY, node, &dev));
+	ut_asserteq_str("lazy-test", dev->name);
+	ut_asserteq_ptr(dm_root(), dev->parent);
+	ut_asserteq_ptr(NULL, gd->dm_lazy_list);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_lazy_bind, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Apply the same writes to an FDT either directly or as a batch */
+static int fdt_batch_writes(struct unit_test_state *uts, void *blob,
+			    bool defer)
+{
+	struct fdt_batch batch;
+	fdt32_t val = cpu_to_fdt32(123);
+
+	fdt_batch_init(&batch, blob, defer);
+	ut_assertok(fdt_batch_setprop(&batch, "testfdt8", "ping-expect", &val,
+				      sizeof(val)));
+	ut_assertok(fdt_batch_setprop(&batch, "/a-test", "batch-new", "first",
+				      6));
+	ut_assertok(fdt_batch_setprop(&batch, "/chosen", NULL, NULL, 0));
+	ut_assertok(fdt_batch_setprop(&batch, "/batch-node", "compatible",
+				      "batch", 6));
+	ut_assertok(fdt_batch_setprop(&batch, "/batch-node/child", NULL, NULL,
+				      0));
+	ut_assertok(fdt_batch_setprop(&batch, "/batch-node/child/leaf",
+				      "reg", &val, sizeof(val)));
+	ut_assertok(fdt_batch_setprop(&batch,
+				      "/translation-test@8000/noxlatebus@3,300",
+				      "batch-deep", "", 0));
+	ut_assertok(fdt_batch_setprop(&batch, "/a-test", "batch-new", "second",
+				      7));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdt_batch_setprop(&batch, "/no-parent/node", "x", "", 0));
+
+	/* These join the batch while it is open */
+	ut_assertok(fdt_fixup_memory(blob, 0x1000, 0x2000));
+	ut_assertok(fdt_initrd(blob, 0x3000, 0x4000));
+	ut_asserteq(defer ? 10 : 0, batch.count);
+	ut_assertok(fdt_batch_commit(&batch));
+	ut_asserteq(0, batch.count);
+
+	return 0;
+}
+
+/* Compare a property in two FDTs */
+static int fdt_batch_check_prop(struct unit_test_state *uts, void *expect,
+				void *actual, const char *path,
+				const char *name, int len)
+{
+	const void *exp_val, *act_val;
+	int len1, len2;
+
+	exp_val = fdt_getprop(expect, fdt_path_offset(expect, path), name,
+			      &len1);
+	act_val = fdt_getprop(actual, fdt_path_offset(actual, path), name,
+			      &len2);
+	ut_assertnonnull(exp_val);
+	ut_assertnonnull(act_val);
+	ut_asserteq(len, len1);
+	ut_asserteq(len1, len2);
+	ut_assertok(memcmp(exp_val, act_val, len1));
+
+	return 0;
+}
+
+/* Test that a batch of FDT writes has the same effect as direct writes */
+static int dm_test_fdt_batch(struct unit_test_state *uts)
+{
+	int size = fdt_totalsize(gd->fdt_blob) + 0x1000;
+	void *direct, *batched;
+	int node1, node2;
+	int count;
+
+	direct = malloc(size);
+	batched = malloc(size);
+	ut_assertnonnull(direct);
+	ut_assertnonnull(batched);
+	ut_assertok(fdt_open_into(gd->fdt_blob, direct, size));
+	ut_assertok(fdt_open_into(gd->fdt_blob, batched, size));
+	ut_assertok(fdt_batch_writes(uts, direct, false));
+	ut_assertok(fdt_batch_writes(uts, batched, true));
+	ut_assertok(fdt_check_header(batched));
+	ut_asserteq(fdt_totalsize(direct), fdt_totalsize(batched));
+
+	ut_assertok(fdt_batch_check_prop(uts, direct, batched, "/a-test",
+					 "ping-expect", 4));
+	ut_assertok(fdt_batch_check_prop(uts, direct, batched, "/a-test",
+					 "batch-new", 7));
+	ut_assertok(fdt_batch_check_prop(uts, direct, batched, "/a-test",
+					 "ping-add", 4));
+	ut_assertok(fdt_batch_check_prop(uts, direct, batched, "/batch-node",
+					 "compatible", 6));
+	ut_assertok(fdt_batch_check_prop(uts, direct, batched,
+					 "/batch-node/child/leaf", "reg", 4));
+	ut_assertok(fdt_batch_check_prop(uts, direct, batched,
+					 "/translation-test@8000/noxlatebus@3,300",
+					 "batch-deep", 0));
+	ut_assertok(fdt_batch_check_prop(uts, direct, batched,
+				"/translation-test@8000/noxlatebus@3,300/dev@42",
+				"reg", 4));
+	ut_assertok(fdt_batch_check_prop(uts, direct, batched, "/memory",
+					 "device_type", 7));
+	ut_assertok(fdt_batch_check_prop(uts, direct, batched, "/memory",
+					 "reg", 8));
+	ut_assertok(fdt_batch_check_prop(uts, direct, batched, "/chosen",
+					 "linux,initrd-start", 4));
+	ut_assertok(fdt_batch_check_prop(uts, direct, batched, "/chosen",
+					 "linux,initrd-end", 4));
+	ut_asserteq(fdt_num_mem_rsv(direct), fdt_num_mem_rsv(batched));
+
+	/* Both trees should have the same nodes */
+	node1 = 0;
+	node2 = 0;
+	for (count = 0; node1 >= 0; count++) {
+		ut_asserteq(node1 < 0, node2 < 0);
+		node1 = fdt_next_node(direct, node1, NULL);
+		node2 = fdt_next_node(batched, node2, NULL);
+	}
+	ut_asserteq(node1, node2);
+	ut_assert(count > 50);
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdt_path_offset(batched, "/no-parent"));
+
+	free(batched);
+	free(direct);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_batch, 0);
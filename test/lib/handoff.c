@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the SPL handoff area
+ */
+
+#include <common.h>
+#include <handoff.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define AREA_SIZE	0x100
+
+static int check_handoff(struct unit_test_state *uts, void *buf)
+{
+	ulong addr = map_to_sysmem(buf);
+	struct handoff_hdr *hdr = buf;
+	struct handoff_dram *dram;
+	u32 *board;
+
+	ut_asserteq(-ENOSPC, handoff_new(addr, sizeof(*hdr) - 1));
+	ut_assertok(handoff_new(addr, AREA_SIZE));
+
+	/* Adding a record again returns the same one, if the size matches */
+	dram = handoff_add(HANDOFF_TAG_DRAM, sizeof(*dram));
+	ut_assertnonnull(dram);
+	dram->ram_size = 0x12345678;
+	ut_asserteq_ptr(dram, handoff_add(HANDOFF_TAG_DRAM, sizeof(*dram)));
+	ut_asserteq_ptr(NULL, handoff_add(HANDOFF_TAG_DRAM, 4));
+	board = handoff_add(HANDOFF_TAG_BOARD, sizeof(*board));
+	ut_assertnonnull(board);
+	*board = 0xdeadbeef;
+	ut_asserteq_ptr(NULL, handoff_add(HANDOFF_TAG_BOARD + 1, AREA_SIZE));
+	ut_assertok(handoff_finish());
+
+	/* The records can be found again from the area alone */
+	gd->handoff = NULL;
+	ut_asserteq_ptr(NULL, handoff_find(HANDOFF_TAG_DRAM, sizeof(*dram)));
+	ut_assertok(handoff_check(addr, AREA_SIZE));
+	ut_asserteq_ptr(dram, handoff_find(HANDOFF_TAG_DRAM, sizeof(*dram)));
+	ut_asserteq(0x12345678, dram->ram_size);
+	ut_asserteq_ptr(board,
+			handoff_find(HANDOFF_TAG_BOARD, sizeof(*board)));
+	ut_asserteq(0xdeadbeef, *board);
+	ut_asserteq_ptr(NULL, handoff_find(HANDOFF_TAG_DRAM, 4));
+	ut_asserteq_ptr(NULL, handoff_find(HANDOFF_TAG_CLOCKS,
+					   sizeof(struct handoff_clocks)));
+
+	/* The area must fit in the space given */
+	ut_asserteq(-ENOENT, handoff_check(addr, sizeof(*hdr) - 1));
+	ut_asserteq(-EIO, handoff_check(addr, AREA_SIZE / 2));
+
+	/* A changed record is detected by the CRC */
+	dram->ram_size++;
+	ut_asserteq(-EIO, handoff_check(addr, AREA_SIZE));
+	dram->ram_size--;
+	ut_assertok(handoff_check(addr, AREA_SIZE));
+
+	hdr->version++;
+	ut_asserteq(-EPROTO, handoff_check(addr, AREA_SIZE));
+	hdr->version--;
+	ut_assertok(handoff_check(addr, AREA_SIZE));
+
+	handoff_invalidate(addr);
+	ut_asserteq(-ENOENT, handoff_check(addr, AREA_SIZE));
+
+	return 0;
+}
+
+static int lib_test_handoff(struct unit_test_state *uts)
+{
+	struct handoff_hdr *old = gd->handoff;
+	void *buf;
+	int ret;
+
+	buf = malloc(AREA_SIZE);
+	ut_assertnonnull(buf);
+	ret = check_handoff(uts, buf);
+	gd->handoff = old;
+	free(buf);
+
+	return ret;
+}
+LIB_TEST(lib_test_handoff, 0);
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the logical memory block allocator
+ */
+
+#include <common.h>
+#include <lmb.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+#define RAM_BASE	0x40000000
+#define RAM_SIZE	0x10000000
+
+/* Add, reserve, allocate and free in a single memory region */
+static int lib_test_lmb_simple(struct unit_test_state *uts)
+{
+	struct lmb lmb;
+	phys_addr_t a, b;
+
+	lmb_init(&lmb);
+	ut_asserteq(0, lmb_add(&lmb, RAM_BASE, RAM_SIZE));
+	ut_asserteq(1, lmb.memory.cnt);
+
+	/* Reserve the top 64KiB, allocations must go below it */
+	ut_asserteq(0, lmb_reserve(&lmb, RAM_BASE + RAM_SIZE - 0x10000,
+				   0x10000));
+	a = lmb_alloc(&lmb, 0x1000, 0x1000);
+	ut_asserteq(RAM_BASE + RAM_SIZE - 0x11000, a);
+	ut_asserteq(1, lmb.reserved.cnt);
+	ut_assert(lmb_is_reserved(&lmb, a));
+	ut_assert(!lmb_is_reserved(&lmb, a - 1));
+
+	/* Below a maximum address, aligned */
+	b = lmb_alloc_base(&lmb, 0x100, 0x10000, RAM_BASE + 0x8000000);
+	ut_asserteq(RAM_BASE + 0x7ff0000, b);
+	ut_asserteq(2, lmb.reserved.cnt);
+
+	/* Freeing the middle of a region splits it */
+	ut_asserteq(0, lmb_free(&lmb, a, 0x1000));
+	ut_assert(!lmb_is_reserved(&lmb, a));
+	ut_asserteq(2, lmb.reserved.cnt);
+	ut_asserteq(-1, lmb_free(&lmb, a, 0x1000));
+	ut_asserteq(0, lmb_free(&lmb, b, 0x10000));
+	ut_asserteq(1, lmb.reserved.cnt);
+
+	/* Nothing fits */
+	ut_asserteq(0, __lmb_alloc_base(&lmb, RAM_SIZE, 1, 0));
+
+	return 0;
+}
+LIB_TEST(lib_test_lmb_simple, 0);
+
+/* More regions than fit in the struct */
+static int lib_test_lmb_grow(struct unit_test_state *uts)
+{
+	const int count = 3 * MAX_LMB_REGIONS;
+	struct lmb lmb;
+	phys_addr_t a;
+	int i;
+
+	lmb_init(&lmb);
+	ut_asserteq(0, lmb_add(&lmb, RAM_BASE, RAM_SIZE));
+
+	/* Every other 64KiB block, added from the top down */
+	for (i = count - 1; i >= 0; i--)
+		ut_asserteq(0, lmb_reserve(&lmb, RAM_BASE + i * 0x20000,
+					   0x10000));
+	ut_asserteq(count, lmb.reserved.cnt);
+	ut_assertnonnull(lmb.reserved.heap);
+	ut_assert(lmb.reserved.max >= count);
+	for (i = 0; i < count; i++) {
+		ut_asserteq(RAM_BASE + i * 0x20000,
+			    lmb_regions(&lmb.reserved)[i].base);
+		ut_assert(lmb_is_reserved(&lmb, RAM_BASE + i * 0x20000));
+		ut_assert(!lmb_is_reserved(&lmb,
+					   RAM_BASE + i * 0x20000 + 0x10000));
+	}
+
+	/* Filling a gap merges its neighbours */
+	ut_asserteq(2, lmb_reserve(&lmb, RAM_BASE + 0x10000, 0x10000));
+	ut_asserteq(count - 1, lmb.reserved.cnt);
+
+	/* Below the top reservation, the highest free gap is used */
+	a = lmb_alloc_base(&lmb, 0x10000, 0x10000,
+			   RAM_BASE + (count - 1) * 0x20000 + 0x10000);
+	ut_asserteq(RAM_BASE + (count - 2) * 0x20000 + 0x10000, a);
+
+	lmb_release(&lmb);
+
+	return 0;
+}
+LIB_TEST(lib_test_lmb_grow, 0);
+
+/* Initialising again must not leak the grown arrays */
+static int lib_test_lmb_reinit(struct unit_test_state *uts)
+{
+	struct mallinfo before, after;
+	struct lmb lmb;
+	int i, pass;
+
+	lmb_init(&lmb);
+	before = mallinfo();
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < 2 * MAX_LMB_REGIONS; i++) {
+			ut_asserteq(0, lmb_add(&lmb, RAM_BASE + i * 0x20000,
+					       0x10000));
+			ut_asserteq(0, lmb_reserve(&lmb,
+						   RAM_BASE + i * 0x20000,
+						   0x1000));
+		}
+		ut_assertnonnull(lmb.memory.heap);
+		ut_assertnonnull(lmb.reserved.heap);
+		lmb_release(&lmb);
+		ut_asserteq_ptr(NULL, lmb.memory.heap);
+		ut_asserteq(0, lmb.memory.cnt);
+		ut_asserteq(0, lmb.reserved.cnt);
+	}
+	after = mallinfo();
+	ut_asserteq(before.uordblks, after.uordblks);
+
+	return 0;
+}
+LIB_TEST(lib_test_lmb_reinit, 0);
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the small-block cache and usage information of malloc()
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+/*
+ * A freed small block is handed out again by the next request of its size.
+ * The block may be larger than asked for, so use its usable size.
+ */
+static int lib_test_malloc_cache(struct unit_test_state *uts)
+{
+	struct malloc_info info;
+	ulong cached;
+	size_t size;
+	void *a, *b;
+
+	if (!CONFIG_IS_ENABLED(SYS_MALLOC_CACHE))
+		return 0;
+
+	a = malloc(40);
+	ut_assertnonnull(a);
+	size = malloc_usable_size(a);
+	malloc_get_info(&info);
+	cached = info.cached;
+	free(a);
+	malloc_get_info(&info);
+	ut_assert(info.cached > cached);
+	ut_asserteq_ptr(a, malloc(size));
+	malloc_get_info(&info);
+	ut_asserteq(cached, info.cached);
+
+	/* A large request does not flush the cache while top can serve it */
+	free(a);
+	b = malloc(0x10000);
+	ut_assertnonnull(b);
+	malloc_get_info(&info);
+	ut_assert(info.cached > cached);
+	free(b);
+	ut_asserteq_ptr(a, malloc(size));
+	free(a);
+
+	return 0;
+}
+LIB_TEST(lib_test_malloc_cache, 0);
+
+/* Each malloc() is counted once in its size class */
+static int lib_test_malloc_stats(struct unit_test_state *uts)
+{
+	struct malloc_info before, info;
+	void *a;
+
+	if (!CONFIG_IS_ENABLED(SYS_MALLOC_STATS))
+		return 0;
+
+	malloc_get_info(&before);
+	a = malloc(100);
+	ut_assertnonnull(a);
+	malloc_get_info(&info);
+
+	/* 100 bytes falls in the class for 65 to 128 bytes */
+	ut_asserteq(before.count[3] + 1, info.count[3]);
+	ut_asserteq(before.count[2], info.count[2]);
+	ut_asserteq(before.count[4], info.count[4]);
+
+	ut_asserteq(info.pool, before.pool);
+	ut_assert(info.in_use >= before.in_use + 100);
+	ut_asserteq(info.pool, info.in_use + info.free);
+	ut_assert(info.largest <= info.free);
+	ut_assert(info.peak <= info.pool);
+	free(a);
+
+	/*
+	 * A request which fails flushes the cache and is retried, but still
+	 * counts once
+	 */
+	before = info;
+	ut_asserteq_ptr(NULL, malloc(info.pool));
+	malloc_get_info(&info);
+	ut_asserteq(before.count[MALLOC_STATS_CLASSES - 1] + 1,
+		    info.count[MALLOC_STATS_CLASSES - 1]);
+	ut_asserteq(0, info.cached);
+
+	ut_assertok(run_command("malloc stats", 0));
+
+	return 0;
+}
+LIB_TEST(lib_test_malloc_stats, 0);
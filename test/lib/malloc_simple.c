@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for reuse of memory in the simple (pre-relocation) malloc() pool
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define POOL_SIZE	0x1000
+
+static int check_malloc_simple(struct unit_test_state *uts)
+{
+	char *a, *b, *c;
+	ulong high;
+
+	/* A freed block is reused for a request of the same size class */
+	a = malloc_simple(20);
+	ut_assertnonnull(a);
+	b = malloc_simple(20);
+	ut_assertnonnull(b);
+	high = gd->malloc_ptr;
+	free_simple(a);
+	ut_asserteq_ptr(a, malloc_simple(24));
+	ut_asserteq(high, gd->malloc_ptr);
+
+	/* But not for a larger one */
+	free_simple(a);
+	c = malloc_simple(100);
+	ut_assert(c != a);
+	ut_assert(gd->malloc_ptr > high);
+
+	/* Large blocks are reused by first fit */
+	free_simple(c);
+	c = malloc_simple(1000);
+	high = gd->malloc_ptr;
+	free_simple(c);
+	ut_asserteq_ptr(c, malloc_simple(600));
+	ut_asserteq(high, gd->malloc_ptr);
+
+	/* realloc() keeps a block which is big enough */
+	ut_asserteq_ptr(b, realloc_simple(b, 24));
+	memset(b, 'x', 24);
+
+	/* and moves one which is not, freeing the old block */
+	c = realloc_simple(b, 200);
+	ut_assertnonnull(c);
+	ut_assert(c != b);
+	ut_assert(!memcmp(c, "xxxxxxxxxxxxxxxxxxxxxxxx", 24));
+	ut_asserteq_ptr(b, malloc_simple(17));
+
+	/* The pool still runs out */
+	ut_asserteq_ptr(NULL, malloc_simple(POOL_SIZE));
+
+	return 0;
+}
+
+static int lib_test_malloc_simple(struct unit_test_state *uts)
+{
+	ulong base = gd->malloc_base;
+	ulong ptr = gd->malloc_ptr;
+	ulong limit = gd->malloc_limit;
+	void *pool;
+	int ret;
+
+	if (!CONFIG_IS_ENABLED(SYS_MALLOC_F_FREE))
+		return 0;
+
+	/* Use a pool of our own, so the real one is left alone */
+	pool = malloc(POOL_SIZE);
+	ut_assertnonnull(pool);
+	gd->malloc_base = map_to_sysmem(pool);
+	gd->malloc_ptr = 0;
+	gd->malloc_limit = POOL_SIZE;
+
+	ret = check_malloc_simple(uts);
+
+	gd->malloc_base = base;
+	gd->malloc_ptr = ptr;
+	gd->malloc_limit = limit;
+	free(pool);
+
+	return ret;
+}
+LIB_TEST(lib_test_malloc_simple, 0);
@@ -22,6 +22,9 @@ extern u32 __dtb_test_fdt_base_begin;
 extern u32 __dtb_test_fdt_overlay_begin;
 extern u32 __dtb_test_fdt_overlay_stacked_begin;
 
+/* Base tree with the overlays applied, checked by the tests */
+static void *fdt;
+
 static int ut_fdt_getprop_u32_by_index(void *fdt, const char *path,
 				    const char *name, int index,
 				    u32 *out)
@@ -66,7 +69,6 @@ static int fdt_getprop_str(void *fdt, const char *path, const char *name,
 
 static int fdt_overlay_change_int_property(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
 	u32 val = 0;
 
 	ut_assertok(ut_fdt_getprop_u32(fdt, "/test-node", "test-int-property",
@@ -79,7 +81,6 @@ OVERLAY_TEST(fdt_overlay_change_int_property, 0);
 
 static int fdt_overlay_change_str_property(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
 	const char *val = NULL;
 
 	ut_assertok(fdt_getprop_str(fdt, "/test-node", "test-str-property",
@@ -92,7 +93,6 @@ OVERLAY_TEST(fdt_overlay_change_str_property, 0);
 
 static int fdt_overlay_add_str_property(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
 	const char *val = NULL;
 
 	ut_assertok(fdt_getprop_str(fdt, "/test-node", "test-str-property-2",
@@ -105,7 +105,6 @@ OVERLAY_TEST(fdt_overlay_add_str_property, 0);
 
 static int fdt_overlay_add_node_by_phandle(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
 	int off;
 
 	off = fdt_path_offset(fdt, "/test-node/new-node");
@@ -119,7 +118,6 @@ OVERLAY_TEST(fdt_overlay_add_node_by_phandle, 0);
 
 static int fdt_overlay_add_node_by_path(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
 	int off;
 
 	off = fdt_path_offset(fdt, "/new-node");
@@ -133,7 +131,6 @@ OVERLAY_TEST(fdt_overlay_add_node_by_path, 0);
 
 static int fdt_overlay_add_subnode_property(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
 	int off;
 
 	off = fdt_path_offset(fdt, "/test-node/sub-test-node");
@@ -149,7 +146,6 @@ OVERLAY_TEST(fdt_overlay_add_subnode_property, 0);
 static int fdt_overlay_local_phandle(struct unit_test_state *uts)
 {
 	uint32_t local_phandle;
-	void *fdt = uts->priv;
 	u32 val = 0;
 	int off;
 
@@ -174,7 +170,6 @@ OVERLAY_TEST(fdt_overlay_local_phandle, 0);
 static int fdt_overlay_local_phandles(struct unit_test_state *uts)
 {
 	uint32_t local_phandle, test_phandle;
-	void *fdt = uts->priv;
 	u32 val = 0;
 	int off;
 
@@ -204,7 +199,6 @@ OVERLAY_TEST(fdt_overlay_local_phandles, 0);
 
 static int fdt_overlay_stacked(struct unit_test_state *uts)
 {
-	void *fdt = uts->priv;
 	u32 val = 0;
 
 	ut_assertok(ut_fdt_getprop_u32(fdt, "/new-local-node",
@@ -215,6 +209,84 @@ static int fdt_overlay_stacked(struct unit_test_state *uts)
 }
 OVERLAY_TEST(fdt_overlay_stacked, 0);
 
+/* Size of the trees used to apply a stack of overlays */
+#define FDT_STACK_SIZE		(256 * SZ_1K)
+#define FDT_STACK_FILLERS	1000
+#define FDT_STACK_OVERLAYS	16
+
+/*
+ * Apply a stack of overlays to a copy of the base tree, padded out with
+ * nodes which have phandles so that the index has something to save
+ */
+static int fdt_overlay_apply_stack(struct unit_test_state *uts, void *base,
+				   struct fdt_overlay_index *idx)
+{
+	void *fdt_overlay = &__dtb_test_fdt_overlay_begin;
+	void *fdt_overlay_stacked = &__dtb_test_fdt_overlay_stacked_begin;
+	char ov[FDT_COPY_SIZE];
+	char name[20];
+	int i, node;
+
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_base_begin, base,
+				  FDT_STACK_SIZE));
+	for (i = 0; i < FDT_STACK_FILLERS; i++) {
+		snprintf(name, sizeof(name), "filler@%d", i);
+		node = fdt_add_subnode(base, 0, name);
+		ut_assert(node >= 0);
+		ut_assertok(fdt_setprop_u32(base, node, "reg", i));
+		ut_assertok(fdt_setprop_u32(base, node, "phandle", 1000 + i));
+	}
+
+	for (i = 0; i < FDT_STACK_OVERLAYS; i++) {
+		ut_assertok(fdt_open_into(i & 1 ? fdt_overlay_stacked :
+					  fdt_overlay, ov, sizeof(ov)));
+		ut_assertok(fdt_overlay_apply_index(base, ov, idx));
+	}
+
+	return 0;
+}
+
+static int check_overlay_index_stack(struct unit_test_state *uts,
+				     void *plain, void *indexed)
+{
+	struct fdt_overlay_index idx;
+	u32 buf[256];
+	u32 val;
+
+	ut_assertnonnull(plain);
+	ut_assertnonnull(indexed);
+
+	fdt_overlay_index_init(&idx, buf, sizeof(buf));
+	ut_assertok(fdt_overlay_apply_stack(uts, plain, NULL));
+	ut_assertok(fdt_overlay_apply_stack(uts, indexed, &idx));
+	ut_assert(idx.count > 0);
+	ut_assert(idx.max_phandle > 1000 + FDT_STACK_FILLERS);
+
+	ut_asserteq(fdt_totalsize(plain), fdt_totalsize(indexed));
+	ut_assertok(memcmp(plain, indexed, fdt_totalsize(plain)));
+	ut_assertok(ut_fdt_getprop_u32(indexed, "/new-local-node",
+				       "stacked-test-int-property", &val));
+	ut_asserteq(43, val);
+
+	return CMD_RET_SUCCESS;
+}
+
+/* Check that an index gives the same result as applying without one */
+static int fdt_overlay_index_stack(struct unit_test_state *uts)
+{
+	void *plain, *indexed;
+	int ret;
+
+	plain = malloc(FDT_STACK_SIZE);
+	indexed = malloc(FDT_STACK_SIZE);
+	ret = check_overlay_index_stack(uts, plain, indexed);
+	free(indexed);
+	free(plain);
+
+	return ret;
+}
+OVERLAY_TEST(fdt_overlay_index_stack, 0);
+
 int do_ut_overlay(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	struct unit_test *tests = ll_entry_start(struct unit_test,
@@ -237,7 +309,7 @@ int do_ut_overlay(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	fdt_base_copy = malloc(FDT_COPY_SIZE);
 	if (!fdt_base_copy)
 		goto err1;
-	uts->priv = fdt_base_copy;
+	fdt = fdt_base_copy;
 
 	fdt_overlay_copy = malloc(FDT_COPY_SIZE);
 	if (!fdt_overlay_copy)
@@ -3,6 +3,7 @@
 #
 # Sanity check of the FIT handling in U-Boot
 
+import gzip
 import os
 import pytest
 import struct
@@ -22,7 +23,7 @@ base_its = '''
                         type = "kernel";
                         arch = "sandbox";
                         os = "linux";
-                        compression = "none";
+                        compression = "%(compression)s";
                         load = <0x40000>;
                         entry = <0x8>;
                 };
@@ -108,6 +109,17 @@ sb save hostfs 0 %(loadables1_addr)x %(loadables1_out)s %(loadables1_size)x
 sb save hostfs 0 %(loadables2_addr)x %(loadables2_out)s %(loadables2_size)x
 '''
 
+# This script loads a FIT with external data so that its kernel data lies at
+# the kernel load address, then boots it from there.
+place_script = '''
+sb load hostfs 0 - %(fit)s
+bootm start ${fileaddr}
+bootm loados
+sb save hostfs 0 %(kernel_addr)x %(kernel_out)s %(kernel_size)x
+sb save hostfs 0 %(fdt_addr)x %(fdt_out)s %(fdt_size)x
+sb save hostfs 0 %(ramdisk_addr)x %(ramdisk_out)s %(ramdisk_size)x
+'''
+
 @pytest.mark.boardspec('sandbox')
 @pytest.mark.buildconfigspec('fit_signature')
 @pytest.mark.requiredtool('dtc')
@@ -170,7 +182,7 @@ def test_fit(u_boot_console):
             print >> fd, base_its % params
         return its
 
-    def make_fit(mkimage, params):
+    def make_fit(mkimage, params, external=False):
         """Make a sample .fit file ready for loading
 
         This creates a .its script with the selected parameters and uses mkimage to
@@ -179,12 +191,16 @@ def test_fit(u_boot_console):
         Args:
             mkimage: Filename of 'mkimage' utility
             params: Dictionary containing parameters to embed in the %() strings
+            external: True to place the image data after the FIT structure
         Return:
             Filename of .fit file created
         """
         fit = make_fname('test.fit')
         its = make_its(params)
-        util.run_and_log(cons, [mkimage, '-f', its, fit])
+        args = [mkimage, '-f', its, fit]
+        if external:
+            args.insert(1, '-E')
+        util.run_and_log(cons, args)
         with open(make_fname('u-boot.dts'), 'w') as fd:
             print >> fd, base_fdt
         return fit
@@ -205,6 +221,20 @@ def test_fit(u_boot_console):
             print >> fd, data
         return fname
 
+    def make_compressed(filename):
+        """Make a gzip-compressed copy of a file
+
+        Args:
+            filename: the name of the file to compress
+        Returns:
+            Filename of compressed file created
+        """
+        fname = filename + '.gz'
+        with open(filename, 'rb') as infd:
+            with gzip.open(fname, 'wb') as outfd:
+                outfd.write(infd.read())
+        return fname
+
     def make_ramdisk(filename, text):
         """Make a sample ramdisk with test data
 
@@ -290,7 +320,6 @@ def test_fit(u_boot_console):
         TODO: Almost everything:
           - hash algorithms - invalid hash/contents should be detected
           - signature algorithms - invalid sig/contents should be detected
-          - compression
           - checking that errors are detected like:
                 - image overwriting
                 - missing images
@@ -323,6 +352,7 @@ def test_fit(u_boot_console):
             'kernel_out' : kernel_out,
             'kernel_addr' : 0x40000,
             'kernel_size' : filesize(kernel),
+            'compression' : 'none',
 
             'fdt_out' : fdt_out,
             'fdt_addr' : 0x80000,
@@ -415,6 +445,33 @@ def test_fit(u_boot_console):
             check_equal(loadables2, loadables2_out,
                         'Loadables2 (ramdisk) not loaded')
 
+        # A compressed kernel whose load address overlaps the FIT is
+        # decompressed in place, after the FDT and ramdisk are moved out
+        with cons.log.section('Compressed kernel in place'):
+            params['kernel'] = make_compressed(kernel)
+            params['compression'] = 'gzip'
+            fit = make_fit(mkimage, params, external=True)
+            cons.restart_uboot()
+            output = cons.run_command_list(
+                (place_script % params).splitlines())
+            check_equal(kernel, kernel_out, 'Kernel not decompressed')
+            check_equal(control_dtb, fdt_out, 'FDT not loaded')
+            check_equal(ramdisk, ramdisk_out, 'Ramdisk not loaded')
+
+        # Without load addresses the FDT and ramdisk would be overwritten
+        with cons.log.section('Compressed kernel over FDT'):
+            params['fdt_load'] = ''
+            params['ramdisk_load'] = ''
+            fit = make_fit(mkimage, params, external=True)
+            cons.restart_uboot()
+            cons.run_command_list(['sb load hostfs 0 - %(fit)s' % params,
+                                   'bootm start ${fileaddr}'])
+
+            # bootm gives up before loading anything and resets the board
+            cons.run_command('bootm loados', wait_for_prompt=False)
+            cons.wait_for('kernel would overwrite the FDT')
+            assert cons.validate_exited()
+
     cons = u_boot_console
     try:
         # We need to use our own device tree file. Remember to restore it
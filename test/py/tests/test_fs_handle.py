@@ -0,0 +1,46 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Test the filesystem file-handle API (fs_open()/fs_pread()/fs_close()) on
+# ext4 and btrfs images. The reads themselves are checked by the C test
+# dm_test_fs_handle; this creates the images it runs on.
+
+from distutils.spawn import find_executable
+import os
+import pytest
+import u_boot_utils as util
+
+mkfs_args = {
+    'ext4': ['mkfs.ext4', '-q', '-F', '-b', '1024', '-d'],
+    'btrfs': ['mkfs.btrfs', '-q', '-f', '-r'],
+}
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('ut_dm')
+@pytest.mark.parametrize('fstype', ['ext4', 'btrfs'])
+def test_fs_handle(u_boot_console, fstype):
+    """Run dm_test_fs_handle on a freshly created filesystem image."""
+
+    cons = u_boot_console
+    args = mkfs_args[fstype]
+    if not find_executable(args[0]):
+        pytest.skip('%s not available' % args[0])
+
+    tmpdir = cons.config.result_dir + '/fs_handle'
+    rootdir = tmpdir + '/root'
+    image = tmpdir + '/%s.img' % fstype
+    if not os.path.exists(rootdir):
+        os.makedirs(rootdir)
+
+    # Several blocks, not a multiple of the block size, no repeating pattern
+    with open(rootdir + '/handle.bin', 'wb') as fh:
+        fh.write(bytearray((i * 7 + (i >> 8)) & 0xff for i in range(0x4321)))
+
+    # btrfs needs at least about 110MB, so use a sparse file
+    with open(image, 'wb') as fh:
+        fh.truncate(128 << 20)
+    util.run_and_log(cons, args + [rootdir, image])
+
+    cons.run_command('setenv fs_handle_image %s' % image)
+    output = cons.run_command('ut dm fs_handle')
+    cons.run_command('setenv fs_handle_image')
+    assert output.endswith('Failures: 0')
@@ -0,0 +1,22 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Test the 'malloc stats' command
+
+import pytest
+
+@pytest.mark.buildconfigspec('cmd_malloc')
+def test_malloc_stats(u_boot_console):
+    """Test that 'malloc stats' shows the pool usage and size classes."""
+
+    response = u_boot_console.run_command('malloc stats')
+    for field in ('pool:', 'in use:', 'peak:', 'free:', 'cached:'):
+        assert field in response
+    assert '<= 16 ' in response
+    assert 'fragmented' in response
+
+@pytest.mark.buildconfigspec('cmd_malloc')
+def test_malloc_usage(u_boot_console):
+    """Test that the usage is shown when no subcommand is given."""
+
+    response = u_boot_console.run_command('malloc')
+    assert 'malloc stats' in response
@@ -27,6 +27,7 @@ PROP_IGNORE_LIST = [
     'linux,phandle',
     "status",
     'phandle',
+    'u-boot,dm-platdata',
     'u-boot,dm-pre-reloc',
     'u-boot,dm-tpl',
     'u-boot,dm-spl',
@@ -137,14 +138,17 @@ class DtbPlatdata(object):
         _dtb_fname: Filename of the input device tree binary file
         _valid_nodes: A list of Node object with compatible strings
         _include_disabled: true to include nodes marked status = "disabled"
+        _selected: true to only include nodes with a "u-boot,dm-platdata"
+            property
         _outfile: The current output file (sys.stdout or a real file)
         _lines: Stashed list of output lines for outputting in the future
     """
-    def __init__(self, dtb_fname, include_disabled):
+    def __init__(self, dtb_fname, include_disabled, selected=False):
         self._fdt = None
         self._dtb_fname = dtb_fname
         self._valid_nodes = None
         self._include_disabled = include_disabled
+        self._selected = selected
         self._outfile = None
         self._lines = []
         self._aliases = {}
@@ -253,7 +257,9 @@ class DtbPlatdata(object):
             root: Root node for scan
         """
         for node in root.subnodes:
-            if 'compatible' in node.props:
+            if self._selected and 'u-boot,dm-platdata' not in node.props:
+                pass    # Only nodes marked for U-Boot proper are wanted
+            elif 'compatible' in node.props:
                 status = node.props.get('status')
                 if (not self._include_disabled and not status or
                         status.value != 'disabled'):
@@ -408,6 +414,12 @@ class DtbPlatdata(object):
                         phandle_cell = prop.value[pos]
                         phandle = fdt_util.fdt32_to_cpu(phandle_cell)
                         target_node = self._fdt.phandle_to_node[phandle]
+                        if (self._selected and
+                                target_node not in self._valid_nodes):
+                            raise ValueError("Node '%s' uses phandle to "
+                                             "node '%s' which is not "
+                                             "selected" % (node.name,
+                                                           target_node.name))
                         node.phandles.add(target_node)
                         pos += 1 + args
 
@@ -541,7 +553,7 @@ class DtbPlatdata(object):
             nodes_to_output.remove(node)
 
 
-def run_steps(args, dtb_file, include_disabled, output):
+def run_steps(args, dtb_file, include_disabled, output, selected=False):
     """Run all the steps of the dtoc tool
 
     Args:
@@ -549,11 +561,13 @@ def run_steps(args, dtb_file, include_disabled, output):
         dtb_file: Filename of dtb file to process
         include_disabled: True to include disabled nodes
         output: Name of output file
+        selected: True to only include nodes with a "u-boot,dm-platdata"
+            property
     """
     if not args:
         raise ValueError('Please specify a command: struct, platdata')
 
-    plat = DtbPlatdata(dtb_file, include_disabled)
+    plat = DtbPlatdata(dtb_file, include_disabled, selected)
     plat.scan_dtb()
     plat.scan_tree()
     plat.scan_reg_sizes()
@@ -21,8 +21,10 @@ Dtoc produces two output files:
 
 This tool is used in U-Boot to provide device tree data to SPL without
 increasing the code size of SPL. This supports the CONFIG_SPL_OF_PLATDATA
-options. For more information about the use of this options and tool please
-see doc/driver-model/of-plat.txt
+options. With -s it only converts nodes marked with 'u-boot,dm-platdata',
+which supports CONFIG_OF_PLATDATA_NODES in U-Boot proper. For more
+information about the use of this options and tool please see
+doc/driver-model/of-plat.txt
 """
 
 from optparse import OptionParser
@@ -62,6 +64,8 @@ parser.add_option('--include-disabled', action='store_true',
                   help='Include disabled nodes')
 parser.add_option('-o', '--output', action='store', default='-',
                   help='Select output filename')
+parser.add_option('-s', '--selected', action='store_true',
+                  help='Only include nodes with a u-boot,dm-platdata property')
 parser.add_option('-t', '--test', action='store_true', dest='test',
                   default=False, help='run tests')
 (options, args) = parser.parse_args()
@@ -72,4 +76,4 @@ if options.test:
 
 else:
     dtb_platdata.run_steps(args, options.dtb_file, options.include_disabled,
-                           options.output)
+                           options.output, options.selected)
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Write a packed live tree for a device tree blob, so that U-Boot can set up
+ * its live tree without parsing the flat tree. See CONFIG_OF_LIVE_PACK.
+ *
+ * Usage: of_live_pack <input.dtb> <output.pack>
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "fdt_host.h"
+#include <of_live.h>
+
+static void *read_file(const char *fname, long *sizep)
+{
+	struct stat st;
+	void *buf;
+	FILE *f;
+
+	f = fopen(fname, "rb");
+	if (!f || fstat(fileno(f), &st))
+		goto err;
+	buf = malloc(st.st_size);
+	if (!buf || fread(buf, 1, st.st_size, f) != st.st_size)
+		goto err;
+	fclose(f);
+	*sizep = st.st_size;
+
+	return buf;
+err:
+	fprintf(stderr, "Cannot read '%s': %s\n", fname, strerror(errno));
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	void *fdt, *pack;
+	long fdt_size;
+	int size;
+	FILE *f;
+
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <input.dtb> <output.pack>\n",
+			argv[0]);
+		return 1;
+	}
+	fdt = read_file(argv[1], &fdt_size);
+	if (!fdt)
+		return 1;
+	if (fdt_size < sizeof(struct fdt_header) ||
+	    fdt_totalsize(fdt) > fdt_size) {
+		fprintf(stderr, "'%s' is truncated\n", argv[1]);
+		return 1;
+	}
+
+	size = of_live_pack_fdt(fdt, NULL, 0);
+	pack = size < 0 ? NULL : malloc(size);
+	if (pack)
+		size = of_live_pack_fdt(fdt, pack, size);
+	if (size < 0) {
+		fprintf(stderr, "Cannot pack '%s': %s\n", argv[1],
+			fdt_strerror(size));
+		return 1;
+	}
+
+	f = fopen(argv[2], "wb");
+	if (!f || fwrite(pack, 1, size, f) != size || fclose(f)) {
+		fprintf(stderr, "Cannot write '%s': %s\n", argv[2],
+			strerror(errno));
+		return 1;
+	}
+
+	return 0;
+}